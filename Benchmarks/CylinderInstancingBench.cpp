@@ -0,0 +1,115 @@
+// Loads a 3D bar chart of 100k cylinders and compares the instanced path, which keeps one placement per cylinder
+// next to the shared template meshes, with meshing every cylinder on its own from the same template.
+
+#include <iostream>
+#include <memory>
+
+#include "Timing.h"
+#include "V3dWriter.h"
+#include "../V3dFile/V3dFile.h"
+#include "../Rendering/TemplateMeshes.h"
+
+namespace {
+
+constexpr int BARS_PER_SIDE = 317;
+
+V3dWriter barChart() {
+    V3dWriter file;
+    file.header(TRIPLE{ 0.0f, 0.0f, 0.0f }, TRIPLE{ float(BARS_PER_SIDE), float(BARS_PER_SIDE), 10.0f }, 1920, 1080);
+    file.material();
+
+    for (int j = 0; j < BARS_PER_SIDE; ++j) {
+        for (int i = 0; i < BARS_PER_SIDE; ++i) {
+            float height = 1.0f + float((i * 7 + j * 13) % 90) / 10.0f;
+            file.cylinder(TRIPLE{ i + 0.5f, j + 0.5f, 0.0f }, 0.4f, height, 0.0f, 0.0f);
+        }
+    }
+
+    return file;
+}
+
+struct Mesh {
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+
+    size_t bytes() const { return vertices.size() * sizeof(float) + indices.size() * sizeof(unsigned int); }
+};
+
+// What a loader without instancing would do, every cylinder gets its own copy of the template moved into place
+Mesh meshEveryCylinder(const std::vector<PrimitiveInstance>& instances, const TemplateMeshes& templates, const TemplateLod& lod) {
+    unsigned int lodVertexCount = 0;
+    for (uint32_t i = 0; i < lod.indexCount; ++i) {
+        lodVertexCount = std::max(lodVertexCount, templates.indices[lod.firstIndex + i] + 1);
+    }
+
+    const float* source = &templates.vertices[6 * size_t(lod.vertexOffset)];
+
+    Mesh mesh;
+    mesh.vertices.reserve(6 * size_t(lodVertexCount) * instances.size());
+    mesh.indices.reserve(size_t(lod.indexCount) * instances.size());
+
+    for (const PrimitiveInstance& instance : instances) {
+        unsigned int base = static_cast<unsigned int>(mesh.vertices.size() / 6);
+        const auto& m = instance.transform;
+
+        // Columns of a rotation times a scale, dividing each by its squared length gives the inverse transpose for normals
+        TRIPLE columns[3];
+        for (int k = 0; k < 3; ++k) {
+            columns[k] = TRIPLE{ m[0][k], m[1][k], m[2][k] };
+            columns[k] /= glm::dot(columns[k], columns[k]);
+        }
+
+        for (unsigned int v = 0; v < lodVertexCount; ++v) {
+            const float* p = source + 6 * v;
+            const float* n = p + 3;
+
+            TRIPLE normal = glm::normalize(n[0] * columns[0] + n[1] * columns[1] + n[2] * columns[2]);
+
+            for (int row = 0; row < 3; ++row) {
+                mesh.vertices.push_back(m[row][0] * p[0] + m[row][1] * p[1] + m[row][2] * p[2] + m[row][3]);
+            }
+            mesh.vertices.insert(mesh.vertices.end(), { normal.x, normal.y, normal.z });
+        }
+
+        for (uint32_t i = 0; i < lod.indexCount; ++i) {
+            mesh.indices.push_back(base + templates.indices[lod.firstIndex + i]);
+        }
+    }
+
+    return mesh;
+}
+
+}
+
+int main() {
+    V3dWriter file = barChart();
+    TemplateMeshes templates = buildTemplateMeshes();
+
+    std::unique_ptr<V3dFile> v3d;
+    double loadSeconds = medianSeconds(3, [&]() {
+        v3d = std::make_unique<V3dFile>(file.bytes().data(), file.bytes().size());
+    });
+
+    const std::vector<PrimitiveInstance>& cylinders = v3d->instances[CYLINDER_TEMPLATE];
+    size_t templateBytes = templates.vertices.size() * sizeof(float) + templates.indices.size() * sizeof(unsigned int);
+    size_t instanceBytes = cylinders.size() * sizeof(PrimitiveInstance);
+
+    std::cout << "Bar chart of " << cylinders.size() << " cylinders" << std::endl;
+    std::cout << "  instanced: load " << 1000.0 * loadSeconds << " ms, " << (instanceBytes + templateBytes) / 1e6 << " MB ("
+              << sizeof(PrimitiveInstance) << " bytes per cylinder and " << templateBytes / 1e3 << " kB of templates)" << std::endl;
+
+    for (uint32_t level : { 0u, TEMPLATE_LOD_COUNT - 1 }) {
+        const TemplateLod& lod = templates.lods[CYLINDER_TEMPLATE][level];
+
+        Mesh mesh;
+        double meshSeconds = medianSeconds(3, [&]() {
+            mesh = meshEveryCylinder(cylinders, templates, lod);
+        });
+
+        std::cout << "  meshed per cylinder at level of detail " << level << ": load " << 1000.0 * (loadSeconds + meshSeconds)
+                  << " ms, " << mesh.bytes() / 1e6 << " MB (" << mesh.bytes() / cylinders.size() << " bytes per cylinder, "
+                  << lod.indexCount / 3 << " triangles each)" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+// Loads scenes shaped like typical Asymptote output and reports how much index memory splitIndices16 saves on their
+// triangles and lines, how many draws the chunks cost and how long the split takes.
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include "Timing.h"
+#include "V3dWriter.h"
+#include "../V3dFile/V3dFile.h"
+#include "../Rendering/IndexChunks.h"
+
+namespace {
+
+float height(float x, float y) {
+    return 0.3f * std::sin(6.0f * x) * std::cos(5.0f * y);
+}
+
+// graph3 of a function: a sheet of patches with grid lines along both axes, plus the three axes
+V3dWriter surfaceGraph(int patchesPerSide) {
+    V3dWriter file;
+    file.header(TRIPLE{ 0.0f, 0.0f, -0.3f }, TRIPLE{ 1.0f, 1.0f, 0.3f }, 800, 600);
+    file.material();
+
+    for (int pj = 0; pj < patchesPerSide; ++pj) {
+        for (int pi = 0; pi < patchesPerSide; ++pi) {
+            TRIPLE controlPoints[16];
+            for (int k = 0; k < 16; ++k) {
+                float x = (pi + (k % 4) / 3.0f) / patchesPerSide;
+                float y = (pj + (k / 4) / 3.0f) / patchesPerSide;
+                controlPoints[k] = TRIPLE{ x, y, height(x, y) };
+            }
+            file.bezierPatch(controlPoints);
+
+            // Grid lines along the lower and left edges of the patch
+            TRIPLE along[4] = { controlPoints[0], controlPoints[1], controlPoints[2], controlPoints[3] };
+            TRIPLE across[4] = { controlPoints[0], controlPoints[4], controlPoints[8], controlPoints[12] };
+            file.bezierCurve(along);
+            file.bezierCurve(across);
+        }
+    }
+
+    for (TRIPLE axis : { TRIPLE{ 1.0f, 0.0f, 0.0f }, TRIPLE{ 0.0f, 1.0f, 0.0f }, TRIPLE{ 0.0f, 0.0f, 0.3f } }) {
+        TRIPLE controlPoints[4] = { TRIPLE{ 0.0f }, axis / 3.0f, 2.0f * axis / 3.0f, axis };
+        file.bezierCurve(controlPoints);
+    }
+
+    return file;
+}
+
+// Imported mesh as one triangle group, its triangles in grid order or shuffled like an arbitrary exporter leaves them
+V3dWriter triangleMesh(int grid, bool shuffle) {
+    std::vector<TRIPLE> positions;
+    std::vector<TRIPLE> normals;
+    std::vector<uint32_t> indices;
+
+    for (int j = 0; j <= grid; ++j) {
+        for (int i = 0; i <= grid; ++i) {
+            float x = float(i) / grid;
+            float y = float(j) / grid;
+            positions.push_back(TRIPLE{ x, y, height(x, y) });
+            normals.push_back(TRIPLE{ 0.0f, 0.0f, 1.0f });
+        }
+    }
+
+    for (int j = 0; j < grid; ++j) {
+        for (int i = 0; i < grid; ++i) {
+            uint32_t v = static_cast<uint32_t>(j * (grid + 1) + i);
+            indices.insert(indices.end(), { v, v + 1, v + grid + 2, v, v + grid + 2, v + grid + 1 });
+        }
+    }
+
+    if (shuffle) {
+        std::mt19937 random{ 1 };
+        for (size_t t = indices.size() / 3 - 1; t > 0; --t) {
+            size_t other = std::uniform_int_distribution<size_t>{ 0, t }(random);
+            std::swap_ranges(&indices[3 * t], &indices[3 * t] + 3, &indices[3 * other]);
+        }
+    }
+
+    V3dWriter file;
+    file.header(TRIPLE{ 0.0f, 0.0f, -0.3f }, TRIPLE{ 1.0f, 1.0f, 0.3f }, 800, 600);
+    file.material();
+    file.triangleGroup(positions, normals, indices);
+    return file;
+}
+
+void reportIndices(const char* kind, const std::vector<unsigned int>& indices, uint32_t primitiveSize) {
+    if (indices.empty()) {
+        return;
+    }
+
+    SplitIndices split;
+    bool fits = false;
+    double seconds = medianSeconds(5, [&]() {
+        fits = splitIndices16(indices, primitiveSize, split);
+    });
+
+    size_t bytes32 = indices.size() * sizeof(unsigned int);
+
+    std::cout << "    " << kind << ": " << indices.size() << " indices, " << bytes32 / 1e3 << " kB as 32 bit, ";
+    if (fits) {
+        size_t bytes16 = split.indices.size() * sizeof(uint16_t);
+        std::cout << bytes16 / 1e3 << " kB as 16 bit in " << split.chunks.size() << " draws, "
+                  << 100.0 * (bytes32 - bytes16) / bytes32 << "% saved, split in " << 1000.0 * seconds << " ms" << std::endl;
+    } else {
+        std::cout << "stays 32 bit" << std::endl;
+    }
+}
+
+void report(const char* name, const V3dWriter& file, bool optimizeMeshes) {
+    V3dLoadOptions options;
+    options.optimizeMeshes = optimizeMeshes;
+
+    V3dFile v3d{ file.bytes().data(), file.bytes().size(), options };
+
+    std::cout << "  " << name << ", " << v3d.mesh->vertexCount() << " vertices" << std::endl;
+    reportIndices("triangles", v3d.mesh->indices, 3);
+    reportIndices("lines", v3d.lineIndices, 2);
+}
+
+}
+
+int main() {
+    std::cout << "16 bit index savings" << std::endl;
+
+    report("surface graph, 20x20 patches", surfaceGraph(20), false);
+    report("surface graph, 100x100 patches", surfaceGraph(100), false);
+    report("triangle mesh, 1M triangles in grid order", triangleMesh(708, false), false);
+    report("triangle mesh, 1M triangles shuffled", triangleMesh(708, true), false);
+
+    // The viewer loads with optimizeMeshes
+    report("surface graph, 100x100 patches, optimized", surfaceGraph(100), true);
+    report("triangle mesh, 1M triangles in grid order, optimized", triangleMesh(708, false), true);
+    report("triangle mesh, 1M triangles shuffled, optimized", triangleMesh(708, true), true);
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+// Runs optimizeMesh over meshes in the orders they reach it from the loader and reports the average cache miss
+// ratio before and after, along with the time the pass takes as the meshes grow.
+
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include "Timing.h"
+#include "../V3dFile/MeshOptimizer.h"
+#include "../Utility/ThreadPool.h"
+
+namespace {
+
+// Wavy height field of 2 * grid * grid triangles, emitted row by row like a regular grid from a file
+MeshBuffer heightField(int grid) {
+    MeshBuffer mesh;
+
+    for (int j = 0; j <= grid; ++j) {
+        for (int i = 0; i <= grid; ++i) {
+            float x = float(i) / grid;
+            float y = float(j) / grid;
+            mesh.vertices.insert(mesh.vertices.end(), { x, y, 0.05f * std::sin(20.0f * x) * std::cos(17.0f * y), 0.0f, 0.0f, 1.0f });
+        }
+    }
+
+    for (int j = 0; j < grid; ++j) {
+        for (int i = 0; i < grid; ++i) {
+            unsigned int v = static_cast<unsigned int>(j * (grid + 1) + i);
+            mesh.indices.insert(mesh.indices.end(), { v, v + 1, v + grid + 2, v, v + grid + 2, v + grid + 1 });
+        }
+    }
+
+    return mesh;
+}
+
+// Same triangles in random order, what a welded triangle group from an arbitrary exporter looks like
+MeshBuffer shuffled(MeshBuffer mesh) {
+    size_t triangleCount = mesh.indices.size() / 3;
+    std::mt19937 random{ 1 };
+
+    for (size_t t = triangleCount - 1; t > 0; --t) {
+        size_t other = std::uniform_int_distribution<size_t>{ 0, t }(random);
+        std::swap_ranges(&mesh.indices[3 * t], &mesh.indices[3 * t] + 3, &mesh.indices[3 * other]);
+    }
+
+    return mesh;
+}
+
+// Surface of many small bicubic patches, each meshed on its own grid by the tessellator
+MeshBuffer bezierSurface(int patchesPerSide) {
+    std::vector<BezierPatchDescriptor> patches;
+
+    for (int pj = 0; pj < patchesPerSide; ++pj) {
+        for (int pi = 0; pi < patchesPerSide; ++pi) {
+            BezierPatchDescriptor patch{ };
+            patch.tolerance = 0.00002f;
+
+            for (int j = 0; j < 4; ++j) {
+                for (int i = 0; i < 4; ++i) {
+                    float x = (pi + i / 3.0f) / patchesPerSide;
+                    float y = (pj + j / 3.0f) / patchesPerSide;
+                    patch.controlPoints[4 * j + i] = TRIPLE{ x, y, 0.05f * std::sin(20.0f * x) * std::cos(17.0f * y) };
+                }
+            }
+
+            patches.push_back(patch);
+        }
+    }
+
+    MeshBuffer mesh;
+    tessellateBezierPatches(patches, ThreadPool::shared(), mesh);
+    return mesh;
+}
+
+void report(const char* name, const MeshBuffer& source) {
+    size_t triangleCount = source.indices.size() / 3;
+    std::cout << "  " << name << ", " << triangleCount << " triangles" << std::endl;
+
+    // Each cache size against an order tuned for that size
+    for (unsigned int cacheSize : { 16u, 32u }) {
+        MeshOptimizeOptions options;
+        options.cacheSize = cacheSize;
+
+        MeshBuffer optimized;
+        double seconds = medianSeconds(3, [&]() {
+            optimized = source;
+            optimizeMesh(optimized, 0, 0, options);
+        });
+
+        float before = averageCacheMissRatio(source.indices, cacheSize);
+        float after = averageCacheMissRatio(optimized.indices, cacheSize);
+        std::cout << "    cache of " << cacheSize << ": ACMR " << before << " -> " << after << ", " << before / after
+                  << "x fewer vertex shader runs, " << 1000.0 * seconds << " ms, " << triangleCount / seconds / 1e6
+                  << " M triangles/s" << std::endl;
+    }
+}
+
+}
+
+int main() {
+    std::cout << "optimizeMesh, sorted for overdraw" << std::endl;
+
+    report("Bezier patches", bezierSurface(20));
+    report("grid in row order", heightField(708));
+
+    for (int grid : { 354, 708, 1416 }) {
+        report("grid in random order", shuffled(heightField(grid)));
+    }
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+// Loads files of a growing number of Bezier patches and reports the vertices and load time per patch, which stay flat
+// as long as every patch emits only its own geometry. Then loads two files on separate threads at once and checks they
+// mesh the same as when loaded alone.
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "Timing.h"
+#include "V3dWriter.h"
+#include "../V3dFile/V3dFile.h"
+
+namespace {
+
+// Copies of one bumped patch over the unit square stacked a little apart, so every patch meshes to the same grid
+// whatever the count
+V3dWriter patchFile(int patchCount) {
+    V3dWriter file;
+    file.header(TRIPLE{ 0.0f, 0.0f, -0.1f }, TRIPLE{ 1.0f, 1.0f, 0.2f }, 1920, 1080);
+    file.material();
+
+    for (int p = 0; p < patchCount; ++p) {
+        TRIPLE controlPoints[16];
+
+        for (int k = 0; k < 16; ++k) {
+            float x = (k % 4) / 3.0f;
+            float y = (k / 4) / 3.0f;
+            float bump = (k == 5 || k == 6 || k == 9 || k == 10) ? 0.1f : 0.0f;
+            controlPoints[k] = TRIPLE{ x, y, bump + 1e-6f * p };
+        }
+
+        file.bezierPatch(controlPoints);
+    }
+
+    return file;
+}
+
+}
+
+int main() {
+    std::cout << "V3dFile load against the number of Bezier patches" << std::endl;
+
+    for (int patchCount : { 1000, 4000, 16000, 64000 }) {
+        V3dWriter file = patchFile(patchCount);
+
+        size_t vertexCount = 0;
+        double seconds = medianSeconds(3, [&]() {
+            V3dFile v3d{ file.bytes().data(), file.bytes().size() };
+            vertexCount = v3d.mesh->vertexCount();
+        });
+
+        std::cout << "  " << patchCount << " patches: " << vertexCount << " vertices, " << double(vertexCount) / patchCount
+                  << " per patch, " << 1000.0 * seconds << " ms, " << 1e6 * seconds / patchCount << " us per patch" << std::endl;
+    }
+
+    V3dWriter first = patchFile(4000);
+    V3dWriter second = patchFile(6000);
+
+    V3dFile firstAlone{ first.bytes().data(), first.bytes().size() };
+    V3dFile secondAlone{ second.bytes().data(), second.bytes().size() };
+
+    std::unique_ptr<V3dFile> firstTogether;
+    std::unique_ptr<V3dFile> secondTogether;
+
+    std::thread thread{ [&]() { firstTogether = std::make_unique<V3dFile>(first.bytes().data(), first.bytes().size()); } };
+    secondTogether = std::make_unique<V3dFile>(second.bytes().data(), second.bytes().size());
+    thread.join();
+
+    auto sameMesh = [](const V3dFile& a, const V3dFile& b) {
+        return a.mesh->vertices == b.mesh->vertices && a.mesh->indices == b.mesh->indices;
+    };
+    bool same = sameMesh(*firstTogether, firstAlone) && sameMesh(*secondTogether, secondAlone);
+
+    std::cout << "  two files loaded on two threads at once: " << (same ? "same meshes as loaded alone" : "meshes differ") << std::endl;
+
+    if (!same) {
+        std::cout << "ERROR: loading on two threads changed the meshes" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
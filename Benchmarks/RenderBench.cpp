@@ -0,0 +1,165 @@
+// Renders a grid mesh rotating like an arcball drag and reports frames per second, for render() that waits for every
+// frame and for the submitFrame/readFrame pair the viewer uses while dragging. Needs a Vulkan device, lavapipe will do.
+// Then renders the large grid with its triangles shuffled, as an arbitrary exporter writes them, before and after
+// optimizeMesh, which is what V3dLoadOptions::optimizeMeshes runs at load.
+//
+// Built with -DBASELINE_RENDERER against the renderer of the baseline commit, which rebuilt the pipeline and uploaded
+// the mesh on every frame, it reports the render() rate of that renderer for comparison.
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../Rendering/renderheadless.h"
+
+#ifndef BASELINE_RENDERER
+#include "../V3dFile/MeshOptimizer.h"
+#endif
+
+namespace {
+
+#ifdef BASELINE_RENDERER
+// The baseline commit has no MeshOptimizer
+struct MeshBuffer {
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+};
+#endif
+
+constexpr int WIDTH = 1024;
+constexpr int HEIGHT = 768;
+constexpr int FRAMES = 120;
+
+// A bumped sheet over the unit square, 2 * quadsPerSide^2 triangles
+MeshBuffer grid(int quadsPerSide) {
+    MeshBuffer mesh;
+
+    for (int j = 0; j <= quadsPerSide; ++j) {
+        for (int i = 0; i <= quadsPerSide; ++i) {
+            float x = float(i) / quadsPerSide;
+            float y = float(j) / quadsPerSide;
+            float z = 0.1f * std::sin(6.0f * x) * std::cos(5.0f * y);
+            mesh.vertices.insert(mesh.vertices.end(), { x - 0.5f, y - 0.5f, z, 0.0f, 0.0f, 1.0f });
+        }
+    }
+
+    for (int j = 0; j < quadsPerSide; ++j) {
+        for (int i = 0; i < quadsPerSide; ++i) {
+            unsigned int v = static_cast<unsigned int>(j * (quadsPerSide + 1) + i);
+            mesh.indices.insert(mesh.indices.end(), { v, v + 1, v + quadsPerSide + 2, v, v + quadsPerSide + 2, v + quadsPerSide + 1 });
+        }
+    }
+
+    return mesh;
+}
+
+#ifndef BASELINE_RENDERER
+// Same triangles in random order
+MeshBuffer shuffled(MeshBuffer mesh) {
+    size_t triangleCount = mesh.indices.size() / 3;
+    std::mt19937 random{ 1 };
+
+    for (size_t t = triangleCount - 1; t > 0; --t) {
+        size_t other = std::uniform_int_distribution<size_t>{ 0, t }(random);
+        std::swap_ranges(&mesh.indices[3 * t], &mesh.indices[3 * t] + 3, &mesh.indices[3 * other]);
+    }
+
+    return mesh;
+}
+#endif
+
+// The sheet turned a little further every frame, as during a drag
+glm::mat4 frameMvp(int frame) {
+    glm::mat4 projection = glm::orthoRH_ZO(-1.0f, 1.0f, -0.75f, 0.75f, -2.0f, 2.0f);
+    glm::mat4 tilt = glm::rotate(glm::mat4(1.0f), 0.6f, glm::vec3(1.0f, 0.0f, 0.0f));
+    return projection * tilt * glm::rotate(glm::mat4(1.0f), 0.02f * frame, glm::vec3(0.0f, 0.0f, 1.0f));
+}
+
+template<typename Function>
+double framesPerSecond(Function&& renderFrame) {
+    // The first frames pay for lazy allocations and are left out
+    for (int frame = 0; frame < 3; ++frame) {
+        renderFrame(frame);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        renderFrame(frame);
+    }
+    return FRAMES / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+#ifndef BASELINE_RENDERER
+// Frames per second of render() and of submitFrame/readFrame one frame behind
+std::pair<double, double> renderRates(HeadlessRenderer& renderer, const MeshBuffer& mesh) {
+    GeometryHandle geometry = renderer.uploadGeometry(mesh.vertices, mesh.indices);
+    std::vector<unsigned char> image(size_t(WIDTH) * HEIGHT * 4);
+    float pixelSize = 1.0f / WIDTH;
+
+    double renderRate = framesPerSecond([&](int frame) {
+        renderer.render(WIDTH, HEIGHT, geometry, frameMvp(frame), pixelSize, image.data(), WIDTH * 4);
+    });
+
+    // Reads the previous frame back while the next one renders, like V3dModelManager while dragging
+    HeadlessRenderer::FrameTicket pending{};
+    bool hasPending = false;
+    double dragRate = framesPerSecond([&](int frame) {
+        HeadlessRenderer::FrameTicket ticket = renderer.submitFrame(WIDTH, HEIGHT, geometry, frameMvp(frame), pixelSize);
+        if (hasPending) {
+            renderer.readFrame(pending, image.data(), WIDTH * 4);
+        }
+        pending = ticket;
+        hasPending = true;
+    });
+    renderer.readFrame(pending, image.data(), WIDTH * 4);
+
+    return { renderRate, dragRate };
+}
+#endif
+
+}
+
+int main() {
+    HeadlessRenderer renderer{ "../shaders/" };
+
+    std::cout << "Frames per second at " << WIDTH << "x" << HEIGHT << std::endl;
+
+    for (int quadsPerSide : { 100, 708 }) {
+        MeshBuffer mesh = grid(quadsPerSide);
+        std::cout << "  " << mesh.indices.size() / 3 << " triangles" << std::endl;
+
+#ifdef BASELINE_RENDERER
+        double renderRate = framesPerSecond([&](int frame) {
+            VkSubresourceLayout layout;
+            unsigned char* pixels = renderer.render(WIDTH, HEIGHT, &layout, mesh.vertices, mesh.indices, frameMvp(frame));
+            delete[] pixels;
+        });
+
+        std::cout << "    render: " << renderRate << std::endl;
+#else
+        std::pair<double, double> rates = renderRates(renderer, mesh);
+        std::cout << "    render: " << rates.first << ", submitFrame and readFrame one frame behind: " << rates.second << std::endl;
+#endif
+    }
+
+#ifndef BASELINE_RENDERER
+    MeshBuffer unoptimized = shuffled(grid(708));
+    MeshBuffer optimized = unoptimized;
+    optimizeMesh(optimized, 0, 0);
+
+    std::cout << "  " << unoptimized.indices.size() / 3 << " triangles in random order, ACMR at 16 entries "
+              << averageCacheMissRatio(unoptimized.indices, 16) << " -> " << averageCacheMissRatio(optimized.indices, 16) << std::endl;
+
+    for (const MeshBuffer* mesh : { &unoptimized, &optimized }) {
+        std::pair<double, double> rates = renderRates(renderer, *mesh);
+        std::cout << (mesh == &optimized ? "    optimizeMesh" : "    as loaded") << ", render: " << rates.first
+                  << ", submitFrame and readFrame one frame behind: " << rates.second << std::endl;
+    }
+#endif
+
+    return 0;
+}
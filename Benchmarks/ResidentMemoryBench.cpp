@@ -0,0 +1,135 @@
+// Loads scenes with V3dLoadOptions::keepObjects on and off and reports the heap in use and the resident set the
+// loaded file adds. Every load runs in a child process of its own so the resident set starts out the same. glibc keeps
+// freed memory mapped for reuse, so the resident set is reported again after malloc_trim hands it back.
+
+#include <malloc.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+
+#include "V3dWriter.h"
+#include "../V3dFile/V3dFile.h"
+
+namespace {
+
+float height(float x, float y) {
+    return 0.3f * std::sin(6.0f * x) * std::cos(5.0f * y);
+}
+
+// graph3 of a function: a sheet of patches with grid lines along both axes
+V3dWriter surfaceGraph(int patchesPerSide) {
+    V3dWriter file;
+    file.header(TRIPLE{ 0.0f, 0.0f, -0.3f }, TRIPLE{ 1.0f, 1.0f, 0.3f }, 800, 600);
+    file.material();
+
+    for (int pj = 0; pj < patchesPerSide; ++pj) {
+        for (int pi = 0; pi < patchesPerSide; ++pi) {
+            TRIPLE controlPoints[16];
+            for (int k = 0; k < 16; ++k) {
+                float x = (pi + (k % 4) / 3.0f) / patchesPerSide;
+                float y = (pj + (k / 4) / 3.0f) / patchesPerSide;
+                controlPoints[k] = TRIPLE{ x, y, height(x, y) };
+            }
+            file.bezierPatch(controlPoints);
+
+            TRIPLE along[4] = { controlPoints[0], controlPoints[1], controlPoints[2], controlPoints[3] };
+            TRIPLE across[4] = { controlPoints[0], controlPoints[4], controlPoints[8], controlPoints[12] };
+            file.bezierCurve(along);
+            file.bezierCurve(across);
+        }
+    }
+
+    return file;
+}
+
+// Imported mesh as one triangle group
+V3dWriter triangleMesh(int grid) {
+    std::vector<TRIPLE> positions;
+    std::vector<TRIPLE> normals;
+    std::vector<uint32_t> indices;
+
+    for (int j = 0; j <= grid; ++j) {
+        for (int i = 0; i <= grid; ++i) {
+            float x = float(i) / grid;
+            float y = float(j) / grid;
+            positions.push_back(TRIPLE{ x, y, height(x, y) });
+            normals.push_back(TRIPLE{ 0.0f, 0.0f, 1.0f });
+        }
+    }
+
+    for (int j = 0; j < grid; ++j) {
+        for (int i = 0; i < grid; ++i) {
+            uint32_t v = static_cast<uint32_t>(j * (grid + 1) + i);
+            indices.insert(indices.end(), { v, v + 1, v + grid + 2, v, v + grid + 2, v + grid + 1 });
+        }
+    }
+
+    V3dWriter file;
+    file.header(TRIPLE{ 0.0f, 0.0f, -0.3f }, TRIPLE{ 1.0f, 1.0f, 0.3f }, 800, 600);
+    file.material();
+    file.triangleGroup(positions, normals, indices);
+    return file;
+}
+
+size_t heapInUse() {
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+size_t residentSet() {
+    size_t pages = 0;
+    size_t residentPages = 0;
+    std::ifstream{ "/proc/self/statm" } >> pages >> residentPages;
+    return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+void reportInChild(const char* name, const std::function<V3dWriter()>& makeFile, bool keepObjects) {
+    std::cout.flush();
+
+    pid_t child = fork();
+    if (child != 0) {
+        waitpid(child, nullptr, 0);
+        return;
+    }
+
+    V3dWriter file = makeFile();
+    malloc_trim(0);
+
+    size_t heapBefore = heapInUse();
+    size_t residentBefore = residentSet();
+
+    V3dLoadOptions options;
+    options.keepObjects = keepObjects;
+    V3dFile v3d{ file.bytes().data(), file.bytes().size(), options };
+
+    size_t heapAfter = heapInUse();
+    size_t residentAfter = residentSet();
+    malloc_trim(0);
+    size_t residentTrimmed = residentSet();
+
+    std::cout << "  " << name << (keepObjects ? ", keepObjects: " : ", objects released: ") << (heapAfter - heapBefore) / 1e6
+              << " MB heap, " << (residentAfter - residentBefore) / 1e6 << " MB resident, "
+              << (residentTrimmed - residentBefore) / 1e6 << " MB after malloc_trim (" << v3d.m_Objects.size() << " objects kept, "
+              << (v3d.mesh->vertices.size() * sizeof(float) + v3d.mesh->indices.size() * sizeof(unsigned int)) / 1e6 << " MB of mesh buffers)" << std::endl;
+
+    std::exit(0);
+}
+
+}
+
+int main() {
+    std::cout << "Memory a loaded file adds with and without its parsed objects" << std::endl;
+
+    for (bool keepObjects : { true, false }) {
+        reportInChild("surface graph, 100x100 patches", []() { return surfaceGraph(100); }, keepObjects);
+    }
+    for (bool keepObjects : { true, false }) {
+        reportInChild("triangle mesh, 1M triangles", []() { return triangleMesh(708); }, keepObjects);
+    }
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+// Builds a SceneBvh over a wavy height field of about 1M triangles and times the build and ray queries.
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+
+#include "Timing.h"
+#include "../V3dFile/SceneBvh.h"
+#include "../Utility/ThreadPool.h"
+
+namespace {
+
+// Quads per side, 2 * 708 * 708 = 1002528 triangles over the unit square
+constexpr int GRID = 708;
+
+float height(float x, float y) {
+    return 0.05f * std::sin(20.0f * x) * std::cos(17.0f * y);
+}
+
+}
+
+int main() {
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+
+    for (int j = 0; j <= GRID; ++j) {
+        for (int i = 0; i <= GRID; ++i) {
+            float x = float(i) / GRID;
+            float y = float(j) / GRID;
+            vertices.insert(vertices.end(), { x, y, height(x, y), 0.0f, 0.0f, 1.0f });
+        }
+    }
+
+    for (int j = 0; j < GRID; ++j) {
+        for (int i = 0; i < GRID; ++i) {
+            unsigned int v = static_cast<unsigned int>(j * (GRID + 1) + i);
+            indices.insert(indices.end(), { v, v + 1, v + GRID + 2, v, v + GRID + 2, v + GRID + 1 });
+        }
+    }
+
+    InstanceLists instances;
+    ThreadPool& pool = ThreadPool::shared();
+    size_t triangleCount = indices.size() / 3;
+
+    std::unique_ptr<SceneBvh> bvh;
+    double buildSeconds = medianSeconds(5, [&]() {
+        bvh = std::make_unique<SceneBvh>(vertices, indices, instances, pool);
+    });
+
+    std::cout << "SceneBvh over " << triangleCount << " triangles, " << pool.threadCount() << " threads" << std::endl;
+    std::cout << "  build " << 1000.0 * buildSeconds << " ms, " << bvh->nodeCount() << " nodes, "
+              << bvh->memoryUsage() / (1024.0 * 1024.0) << " MB" << std::endl;
+
+    // Rays cast down onto the field from random points above it, slightly tilted
+    const size_t rayCount = 1000000;
+    std::mt19937 random{ 1 };
+    std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+    std::uniform_real_distribution<float> tilt{ -0.2f, 0.2f };
+
+    std::vector<std::pair<TRIPLE, TRIPLE>> rays(rayCount);
+    for (auto& ray : rays) {
+        ray = { TRIPLE{ unit(random), unit(random), 1.0f }, TRIPLE{ tilt(random), tilt(random), -1.0f } };
+    }
+
+    size_t hits = 0;
+    double raySeconds = medianSeconds(3, [&]() {
+        hits = 0;
+        for (const auto& [origin, direction] : rays) {
+            BvhHit hit;
+            hits += bvh->intersectRay(origin, direction, 2.0f, hit) ? 1 : 0;
+        }
+    });
+
+    std::cout << "  rays " << rayCount / raySeconds / 1e6 << " M/s on one thread, " << 1e9 * raySeconds / rayCount << " ns each, "
+              << hits << " hits" << std::endl;
+
+    return 0;
+}
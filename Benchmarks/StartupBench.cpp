@@ -0,0 +1,66 @@
+// Times the first frame of a new renderer, from creating it to having the pixels, without the on-disk pipeline cache
+// and with it. Needs a Vulkan device, lavapipe will do. Run with MESA_SHADER_CACHE_DISABLE=true on Mesa drivers, or
+// their own shader cache makes the cold start warm as well.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../Rendering/renderheadless.h"
+
+namespace {
+
+constexpr int WIDTH = 1024;
+constexpr int HEIGHT = 768;
+constexpr int ROUNDS = 5;
+
+// Seconds from creating the renderer until its first frame of a small mesh is read back
+double firstFrameSeconds() {
+    std::vector<float> vertices{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+    std::vector<unsigned int> indices{ 0, 1, 2 };
+    std::vector<unsigned char> image(size_t(WIDTH) * HEIGHT * 4);
+
+    auto start = std::chrono::steady_clock::now();
+
+    HeadlessRenderer renderer{ "../shaders/" };
+    GeometryHandle geometry = renderer.uploadGeometry(vertices, indices);
+    renderer.render(WIDTH, HEIGHT, geometry, glm::mat4(1.0f), 1.0f / WIDTH, image.data(), WIDTH * 4);
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+}
+
+int main() {
+    // The first renderer loads the driver, which every later start finds loaded, and gives the cache file's path
+    std::string cachePath = std::make_unique<HeadlessRenderer>("../shaders/")->pipelineCacheFile.path();
+
+    std::vector<double> cold;
+    std::vector<double> warm;
+
+    for (int round = 0; round < ROUNDS; ++round) {
+        std::remove(cachePath.c_str());
+        cold.push_back(firstFrameSeconds());
+        warm.push_back(firstFrameSeconds());
+    }
+
+    std::cout << "First frame of a new renderer, pipeline cache " << cachePath << std::endl;
+    std::cout << "  cold: " << 1000.0 * median(cold) << " ms" << std::endl;
+    std::cout << "  warm: " << 1000.0 * median(warm) << " ms" << std::endl;
+
+    // A driver that keeps nothing in its pipeline cache leaves only the headers, and warm starts gain nothing
+    std::ifstream cacheFile{ cachePath, std::ios::binary | std::ios::ate };
+    std::cout << "  cache file: " << static_cast<long long>(cacheFile.tellg()) << " bytes" << std::endl;
+
+    return 0;
+}
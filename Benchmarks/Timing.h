@@ -0,0 +1,21 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// Median wall time in seconds of runs calls of fn, after one untimed warm up call
+template<typename Function>
+double medianSeconds(int runs, Function&& fn) {
+    fn();
+
+    std::vector<double> seconds;
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    std::sort(seconds.begin(), seconds.end());
+    return seconds[seconds.size() / 2];
+}
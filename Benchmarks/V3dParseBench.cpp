@@ -0,0 +1,168 @@
+// Compares the XDR stream path of V3dFile with the memory mapped XdrReader path, first parsing the objects alone and
+// then loading whole files, on a large triangle group in single and double precision and on many Bezier patches.
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+
+#include "Timing.h"
+#include "V3dWriter.h"
+#include "../V3dFile/V3dFile.h"
+#include "../V3dFile/XdrReader.h"
+
+namespace {
+
+// Quads per side of the triangle group, 2 * 708 * 708 = 1002528 triangles
+constexpr int GRID = 708;
+
+constexpr int PATCHES = 100000;
+
+float height(float x, float y) {
+    return 0.05f * std::sin(20.0f * x) * std::cos(17.0f * y);
+}
+
+V3dWriter triangleGroupFile(bool doublePrecision) {
+    std::vector<TRIPLE> positions;
+    std::vector<TRIPLE> normals;
+    std::vector<uint32_t> indices;
+
+    for (int j = 0; j <= GRID; ++j) {
+        for (int i = 0; i <= GRID; ++i) {
+            float x = float(i) / GRID;
+            float y = float(j) / GRID;
+            positions.push_back(TRIPLE{ x, y, height(x, y) });
+            normals.push_back(TRIPLE{ 0.0f, 0.0f, 1.0f });
+        }
+    }
+
+    for (int j = 0; j < GRID; ++j) {
+        for (int i = 0; i < GRID; ++i) {
+            uint32_t v = static_cast<uint32_t>(j * (GRID + 1) + i);
+            indices.insert(indices.end(), { v, v + 1, v + GRID + 2, v, v + GRID + 2, v + GRID + 1 });
+        }
+    }
+
+    V3dWriter file{ doublePrecision };
+    file.material();
+    file.triangleGroup(positions, normals, indices);
+    return file;
+}
+
+V3dWriter patchFile() {
+    V3dWriter file;
+    file.material();
+
+    int side = static_cast<int>(std::sqrt(float(PATCHES)));
+    for (int p = 0; p < PATCHES; ++p) {
+        TRIPLE controlPoints[16];
+        for (int k = 0; k < 16; ++k) {
+            float x = (p % side + (k % 4) / 3.0f) / side;
+            float y = (p / side + (k / 4) / 3.0f) / side;
+            controlPoints[k] = TRIPLE{ x, y, height(x, y) };
+        }
+        file.bezierPatch(controlPoints);
+    }
+
+    return file;
+}
+
+// The object loop of V3dFile::load without the meshing after it
+template<typename Reader>
+size_t parseObjects(Reader& xdrFile) {
+    UINT versionNumber;
+    V3D_BOOL doublePrecisionFlag;
+    xdrFile >> versionNumber;
+    xdrFile >> doublePrecisionFlag;
+
+    std::vector<std::unique_ptr<V3dObject>> objects;
+    size_t materialCount = 0;
+
+    UINT objectType;
+    while (xdrFile >> objectType) {
+        switch (objectType) {
+        case ObjectTypes::MATERIAL: {
+            float material[15];
+            for (float& value : material) {
+                xdrFile >> value;
+            }
+            ++materialCount;
+            break;
+        }
+
+        case ObjectTypes::TRIANGLES:
+            objects.push_back(std::make_unique<V3dTriangleGroup>(xdrFile, doublePrecisionFlag));
+            break;
+
+        case ObjectTypes::BEZIER_PATCH:
+            objects.push_back(std::make_unique<V3dBezierPatch>(xdrFile, doublePrecisionFlag));
+            break;
+
+        default:
+            std::cout << "ERROR: Unexpected object type " << objectType << std::endl;
+            return 0;
+        }
+    }
+
+    return objects.size() + materialCount;
+}
+
+void report(const char* name, const V3dWriter& file) {
+    const std::vector<unsigned char>& bytes = file.bytes();
+    double megabytes = bytes.size() / 1e6;
+
+    std::string fileName = std::string{ "/tmp/V3dParseBench_" } + std::to_string(bytes.size()) + ".v3d";
+    if (!file.save(fileName)) {
+        std::cout << "ERROR: Could not write " << fileName << std::endl;
+        return;
+    }
+
+    std::vector<char> copy(bytes.begin(), bytes.end());
+
+    size_t streamObjects = 0;
+    double streamParse = medianSeconds(3, [&]() {
+        xdr::memixstream stream{ copy.data(), copy.size() };
+        streamObjects = parseObjects(static_cast<xdr::ixstream&>(stream));
+    });
+
+    size_t readerObjects = 0;
+    double readerParse = medianSeconds(3, [&]() {
+        XdrReader reader{ bytes.data(), bytes.size() };
+        readerObjects = parseObjects(reader);
+    });
+
+    double streamLoad = medianSeconds(3, [&]() {
+        xdr::memixstream stream{ copy.data(), copy.size() };
+        V3dFile v3d{ stream };
+    });
+
+    double mappedLoad = medianSeconds(3, [&]() {
+        V3dFile v3d{ fileName };
+    });
+
+    V3dFile v3d{ fileName };
+    std::remove(fileName.c_str());
+
+    std::cout << "  " << name << ", " << megabytes << " MB, " << readerObjects << " objects, "
+              << v3d.mesh->indices.size() / 3 << " triangles meshed" << std::endl;
+    std::cout << "    parse only: memixstream " << megabytes / streamParse << " MB/s, XdrReader " << megabytes / readerParse
+              << " MB/s, " << streamParse / readerParse << "x" << std::endl;
+    std::cout << "    whole load: memixstream " << 1000.0 * streamLoad << " ms, mapped file " << 1000.0 * mappedLoad
+              << " ms, " << streamLoad / mappedLoad << "x" << std::endl;
+
+    if (streamObjects != readerObjects) {
+        std::cout << "ERROR: the stream parsed " << streamObjects << " objects" << std::endl;
+    }
+}
+
+}
+
+int main() {
+    std::cout << "V3dFile parsing, stream path against memory mapped path" << std::endl;
+
+    report("triangle group, single precision", triangleGroupFile(false));
+    report("triangle group, double precision", triangleGroupFile(true));
+    report("Bezier patches, single precision", patchFile());
+
+    return 0;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../V3dFile/V3dObjects.h"
+#include "../V3dFile/V3dHeaderInfo.h"
+
+// Writes synthetic v3d files in big-endian XDR, the way Asymptote lays them out, for the benchmarks to load
+class V3dWriter {
+public:
+    V3dWriter(bool doublePrecision = false)
+        : m_DoublePrecision{ doublePrecision } {
+        word(1);
+        word(doublePrecision ? 1 : 0);
+    }
+
+    const std::vector<unsigned char>& bytes() const { return m_Bytes; }
+
+    bool save(const std::string& fileName) const {
+        std::ofstream file{ fileName, std::ios::binary };
+        file.write(reinterpret_cast<const char*>(m_Bytes.data()), static_cast<std::streamsize>(m_Bytes.size()));
+        return static_cast<bool>(file);
+    }
+
+    // Scene bounds on a canvas of the given size, which sets the view the surfaces are meshed for
+    void header(const TRIPLE& minBound, const TRIPLE& maxBound, uint32_t width, uint32_t height) {
+        uint32_t realWords = m_DoublePrecision ? 2 : 1;
+
+        word(ObjectTypes::HEADER);
+        word(5);
+
+        word(CANVAS_WIDTH); word(1); word(width);
+        word(CANVAS_HEIGHT); word(1); word(height);
+        word(MIN_BOUND); word(3 * realWords); triple(minBound);
+        word(MAX_BOUND); word(3 * realWords); triple(maxBound);
+        word(ORTHOGRAPHIC); word(1); word(1);
+    }
+
+    void material() {
+        word(ObjectTypes::MATERIAL);
+        for (float value : { 0.8f, 0.5f, 0.3f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.5f, 0.5f, 0.5f, 1.0f, 0.5f, 0.0f, 0.04f }) {
+            single(value);
+        }
+    }
+
+    void bezierPatch(const TRIPLE* controlPoints) {
+        word(ObjectTypes::BEZIER_PATCH);
+        for (int i = 0; i < 16; ++i) {
+            triple(controlPoints[i]);
+        }
+        word(0);
+        word(0);
+    }
+
+    void bezierCurve(const TRIPLE* controlPoints) {
+        word(ObjectTypes::CURVE);
+        for (int i = 0; i < 4; ++i) {
+            triple(controlPoints[i]);
+        }
+        word(0);
+        word(0);
+    }
+
+    void cylinder(const TRIPLE& center, float radius, float height, float polarAngle, float azimuthalAngle) {
+        word(ObjectTypes::CYLINDER);
+        triple(center);
+        real(radius);
+        real(height);
+        word(0);
+        word(0);
+        real(polarAngle);
+        real(azimuthalAngle);
+    }
+
+    // Triangle group with separate normal indices when normalIndices is not empty, and without colors
+    void triangleGroup(const std::vector<TRIPLE>& positions, const std::vector<TRIPLE>& normals,
+                       const std::vector<uint32_t>& positionIndices, const std::vector<uint32_t>& normalIndices = { }) {
+        word(ObjectTypes::TRIANGLES);
+        word(static_cast<uint32_t>(positionIndices.size() / 3));
+
+        word(static_cast<uint32_t>(positions.size()));
+        for (const TRIPLE& position : positions) {
+            triple(position);
+        }
+
+        word(static_cast<uint32_t>(normals.size()));
+        for (const TRIPLE& normal : normals) {
+            triple(normal);
+        }
+
+        bool explicitNormals = !normalIndices.empty();
+        word(explicitNormals ? 1 : 0);
+        word(0);
+
+        for (size_t i = 0; i < positionIndices.size(); i += 3) {
+            for (size_t k = 0; k < 3; ++k) {
+                word(positionIndices[i + k]);
+            }
+            for (size_t k = 0; explicitNormals && k < 3; ++k) {
+                word(normalIndices[i + k]);
+            }
+        }
+
+        word(0);
+        word(0);
+    }
+
+private:
+    void word(uint32_t value) {
+        m_Bytes.insert(m_Bytes.end(), { uint8_t(value >> 24), uint8_t(value >> 16), uint8_t(value >> 8), uint8_t(value) });
+    }
+
+    void single(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        word(bits);
+    }
+
+    void real(float value) {
+        if (!m_DoublePrecision) {
+            single(value);
+            return;
+        }
+
+        double wide = value;
+        uint64_t bits;
+        std::memcpy(&bits, &wide, sizeof(bits));
+        word(static_cast<uint32_t>(bits >> 32));
+        word(static_cast<uint32_t>(bits));
+    }
+
+    void triple(const TRIPLE& value) {
+        real(value.x);
+        real(value.y);
+        real(value.z);
+    }
+
+    std::vector<unsigned char> m_Bytes;
+    bool m_DoublePrecision;
+};
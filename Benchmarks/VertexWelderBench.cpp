@@ -0,0 +1,126 @@
+// Welds million triangle groups with shared, per face and colored index layouts, and reports the corners welded per
+// second and the memory the welder holds at its peak next to a std::unordered_map of the same keys.
+
+#include <iostream>
+#include <unordered_map>
+
+#include "Timing.h"
+#include "../V3dFile/VertexWelder.h"
+
+namespace {
+
+// Quads per side, 2 * 708 * 708 = 1002528 triangles
+constexpr int GRID = 708;
+
+using Triples = std::vector<std::array<UINT, 3>>;
+
+struct IndexLayout {
+    const char* name;
+    Triples positions;
+    Triples normals;
+    Triples colors;
+    bool withColors;
+};
+
+Triples gridTriangles() {
+    Triples triangles;
+
+    for (int j = 0; j < GRID; ++j) {
+        for (int i = 0; i < GRID; ++i) {
+            UINT v = static_cast<UINT>(j * (GRID + 1) + i);
+            triangles.push_back({ v, v + 1, v + GRID + 2 });
+            triangles.push_back({ v, v + GRID + 2, v + GRID + 1 });
+        }
+    }
+
+    return triangles;
+}
+
+std::vector<IndexLayout> layouts() {
+    Triples positions = gridTriangles();
+
+    // One normal per triangle, as explicit normal indices of a flat shaded export
+    Triples faceNormals(positions.size());
+    for (size_t t = 0; t < faceNormals.size(); ++t) {
+        UINT n = static_cast<UINT>(t);
+        faceNormals[t] = { n, n, n };
+    }
+
+    // One color per grid cell, so the quad's two triangles share theirs
+    Triples cellColors(positions.size());
+    for (size_t t = 0; t < cellColors.size(); ++t) {
+        UINT c = static_cast<UINT>(t / 2);
+        cellColors[t] = { c, c, c };
+    }
+
+    return {
+        { "shared indices", positions, positions, positions, false },
+        { "per face normals", positions, faceNormals, positions, false },
+        { "per cell colors", positions, positions, cellColors, true },
+    };
+}
+
+struct KeyHash {
+    size_t operator()(const VertexKey& key) const {
+        return (size_t(key[0]) * 0x9E3779B97F4A7C15ull) ^ (size_t(key[1]) * 0xC2B2AE3D27D4EB4Full) ^ size_t(key[2]);
+    }
+};
+
+// The same welding with a node based map, for comparison
+size_t weldWithUnorderedMap(const IndexLayout& layout) {
+    std::unordered_map<VertexKey, unsigned int, KeyHash> map;
+    map.reserve(3 * layout.positions.size());
+
+    std::vector<unsigned int> indices;
+    indices.reserve(3 * layout.positions.size());
+
+    for (size_t i = 0; i < layout.positions.size(); ++i) {
+        for (size_t k = 0; k < 3; ++k) {
+            VertexKey key{ layout.positions[i][k], layout.normals[i][k], layout.withColors ? layout.colors[i][k] : 0 };
+            auto inserted = map.emplace(key, static_cast<unsigned int>(map.size()));
+            indices.push_back(inserted.first->second);
+        }
+    }
+
+    return map.size();
+}
+
+}
+
+int main() {
+    std::cout << "weldTriangles on " << 2 * GRID * GRID << " triangles" << std::endl;
+
+    for (const IndexLayout& layout : layouts()) {
+        size_t cornerCount = 3 * layout.positions.size();
+
+        WeldedTriangles welded;
+        double seconds = medianSeconds(3, [&]() {
+            welded = weldTriangles(layout.positions, layout.normals, layout.colors, layout.withColors);
+        });
+
+        size_t mapVertexCount = 0;
+        double mapSeconds = medianSeconds(3, [&]() {
+            mapVertexCount = weldWithUnorderedMap(layout);
+        });
+
+        // The table is the smallest power of two holding twice the corners, it lives until the output is complete
+        size_t tableSize = 16;
+        while (tableSize < 2 * cornerCount) {
+            tableSize *= 2;
+        }
+
+        size_t tableBytes = tableSize * sizeof(unsigned int);
+        size_t outputBytes = welded.vertices.size() * sizeof(VertexKey) + welded.indices.size() * sizeof(unsigned int);
+
+        std::cout << "  " << layout.name << ": " << welded.vertices.size() << " vertices, " << 1000.0 * seconds << " ms, "
+                  << cornerCount / seconds / 1e6 << " M corners/s, table and output " << (tableBytes + outputBytes) / 1e6 << " MB ("
+                  << tableBytes / 1e6 << " MB table)" << std::endl;
+        std::cout << "    unordered_map: " << 1000.0 * mapSeconds << " ms, " << mapSeconds / seconds << "x slower" << std::endl;
+
+        if (mapVertexCount != welded.vertices.size()) {
+            std::cout << "ERROR: unordered_map found " << mapVertexCount << " vertices" << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,33 @@
+#!/bin/bash
+# Builds and runs the CPU benchmarks, GLM_INCLUDE must hold glm/glm.hpp and XSTREAM_INCLUDE Asymptote's xstream.h,
+# XDR_FLAGS is what that xstream.h needs to find and link the Sun RPC XDR functions.
+# The render benchmarks only run when VULKAN_INCLUDE holds vulkan/vulkan.h, they need the Vulkan loader and a device.
+# VULKAN_LIBS is how to link the loader.
+GLM_INCLUDE=${GLM_INCLUDE:-/usr/include}
+XSTREAM_INCLUDE=${XSTREAM_INCLUDE:-/usr/include}
+XDR_FLAGS=${XDR_FLAGS:--I/usr/include/tirpc -ltirpc}
+VULKAN_LIBS=${VULKAN_LIBS:--lvulkan}
+CXX=${CXX:-g++}
+OUT=${OUT:-/tmp/v3dBenchmarks}
+mkdir -p $OUT
+cd "$(dirname "$0")"
+
+run() {
+    name=$1; shift
+    $CXX -std=c++17 -O2 -DNDEBUG -pthread -I"$GLM_INCLUDE" "$@" -o $OUT/$name && $OUT/$name
+}
+
+run SceneBvhBench SceneBvhBench.cpp ../V3dFile/SceneBvh.cpp ../V3dFile/V3dInstances.cpp ../Utility/ThreadPool.cpp
+run MeshOptimizerBench MeshOptimizerBench.cpp ../V3dFile/MeshOptimizer.cpp ../V3dFile/BezierPatchTessellator.cpp ../V3dFile/BezierTriangleTessellator.cpp ../Utility/ThreadPool.cpp
+run V3dParseBench V3dParseBench.cpp ../V3dFile/*.cpp ../Utility/ThreadPool.cpp -I"$XSTREAM_INCLUDE" $XDR_FLAGS
+run PatchScalingBench PatchScalingBench.cpp ../V3dFile/*.cpp ../Utility/ThreadPool.cpp -I"$XSTREAM_INCLUDE" $XDR_FLAGS
+run CylinderInstancingBench CylinderInstancingBench.cpp ../Rendering/TemplateMeshes.cpp ../V3dFile/*.cpp ../Utility/ThreadPool.cpp -I"$XSTREAM_INCLUDE" $XDR_FLAGS
+run VertexWelderBench VertexWelderBench.cpp ../V3dFile/VertexWelder.cpp
+run IndexSavingsBench IndexSavingsBench.cpp ../Rendering/IndexChunks.cpp ../V3dFile/*.cpp ../Utility/ThreadPool.cpp -I"$XSTREAM_INCLUDE" $XDR_FLAGS
+run ResidentMemoryBench ResidentMemoryBench.cpp ../V3dFile/*.cpp ../Utility/ThreadPool.cpp -I"$XSTREAM_INCLUDE" $XDR_FLAGS
+
+if [ -n "$VULKAN_INCLUDE" ]; then
+    RENDERER="../Rendering/*.cpp ../3rdParty/VulkanTools/VulkanTools.cpp -I$VULKAN_INCLUDE $VULKAN_LIBS"
+    run RenderBench RenderBench.cpp ../V3dFile/MeshOptimizer.cpp $RENDERER
+    MESA_SHADER_CACHE_DISABLE=true run StartupBench StartupBench.cpp $RENDERER
+fi
@@ -0,0 +1,95 @@
+#include "CompactVertices.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+uint16_t quantizeUnorm(float value) {
+	return static_cast<uint16_t>(std::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+
+int16_t quantizeSnorm(float value) {
+	return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+float signNotZero(float value) {
+	return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+}
+
+glm::vec2 encodeOctahedral(const glm::vec3& normal) {
+	float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+
+	if (!(l1 > 0.0f)) {
+		return glm::vec2{ 0.0f, 0.0f };
+	}
+
+	glm::vec2 e{ normal.x / l1, normal.y / l1 };
+
+	// The lower hemisphere is folded over the diagonals onto the corners of the square
+	if (normal.z < 0.0f) {
+		e = glm::vec2{ (1.0f - std::abs(e.y)) * signNotZero(e.x), (1.0f - std::abs(e.x)) * signNotZero(e.y) };
+	}
+
+	return e;
+}
+
+glm::vec3 decodeOctahedral(const glm::vec2& encoded) {
+	glm::vec3 n{ encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y) };
+
+	float t = std::max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+
+	return glm::normalize(n);
+}
+
+CompactMesh compactVertices(const std::vector<float>& vertices) {
+	CompactMesh mesh;
+
+	size_t vertexCount = vertices.size() / 6;
+	if (vertexCount == 0) {
+		return mesh;
+	}
+
+	glm::vec3 minBound{ vertices[0], vertices[1], vertices[2] };
+	glm::vec3 maxBound = minBound;
+
+	for (size_t i = 0; i < vertexCount; ++i) {
+		glm::vec3 position{ vertices[6 * i], vertices[6 * i + 1], vertices[6 * i + 2] };
+		minBound = glm::min(minBound, position);
+		maxBound = glm::max(maxBound, position);
+	}
+
+	glm::vec3 extent = maxBound - minBound;
+
+	// Flat meshes have no extent along some axis, every position is then at the offset on it
+	glm::vec3 inverseExtent{
+		extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+		extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+		extent.z > 0.0f ? 1.0f / extent.z : 0.0f
+	};
+
+	mesh.positionOffset = glm::vec4{ minBound.x, minBound.y, minBound.z, 0.0f };
+	mesh.positionScale = glm::vec4{ extent.x, extent.y, extent.z, 0.0f };
+
+	mesh.vertices.resize(vertexCount);
+
+	for (size_t i = 0; i < vertexCount; ++i) {
+		const float* v = &vertices[6 * i];
+		CompactVertex& out = mesh.vertices[i];
+
+		out.position[0] = quantizeUnorm((v[0] - minBound.x) * inverseExtent.x);
+		out.position[1] = quantizeUnorm((v[1] - minBound.y) * inverseExtent.y);
+		out.position[2] = quantizeUnorm((v[2] - minBound.z) * inverseExtent.z);
+		out.position[3] = 0;
+
+		glm::vec2 normal = encodeOctahedral(glm::vec3{ v[3], v[4], v[5] });
+		out.normal[0] = quantizeSnorm(normal.x);
+		out.normal[1] = quantizeSnorm(normal.y);
+	}
+
+	return mesh;
+}
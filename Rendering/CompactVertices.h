@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// Layout of the mesh vertices uploaded to the GPU
+enum class VertexFormat {
+	Float,      // Position and normal as six floats, 24 bytes
+	Compact     // CompactVertex, 12 bytes
+};
+
+// Position quantized to 16 bits per axis within the bounds of its mesh, read as R16G16B16A16_UNORM with w unused,
+// and the unit normal octahedral-encoded into two 16 bit values, read as R16G16_SNORM
+struct CompactVertex {
+	uint16_t position[4];
+	int16_t normal[2];
+};
+
+struct CompactMesh {
+	std::vector<CompactVertex> vertices;
+
+	// A quantized position p in [0, 1] stands for offset + p * scale
+	glm::vec4 positionOffset{ 0.0f };
+	glm::vec4 positionScale{ 1.0f };
+};
+
+// Packs interleaved position and normal vertices, like V3dFile::vertices
+CompactMesh compactVertices(const std::vector<float>& vertices);
+
+// Octahedral encoding of a normal, zero normals map to +z
+glm::vec2 encodeOctahedral(const glm::vec3& normal);
+glm::vec3 decodeOctahedral(const glm::vec2& encoded);
@@ -0,0 +1,221 @@
+#include "FrameResources.h"
+
+#include <algorithm>
+
+#include "../3rdParty/VulkanTools/VulkanTools.h"
+
+void FrameResources::create(VkDevice device, VkCommandPool commandPool, uint32_t frameCount) {
+	m_Device = device;
+	m_CommandPool = commandPool;
+
+	VkCommandBufferAllocateInfo cmdBufAllocateInfo = vks::initializers::commandBufferAllocateInfo(commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
+
+	// Fences start signaled so that the first wait on an unused frame returns immediately
+	VkFenceCreateInfo fenceInfo = vks::initializers::fenceCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
+
+	m_Frames.resize(frameCount);
+
+	for (auto& frame : m_Frames) {
+		VK_CHECK_RESULT(vkAllocateCommandBuffers(m_Device, &cmdBufAllocateInfo, &frame.commandBuffer));
+		VK_CHECK_RESULT(vkCreateFence(m_Device, &fenceInfo, nullptr, &frame.fence));
+	}
+
+	VK_CHECK_RESULT(vkAllocateCommandBuffers(m_Device, &cmdBufAllocateInfo, &m_TransferCommandBuffer));
+	VK_CHECK_RESULT(vkCreateFence(m_Device, &fenceInfo, nullptr, &m_TransferFence));
+
+	VkSemaphoreCreateInfo semaphoreInfo = vks::initializers::semaphoreCreateInfo();
+	VK_CHECK_RESULT(vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &m_TransferSemaphore));
+}
+
+void FrameResources::destroy() {
+	if (m_Device == VK_NULL_HANDLE) {
+		return;
+	}
+
+	waitIdle();
+
+	for (auto& [buffer, memory] : m_PendingReleases) {
+		vkDestroyBuffer(m_Device, buffer, nullptr);
+		vkFreeMemory(m_Device, memory, nullptr);
+	}
+	m_PendingReleases.clear();
+
+	for (RetiredResource& resource : m_RetiredResources) {
+		vkDestroyBuffer(m_Device, resource.buffer, nullptr);
+		vkFreeMemory(m_Device, resource.memory, nullptr);
+	}
+	m_RetiredResources.clear();
+
+	for (auto& frame : m_Frames) {
+		vkFreeCommandBuffers(m_Device, m_CommandPool, 1, &frame.commandBuffer);
+		vkDestroyFence(m_Device, frame.fence, nullptr);
+	}
+	m_Frames.clear();
+
+	vkFreeCommandBuffers(m_Device, m_CommandPool, 1, &m_TransferCommandBuffer);
+	vkDestroyFence(m_Device, m_TransferFence, nullptr);
+	vkDestroySemaphore(m_Device, m_TransferSemaphore, nullptr);
+
+	m_Device = VK_NULL_HANDLE;
+}
+
+VkCommandBuffer FrameResources::beginFrame(uint32_t index) {
+	Frame& frame = m_Frames[index];
+
+	VK_CHECK_RESULT(vkWaitForFences(m_Device, 1, &frame.fence, VK_TRUE, UINT64_MAX));
+
+	releaseRetiredResources();
+
+	VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
+	cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	VK_CHECK_RESULT(vkBeginCommandBuffer(frame.commandBuffer, &cmdBufInfo));
+
+	return frame.commandBuffer;
+}
+
+uint64_t FrameResources::submitFrame(uint32_t index, VkQueue queue) {
+	Frame& frame = m_Frames[index];
+
+	VK_CHECK_RESULT(vkEndCommandBuffer(frame.commandBuffer));
+	VK_CHECK_RESULT(vkResetFences(m_Device, 1, &frame.fence));
+
+	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+
+	VkSubmitInfo submitInfo = vks::initializers::submitInfo();
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &frame.commandBuffer;
+
+	if (m_TransferSemaphorePending) {
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores = &m_TransferSemaphore;
+		submitInfo.pWaitDstStageMask = &waitStage;
+
+		m_TransferSemaphorePending = false;
+	}
+
+	VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, frame.fence));
+
+	frame.submission = ++m_SubmissionCount;
+
+	return frame.submission;
+}
+
+void FrameResources::waitForFrame(uint32_t index) {
+	VK_CHECK_RESULT(vkWaitForFences(m_Device, 1, &m_Frames[index].fence, VK_TRUE, UINT64_MAX));
+}
+
+void FrameResources::waitForSubmission(uint64_t submission) {
+	// A frame is only resubmitted after its fence was waited on, so any frame whose latest submission is newer 
+	// than the requested one has already finished it
+	for (auto& frame : m_Frames) {
+		if (frame.submission != 0 && frame.submission <= submission) {
+			VK_CHECK_RESULT(vkWaitForFences(m_Device, 1, &frame.fence, VK_TRUE, UINT64_MAX));
+		}
+	}
+}
+
+void FrameResources::waitIdle() {
+	for (auto& frame : m_Frames) {
+		VK_CHECK_RESULT(vkWaitForFences(m_Device, 1, &frame.fence, VK_TRUE, UINT64_MAX));
+	}
+
+	waitForTransfer();
+}
+
+VkCommandBuffer FrameResources::beginTransfer() {
+	waitForTransfer();
+
+	VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
+	cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	VK_CHECK_RESULT(vkBeginCommandBuffer(m_TransferCommandBuffer, &cmdBufInfo));
+
+	return m_TransferCommandBuffer;
+}
+
+void FrameResources::submitTransfer(VkQueue queue) {
+	VK_CHECK_RESULT(vkEndCommandBuffer(m_TransferCommandBuffer));
+	VK_CHECK_RESULT(vkResetFences(m_Device, 1, &m_TransferFence));
+
+	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+	VkSubmitInfo submitInfo = vks::initializers::submitInfo();
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &m_TransferCommandBuffer;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &m_TransferSemaphore;
+
+	// A binary semaphore cannot be signaled twice, so a transfer that was not consumed by a frame yet is chained into this one
+	if (m_TransferSemaphorePending) {
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores = &m_TransferSemaphore;
+		submitInfo.pWaitDstStageMask = &waitStage;
+	}
+
+	VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, m_TransferFence));
+
+	m_TransferSemaphorePending = true;
+	++m_TransferCount;
+
+	m_InFlightReleases.insert(m_InFlightReleases.end(), m_PendingReleases.begin(), m_PendingReleases.end());
+	m_PendingReleases.clear();
+}
+
+void FrameResources::waitForTransfer() {
+	VK_CHECK_RESULT(vkWaitForFences(m_Device, 1, &m_TransferFence, VK_TRUE, UINT64_MAX));
+
+	m_FinishedTransferCount = m_TransferCount;
+
+	releaseTransferResources();
+}
+
+void FrameResources::releaseAfterTransfer(VkBuffer buffer, VkDeviceMemory memory) {
+	m_PendingReleases.emplace_back(buffer, memory);
+}
+
+void FrameResources::releaseAfterSubmission(uint64_t submission, VkBuffer buffer, VkDeviceMemory memory) {
+	if (buffer == VK_NULL_HANDLE && memory == VK_NULL_HANDLE) {
+		return;
+	}
+
+	m_RetiredResources.push_back(RetiredResource{ buffer, memory, submission, m_TransferCount });
+}
+
+bool FrameResources::submissionFinished(uint64_t submission) const {
+	for (const auto& frame : m_Frames) {
+		if (frame.submission != 0 && frame.submission <= submission && vkGetFenceStatus(m_Device, frame.fence) != VK_SUCCESS) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void FrameResources::releaseRetiredResources() {
+	if (m_RetiredResources.empty()) {
+		return;
+	}
+
+	if (m_FinishedTransferCount < m_TransferCount && vkGetFenceStatus(m_Device, m_TransferFence) == VK_SUCCESS) {
+		m_FinishedTransferCount = m_TransferCount;
+	}
+
+	auto finished = std::partition(m_RetiredResources.begin(), m_RetiredResources.end(), [this](const RetiredResource& resource) {
+		return resource.transfer > m_FinishedTransferCount || !submissionFinished(resource.submission);
+	});
+
+	for (auto it = finished; it != m_RetiredResources.end(); ++it) {
+		vkDestroyBuffer(m_Device, it->buffer, nullptr);
+		vkFreeMemory(m_Device, it->memory, nullptr);
+	}
+
+	m_RetiredResources.erase(finished, m_RetiredResources.end());
+}
+
+void FrameResources::releaseTransferResources() {
+	for (auto& [buffer, memory] : m_InFlightReleases) {
+		vkDestroyBuffer(m_Device, buffer, nullptr);
+		vkFreeMemory(m_Device, memory, nullptr);
+	}
+
+	m_InFlightReleases.clear();
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+// Preallocated command buffers, fences and semaphores that are recycled for every submission instead of being created, 
+// leaked or waited on with a device wide idle
+class FrameResources {
+public:
+	struct Frame {
+		VkCommandBuffer commandBuffer{ VK_NULL_HANDLE };
+		VkFence fence{ VK_NULL_HANDLE };
+
+		// Number of the last submission made with this frame, 0 if it was never submitted
+		uint64_t submission{ 0 };
+	};
+
+	void create(VkDevice device, VkCommandPool commandPool, uint32_t frameCount);
+	void destroy();
+
+	uint32_t frameCount() const { return static_cast<uint32_t>(m_Frames.size()); }
+	const Frame& frame(uint32_t index) const { return m_Frames[index]; }
+
+	// Waits for the frame's previous submission and returns its command buffer, ready to be recorded
+	VkCommandBuffer beginFrame(uint32_t index);
+	// Submits the recorded frame, ordered after any transfer submitted since the previous frame, returns its submission number
+	uint64_t submitFrame(uint32_t index, VkQueue queue);
+
+	void waitForFrame(uint32_t index);
+	// Waits until every frame submission up to and including the given one has finished
+	void waitForSubmission(uint64_t submission);
+	// Waits for all frames and transfers
+	void waitIdle();
+
+	// Returns the transfer command buffer, ready to be recorded, once the previous transfer has finished
+	VkCommandBuffer beginTransfer();
+	// Submits the transfer without waiting for it, the next frame waits on it through a semaphore
+	void submitTransfer(VkQueue queue);
+	void waitForTransfer();
+
+	// Staging resources are destroyed once the transfer that reads them has finished
+	void releaseAfterTransfer(VkBuffer buffer, VkDeviceMemory memory);
+
+	// Destroys the buffer without waiting once every transfer submitted so far and every frame submission up to and
+	// including the given one has finished
+	void releaseAfterSubmission(uint64_t submission, VkBuffer buffer, VkDeviceMemory memory);
+
+private:
+	void releaseTransferResources();
+	void releaseRetiredResources();
+
+	bool submissionFinished(uint64_t submission) const;
+
+	VkDevice m_Device{ VK_NULL_HANDLE };
+	VkCommandPool m_CommandPool{ VK_NULL_HANDLE };
+
+	std::vector<Frame> m_Frames;
+	uint64_t m_SubmissionCount{ 0 };
+
+	VkCommandBuffer m_TransferCommandBuffer{ VK_NULL_HANDLE };
+	VkFence m_TransferFence{ VK_NULL_HANDLE };
+	VkSemaphore m_TransferSemaphore{ VK_NULL_HANDLE };
+
+	// The transfer semaphore has been signaled and no submission has waited on it yet
+	bool m_TransferSemaphorePending{ false };
+
+	std::vector<std::pair<VkBuffer, VkDeviceMemory>> m_PendingReleases;
+	std::vector<std::pair<VkBuffer, VkDeviceMemory>> m_InFlightReleases;
+
+	uint64_t m_TransferCount{ 0 };
+	uint64_t m_FinishedTransferCount{ 0 };
+
+	struct RetiredResource {
+		VkBuffer buffer;
+		VkDeviceMemory memory;
+		uint64_t submission;
+		uint64_t transfer;
+	};
+
+	std::vector<RetiredResource> m_RetiredResources;
+};
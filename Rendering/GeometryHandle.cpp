@@ -0,0 +1,35 @@
+#include "GeometryHandle.h"
+
+#include <utility>
+
+#include "renderheadless.h"
+
+GeometryHandle::GeometryHandle(HeadlessRenderer* renderer, uint32_t id) 
+	: m_Renderer(renderer), m_Id(id) { }
+
+GeometryHandle::GeometryHandle(GeometryHandle&& other) noexcept
+	: m_Renderer(std::exchange(other.m_Renderer, nullptr)), m_Id(std::exchange(other.m_Id, 0)) { }
+
+GeometryHandle& GeometryHandle::operator=(GeometryHandle&& other) noexcept {
+	if (this != &other) {
+		reset();
+
+		m_Renderer = std::exchange(other.m_Renderer, nullptr);
+		m_Id = std::exchange(other.m_Id, 0);
+	}
+
+	return *this;
+}
+
+GeometryHandle::~GeometryHandle() {
+	reset();
+}
+
+void GeometryHandle::reset() {
+	if (m_Renderer != nullptr) {
+		m_Renderer->freeGeometry(m_Id);
+	}
+
+	m_Renderer = nullptr;
+	m_Id = 0;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+class HeadlessRenderer;
+
+// Owning reference to a mesh that is resident in GPU memory, the mesh is freed when the handle is destroyed
+class GeometryHandle {
+public:
+	GeometryHandle() = default;
+	GeometryHandle(HeadlessRenderer* renderer, uint32_t id);
+	GeometryHandle(const GeometryHandle& other) = delete;
+	GeometryHandle(GeometryHandle&& other) noexcept;
+	GeometryHandle& operator=(const GeometryHandle& other) = delete;
+	GeometryHandle& operator=(GeometryHandle&& other) noexcept;
+	~GeometryHandle();
+
+	bool valid() const { return m_Renderer != nullptr; }
+	uint32_t id() const { return m_Id; }
+
+	void reset();
+
+private:
+	HeadlessRenderer* m_Renderer{ nullptr };
+	uint32_t m_Id{ 0 };
+};
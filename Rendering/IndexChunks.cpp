@@ -0,0 +1,77 @@
+#include "IndexChunks.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr uint32_t MAX_CHUNK_VERTICES = 1u << 16;
+
+// Below this many indices per chunk on average the extra draws cost more than the index memory saves
+constexpr size_t MIN_AVERAGE_CHUNK_INDICES = 1024;
+
+}
+
+bool splitIndices16(const std::vector<unsigned int>& indices, uint32_t primitiveSize, SplitIndices& out) {
+	out.indices.clear();
+	out.chunks.clear();
+
+	// A trailing partial primitive is never drawn
+	size_t indexCount = indices.size() - indices.size() % primitiveSize;
+
+	if (indexCount == 0) {
+		return true;
+	}
+
+	out.indices.resize(indexCount);
+
+	size_t chunkStart = 0;
+	uint32_t chunkMin = indices[0];
+	uint32_t chunkMax = indices[0];
+
+	auto closeChunk = [&](size_t end) {
+		for (size_t i = chunkStart; i < end; ++i) {
+			out.indices[i] = static_cast<uint16_t>(indices[i] - chunkMin);
+		}
+
+		out.chunks.push_back(IndexChunk{ static_cast<uint32_t>(chunkStart), static_cast<uint32_t>(end - chunkStart), static_cast<int32_t>(chunkMin) });
+	};
+
+	for (size_t primitive = 0; primitive < indexCount; primitive += primitiveSize) {
+		uint32_t primitiveMin = indices[primitive];
+		uint32_t primitiveMax = indices[primitive];
+		for (uint32_t k = 1; k < primitiveSize; ++k) {
+			primitiveMin = std::min(primitiveMin, indices[primitive + k]);
+			primitiveMax = std::max(primitiveMax, indices[primitive + k]);
+		}
+
+		if (primitiveMax - primitiveMin >= MAX_CHUNK_VERTICES) {
+			out.indices.clear();
+			out.chunks.clear();
+			return false;
+		}
+
+		uint32_t newMin = std::min(chunkMin, primitiveMin);
+		uint32_t newMax = std::max(chunkMax, primitiveMax);
+
+		if (newMax - newMin >= MAX_CHUNK_VERTICES) {
+			closeChunk(primitive);
+
+			chunkStart = primitive;
+			newMin = primitiveMin;
+			newMax = primitiveMax;
+		}
+
+		chunkMin = newMin;
+		chunkMax = newMax;
+	}
+
+	closeChunk(indexCount);
+
+	if (out.chunks.size() > 1 && indexCount / out.chunks.size() < MIN_AVERAGE_CHUNK_INDICES) {
+		out.indices.clear();
+		out.chunks.clear();
+		return false;
+	}
+
+	return true;
+}
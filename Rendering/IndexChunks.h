@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+// Consecutive range of an index buffer drawn with its own vertexOffset
+struct IndexChunk {
+	uint32_t firstIndex{ 0 };
+	uint32_t indexCount{ 0 };
+	int32_t vertexOffset{ 0 };
+};
+
+struct SplitIndices {
+	std::vector<uint16_t> indices;      // Relative to the vertexOffset of their chunk
+	std::vector<IndexChunk> chunks;
+};
+
+// Splits a list of primitives of primitiveSize indices each, in order, into chunks that address at most 65536
+// vertices each so they fit 16 bit indices. Returns false when a single primitive spans more than that, or when the
+// primitives jump around so much the chunks would be tiny, the indices then have to stay 32 bit.
+bool splitIndices16(const std::vector<unsigned int>& indices, uint32_t primitiveSize, SplitIndices& out);
@@ -0,0 +1,217 @@
+#include "MeshClusters.h"
+
+#include <cmath>
+#include <array>
+#include <algorithm>
+
+namespace {
+
+// Bounds of the triangles indices[first, first + count), the cluster's vertexOffset is already part of the indices
+MeshCluster boundCluster(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, uint32_t first, uint32_t count, int32_t vertexOffset) {
+	MeshCluster cluster;
+	cluster.draw = IndexChunk{ first, count, vertexOffset };
+
+	auto position = [&vertices](unsigned int v) {
+		const float* p = &vertices[6 * size_t(v)];
+		return glm::vec3{ p[0], p[1], p[2] };
+	};
+
+	glm::vec3 minBound = position(indices[first]);
+	glm::vec3 maxBound = minBound;
+	glm::vec3 normalSum{ 0.0f };
+
+	for (uint32_t i = first; i < first + count; i += 3) {
+		glm::vec3 p0 = position(indices[i]);
+		glm::vec3 p1 = position(indices[i + 1]);
+		glm::vec3 p2 = position(indices[i + 2]);
+
+		minBound = glm::min(minBound, glm::min(p0, glm::min(p1, p2)));
+		maxBound = glm::max(maxBound, glm::max(p0, glm::max(p1, p2)));
+
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		float length = glm::length(normal);
+		if (length > 0.0f) {
+			normalSum += normal / length;
+		}
+	}
+
+	cluster.center = 0.5f * (minBound + maxBound);
+	cluster.radius = 0.0f;
+
+	for (uint32_t i = first; i < first + count; ++i) {
+		cluster.radius = std::max(cluster.radius, glm::length(position(indices[i]) - cluster.center));
+	}
+
+	// Never culled unless every normal lies strictly within a hemisphere around the average
+	cluster.coneAxis = glm::vec3{ 0.0f, 0.0f, 1.0f };
+	cluster.coneCutoff = 2.0f;
+
+	float sumLength = glm::length(normalSum);
+	if (sumLength == 0.0f) {
+		return cluster;
+	}
+
+	glm::vec3 axis = normalSum / sumLength;
+	float minDot = 1.0f;
+
+	for (uint32_t i = first; i < first + count; i += 3) {
+		glm::vec3 p0 = position(indices[i]);
+		glm::vec3 normal = glm::cross(position(indices[i + 1]) - p0, position(indices[i + 2]) - p0);
+		float length = glm::length(normal);
+
+		if (length > 0.0f) {
+			minDot = std::min(minDot, glm::dot(normal / length, axis));
+		}
+	}
+
+	if (minDot > 0.0f) {
+		cluster.coneAxis = axis;
+		cluster.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+	}
+
+	return cluster;
+}
+
+}
+
+bool isClosedMesh(const std::vector<float>& vertices, const std::vector<unsigned int>& indices) {
+	auto position = [&vertices](unsigned int v) {
+		const float* p = &vertices[6 * size_t(v)];
+		return glm::vec3{ p[0], p[1], p[2] };
+	};
+
+	// Vertices split at normal or color seams share a position, number them by position instead
+	size_t vertexCount = vertices.size() / 6;
+	std::vector<uint32_t> byPosition(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; ++v) {
+		byPosition[v] = v;
+	}
+
+	auto lessPosition = [&vertices](uint32_t a, uint32_t b) {
+		return std::lexicographical_compare(&vertices[6 * size_t(a)], &vertices[6 * size_t(a)] + 3, &vertices[6 * size_t(b)], &vertices[6 * size_t(b)] + 3);
+	};
+	std::sort(byPosition.begin(), byPosition.end(), lessPosition);
+
+	std::vector<uint32_t> positionId(vertexCount);
+	uint32_t nextId = 0;
+	for (size_t i = 0; i < vertexCount; ++i) {
+		if (i > 0 && lessPosition(byPosition[i - 1], byPosition[i])) {
+			++nextId;
+		}
+		positionId[byPosition[i]] = nextId;
+	}
+
+	// Directed edges, each must appear once and be matched by its reverse
+	std::vector<uint64_t> edges;
+	edges.reserve(indices.size());
+	double volume = 0.0;
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		uint32_t corners[3] = { positionId[indices[i]], positionId[indices[i + 1]], positionId[indices[i + 2]] };
+		if (corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0]) {
+			continue;
+		}
+
+		for (int k = 0; k < 3; ++k) {
+			edges.push_back(uint64_t(corners[k]) << 32 | corners[(k + 1) % 3]);
+		}
+
+		glm::vec3 p0 = position(indices[i]);
+		volume += glm::dot(p0, glm::cross(position(indices[i + 1]), position(indices[i + 2])));
+	}
+
+	if (edges.empty() || volume <= 0.0) {
+		return false;
+	}
+
+	std::sort(edges.begin(), edges.end());
+	if (std::adjacent_find(edges.begin(), edges.end()) != edges.end()) {
+		return false;
+	}
+
+	for (uint64_t edge : edges) {
+		uint64_t reverse = edge << 32 | edge >> 32;
+		if (!std::binary_search(edges.begin(), edges.end(), reverse)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+std::vector<MeshCluster> buildMeshClusters(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, const std::vector<IndexChunk>& chunks) {
+	std::vector<MeshCluster> clusters;
+
+	for (const IndexChunk& chunk : chunks) {
+		for (uint32_t first = chunk.firstIndex; first < chunk.firstIndex + chunk.indexCount; first += 3 * CLUSTER_TRIANGLES) {
+			uint32_t count = std::min(3 * CLUSTER_TRIANGLES, chunk.firstIndex + chunk.indexCount - first);
+			clusters.push_back(boundCluster(vertices, indices, first, count, chunk.vertexOffset));
+		}
+	}
+
+	return clusters;
+}
+
+void cullMeshClusters(const std::vector<MeshCluster>& clusters, const glm::mat4& mvp, bool coneCulling, std::vector<IndexChunk>& draws) {
+	// Frustum planes of a clip space with depth from 0 to 1, pointing inwards (Gribb and Hartmann)
+	glm::vec4 row[4];
+	for (int i = 0; i < 4; ++i) {
+		row[i] = glm::vec4{ mvp[0][i], mvp[1][i], mvp[2][i], mvp[3][i] };
+	}
+
+	std::array<glm::vec4, 6> planes{
+		row[3] + row[0], row[3] - row[0],
+		row[3] + row[1], row[3] - row[1],
+		row[2], row[3] - row[2]
+	};
+
+	for (glm::vec4& plane : planes) {
+		float length = glm::length(glm::vec3{ plane });
+		if (length > 0.0f) {
+			plane /= length;
+		}
+	}
+
+	// The eye is where clip x, y and w vanish. For an orthographic projection it lies at infinity and this is the
+	// direction clip z grows along, away from the eye.
+	glm::vec4 eye = glm::inverse(mvp) * glm::vec4{ 0.0f, 0.0f, 1.0f, 0.0f };
+	bool perspective = std::abs(eye.w) > 0.0f;
+	glm::vec3 eyePosition = perspective ? glm::vec3{ eye } / eye.w : glm::vec3{ 0.0f };
+	glm::vec3 viewDirection = perspective ? glm::vec3{ 0.0f } : glm::normalize(glm::vec3{ eye });
+
+	for (const MeshCluster& cluster : clusters) {
+		bool visible = true;
+
+		for (const glm::vec4& plane : planes) {
+			if (glm::dot(glm::vec3{ plane }, cluster.center) + plane.w < -cluster.radius) {
+				visible = false;
+				break;
+			}
+		}
+
+		if (visible && coneCulling && cluster.coneCutoff <= 1.0f) {
+			if (perspective) {
+				glm::vec3 toCluster = cluster.center - eyePosition;
+				visible = glm::dot(toCluster, cluster.coneAxis) < cluster.coneCutoff * glm::length(toCluster) + cluster.radius;
+			} else {
+				visible = glm::dot(viewDirection, cluster.coneAxis) < cluster.coneCutoff;
+			}
+		}
+
+		if (!visible) {
+			continue;
+		}
+
+		// Clusters are consecutive in the index buffer, neighbours in the same chunk merge into one draw
+		if (!draws.empty()) {
+			IndexChunk& last = draws.back();
+
+			if (last.vertexOffset == cluster.draw.vertexOffset && last.firstIndex + last.indexCount == cluster.draw.firstIndex) {
+				last.indexCount += cluster.draw.indexCount;
+				continue;
+			}
+		}
+
+		draws.push_back(cluster.draw);
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "IndexChunks.h"
+
+constexpr uint32_t CLUSTER_TRIANGLES = 128;
+
+// Consecutive run of about CLUSTER_TRIANGLES triangles of a mesh, with the bounds the culler tests
+struct MeshCluster {
+	IndexChunk draw;
+
+	// Bounding sphere
+	glm::vec3 center;
+	float radius;
+
+	// Normal cone, every triangle normal is within the cone around axis. cutoff is the sine of its half angle,
+	// above 1 when the triangles face too many ways for the cluster to ever be entirely back facing.
+	glm::vec3 coneAxis;
+	float coneCutoff;
+};
+
+// Splits every chunk of the mesh into clusters, indices are the absolute 32 bit indices the chunks were made from
+// and vertices the interleaved position and normal vertices they index
+std::vector<MeshCluster> buildMeshClusters(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, const std::vector<IndexChunk>& chunks);
+
+// True when every edge of the triangles is shared by exactly two of them with opposite windings and the enclosed volume
+// is positive, so counter-clockwise faces point outwards and no back face can ever be seen. Vertices at the same position
+// count as one, triangles that collapse to an edge or a point are left out.
+bool isClosedMesh(const std::vector<float>& vertices, const std::vector<unsigned int>& indices);
+
+// Appends a draw for every run of consecutive clusters that may be visible through mvp to draws. Clusters entirely
+// outside the view frustum are dropped, and with coneCulling so are clusters that entirely face away from the eye.
+// Only pass coneCulling for closed meshes drawn with back faces culled.
+void cullMeshClusters(const std::vector<MeshCluster>& clusters, const glm::mat4& mvp, bool coneCulling, std::vector<IndexChunk>& draws);
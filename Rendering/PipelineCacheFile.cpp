@@ -0,0 +1,161 @@
+#include "PipelineCacheFile.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+
+#include "../3rdParty/VulkanTools/VulkanTools.h"
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed) {
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+	uint64_t hash = seed;
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+static std::filesystem::path cacheDirectory() {
+#if defined(_WIN32)
+	const char* localAppData = std::getenv("LOCALAPPDATA");
+
+	if (localAppData != nullptr && localAppData[0] != '\0') {
+		return std::filesystem::path{ localAppData } / "okular-v3d";
+	}
+#else
+	const char* xdgCacheHome = std::getenv("XDG_CACHE_HOME");
+
+	if (xdgCacheHome != nullptr && xdgCacheHome[0] != '\0') {
+		return std::filesystem::path{ xdgCacheHome } / "okular-v3d";
+	}
+
+	const char* home = std::getenv("HOME");
+
+	if (home != nullptr && home[0] != '\0') {
+		return std::filesystem::path{ home } / ".cache" / "okular-v3d";
+	}
+#endif
+
+	return std::filesystem::temp_directory_path() / "okular-v3d";
+}
+
+PipelineCacheFile::PipelineCacheFile(VkPhysicalDevice physicalDevice, uint64_t shaderHash) {
+	vkGetPhysicalDeviceProperties(physicalDevice, &m_Properties);
+
+	std::ostringstream fileName;
+	fileName << "pipeline-cache-" << std::hex << std::setfill('0');
+
+	for (uint8_t byte : m_Properties.pipelineCacheUUID) {
+		fileName << std::setw(2) << static_cast<unsigned int>(byte);
+	}
+
+	fileName << "-" << std::setw(16) << shaderHash << ".bin";
+
+	m_Path = (cacheDirectory() / fileName.str()).string();
+}
+
+VkPipelineCache PipelineCacheFile::createPipelineCache(VkDevice device) {
+	std::vector<char> data;
+
+	std::ifstream file{ m_Path, std::ios::binary | std::ios::ate };
+
+	if (file.is_open()) {
+		std::streamsize size = file.tellg();
+
+		if (size > 0) {
+			data.resize(static_cast<size_t>(size));
+
+			file.seekg(0, std::ios::beg);
+
+			if (!file.read(data.data(), size)) {
+				data.clear();
+			}
+		}
+	}
+
+	if (!isCompatible(data)) {
+		data.clear();
+	}
+
+	VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
+	pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	pipelineCacheCreateInfo.initialDataSize = data.size();
+	pipelineCacheCreateInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+	VkPipelineCache pipelineCache;
+	VkResult result = vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &pipelineCache);
+
+	if (result != VK_SUCCESS && !data.empty()) {
+		// The driver rejected the saved data, start over with an empty cache
+		pipelineCacheCreateInfo.initialDataSize = 0;
+		pipelineCacheCreateInfo.pInitialData = nullptr;
+		result = vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &pipelineCache);
+	}
+
+	VK_CHECK_RESULT(result);
+
+	return pipelineCache;
+}
+
+void PipelineCacheFile::save(VkDevice device, VkPipelineCache pipelineCache) {
+	size_t size = 0;
+	if (vkGetPipelineCacheData(device, pipelineCache, &size, nullptr) != VK_SUCCESS || size == 0) {
+		return;
+	}
+
+	std::vector<char> data(size);
+	if (vkGetPipelineCacheData(device, pipelineCache, &size, data.data()) != VK_SUCCESS) {
+		return;
+	}
+	data.resize(size);
+
+	std::error_code error;
+	std::filesystem::path path{ m_Path };
+	std::filesystem::create_directories(path.parent_path(), error);
+
+	if (error) {
+		return;
+	}
+
+	// Written next to the final file and renamed so that a concurrent reader never sees a partial cache
+	std::filesystem::path temporaryPath = path;
+	temporaryPath += ".tmp";
+
+	{
+		std::ofstream file{ temporaryPath, std::ios::binary | std::ios::trunc };
+
+		if (!file.is_open() || !file.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+			return;
+		}
+	}
+
+	std::filesystem::rename(temporaryPath, path, error);
+
+	if (error) {
+		std::filesystem::remove(temporaryPath, error);
+	}
+}
+
+bool PipelineCacheFile::isCompatible(const std::vector<char>& data) const {
+	// Layout of VkPipelineCacheHeaderVersionOne
+	constexpr size_t headerSize = 16 + VK_UUID_SIZE;
+
+	if (data.size() < headerSize) {
+		return false;
+	}
+
+	uint32_t header[4];
+	std::memcpy(header, data.data(), sizeof(header));
+
+	return header[0] >= headerSize &&
+		   header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		   header[2] == m_Properties.vendorID &&
+		   header[3] == m_Properties.deviceID &&
+		   std::memcmp(data.data() + 16, m_Properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+// 64 bit FNV-1a hash, pass the previous result as seed to hash several buffers together
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325ull);
+
+// Stores the contents of a VkPipelineCache in the per-user cache directory so that pipelines compiled by one run are 
+// reused by the next. The file is keyed by the driver's pipeline cache UUID and a hash of the shaders, so a driver 
+// update or a shader change starts with an empty cache.
+class PipelineCacheFile {
+public:
+	PipelineCacheFile() = default;
+	PipelineCacheFile(VkPhysicalDevice physicalDevice, uint64_t shaderHash);
+
+	// Creates a pipeline cache, seeded with the saved data if there is a compatible cache file
+	VkPipelineCache createPipelineCache(VkDevice device);
+
+	// Writes the current contents of the pipeline cache, failures are ignored as the cache is only an optimization
+	void save(VkDevice device, VkPipelineCache pipelineCache);
+
+	const std::string& path() const { return m_Path; }
+
+private:
+	bool isCompatible(const std::vector<char>& data) const;
+
+	VkPhysicalDeviceProperties m_Properties{ };
+	std::string m_Path{ };
+};
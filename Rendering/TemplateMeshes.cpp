@@ -0,0 +1,114 @@
+#include "TemplateMeshes.h"
+
+#include <cmath>
+
+#include <glm/ext/scalar_constants.hpp>
+
+namespace {
+
+// Latitude and longitude grid on the unit sphere around the z axis, from the north pole down to maxPolar
+TemplateLod appendLatLong(TemplateMeshes& meshes, uint32_t slices, uint32_t stacks, float maxPolar) {
+	TemplateLod lod;
+	lod.firstIndex = static_cast<uint32_t>(meshes.indices.size());
+	lod.vertexOffset = static_cast<int32_t>(meshes.vertices.size() / 6);
+
+	for (uint32_t stack = 0; stack <= stacks; ++stack) {
+		float polar = maxPolar * stack / stacks;
+
+		for (uint32_t slice = 0; slice <= slices; ++slice) {
+			float azimuth = 2.0f * glm::pi<float>() * slice / slices;
+
+			float x = std::sin(polar) * std::cos(azimuth);
+			float y = std::sin(polar) * std::sin(azimuth);
+			float z = std::cos(polar);
+
+			// Position and normal coincide on the unit sphere
+			meshes.vertices.insert(meshes.vertices.end(), { x, y, z, x, y, z });
+		}
+	}
+
+	uint32_t rowLength = slices + 1;
+	for (uint32_t stack = 0; stack < stacks; ++stack) {
+		for (uint32_t slice = 0; slice < slices; ++slice) {
+			uint32_t i0 = stack * rowLength + slice;
+			uint32_t i1 = i0 + 1;
+			uint32_t i2 = i0 + rowLength;
+			uint32_t i3 = i2 + 1;
+
+			meshes.indices.insert(meshes.indices.end(), { i0, i2, i1, i1, i2, i3 });
+		}
+	}
+
+	lod.indexCount = static_cast<uint32_t>(meshes.indices.size()) - lod.firstIndex;
+
+	return lod;
+}
+
+// Unit disk in the xy plane facing +z, fanned out from its center
+TemplateLod appendDisk(TemplateMeshes& meshes, uint32_t slices) {
+	TemplateLod lod;
+	lod.firstIndex = static_cast<uint32_t>(meshes.indices.size());
+	lod.vertexOffset = static_cast<int32_t>(meshes.vertices.size() / 6);
+
+	meshes.vertices.insert(meshes.vertices.end(), { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f });
+
+	for (uint32_t slice = 0; slice <= slices; ++slice) {
+		float azimuth = 2.0f * glm::pi<float>() * slice / slices;
+
+		meshes.vertices.insert(meshes.vertices.end(), { std::cos(azimuth), std::sin(azimuth), 0.0f, 0.0f, 0.0f, 1.0f });
+	}
+
+	for (uint32_t slice = 0; slice < slices; ++slice) {
+		meshes.indices.insert(meshes.indices.end(), { 0, slice + 1, slice + 2 });
+	}
+
+	lod.indexCount = static_cast<uint32_t>(meshes.indices.size()) - lod.firstIndex;
+
+	return lod;
+}
+
+// Open cylinder of radius 1 around the z axis, from z = 0 to z = 1
+TemplateLod appendCylinder(TemplateMeshes& meshes, uint32_t slices) {
+	TemplateLod lod;
+	lod.firstIndex = static_cast<uint32_t>(meshes.indices.size());
+	lod.vertexOffset = static_cast<int32_t>(meshes.vertices.size() / 6);
+
+	for (uint32_t slice = 0; slice <= slices; ++slice) {
+		float azimuth = 2.0f * glm::pi<float>() * slice / slices;
+
+		float x = std::cos(azimuth);
+		float y = std::sin(azimuth);
+
+		meshes.vertices.insert(meshes.vertices.end(), { x, y, 0.0f, x, y, 0.0f, x, y, 1.0f, x, y, 0.0f });
+	}
+
+	for (uint32_t slice = 0; slice < slices; ++slice) {
+		uint32_t i0 = 2 * slice;
+		uint32_t i1 = i0 + 1;
+		uint32_t i2 = i0 + 2;
+		uint32_t i3 = i0 + 3;
+
+		meshes.indices.insert(meshes.indices.end(), { i0, i2, i1, i1, i2, i3 });
+	}
+
+	lod.indexCount = static_cast<uint32_t>(meshes.indices.size()) - lod.firstIndex;
+
+	return lod;
+}
+
+}
+
+TemplateMeshes buildTemplateMeshes() {
+	TemplateMeshes meshes;
+
+	for (uint32_t lod = 0; lod < TEMPLATE_LOD_COUNT; ++lod) {
+		uint32_t slices = 8u << lod;
+
+		meshes.lods[SPHERE_TEMPLATE][lod] = appendLatLong(meshes, slices, slices / 2, glm::pi<float>());
+		meshes.lods[HEMISPHERE_TEMPLATE][lod] = appendLatLong(meshes, slices, slices / 4, 0.5f * glm::pi<float>());
+		meshes.lods[DISK_TEMPLATE][lod] = appendDisk(meshes, slices);
+		meshes.lods[CYLINDER_TEMPLATE][lod] = appendCylinder(meshes, slices);
+	}
+
+	return meshes;
+}
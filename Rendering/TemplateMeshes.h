@@ -0,0 +1,29 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+#include "../V3dFile/V3dInstances.h"
+
+constexpr uint32_t TEMPLATE_LOD_COUNT = 4;
+
+// Smallest radius on screen, in pixels, each level of detail is used from
+constexpr std::array<float, TEMPLATE_LOD_COUNT> TEMPLATE_LOD_MIN_RADIUS{ 0.0f, 4.0f, 16.0f, 64.0f };
+
+// Part of the shared template buffers holding one level of detail of a template
+struct TemplateLod {
+	uint32_t firstIndex{ 0 };
+	uint32_t indexCount{ 0 };
+	int32_t vertexOffset{ 0 };
+};
+
+struct TemplateMeshes {
+	std::vector<float> vertices;        // Interleaved position and normal, like model geometry
+	std::vector<unsigned int> indices;  // Relative to the vertexOffset of their level of detail
+
+	std::array<std::array<TemplateLod, TEMPLATE_LOD_COUNT>, INSTANCE_TEMPLATE_COUNT> lods;
+};
+
+// Builds every level of detail of every template, coarsest first
+TemplateMeshes buildTemplateMeshes();
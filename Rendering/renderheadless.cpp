@@ -11,6 +11,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <chrono>
+#include <cstddef>
+#include <fstream>
 
 // #define VULKAN_DEBUG 1
 
@@ -31,9 +33,62 @@ HeadlessRenderer::HeadlessRenderer(std::string shaderPath)
 		cmdPoolInfo.queueFamilyIndex = queueFamilyIndex;
 		cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 		VK_CHECK_RESULT(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &commandPool));
+
+		// The render pass and pipeline only depend on the device and the attachment formats, so they are built once
+		vks::tools::getSupportedDepthFormat(physicalDevice, &depthFormat);
+
+		createRenderPass();
+		createShaderModules();
+
+		// Pipelines compiled by earlier runs are loaded from disk, so only the first start after a driver or shader change pays for compilation
+		pipelineCacheFile = PipelineCacheFile{ physicalDevice, shaderHash };
+		pipelineCache = pipelineCacheFile.createPipelineCache(device);
+
+		createGraphicsPipeline();
+
+		pipelineCacheFile.save(device, pipelineCache);
+		frameResources.create(device, commandPool, READBACK_SLOT_COUNT);
+
+		uploadTemplateMeshes();
 	}
 
 HeadlessRenderer::~HeadlessRenderer() { 
+	for (auto& [geometryId, geometry] : geometries) {
+		releaseGeometry(geometry);
+	}
+	geometries.clear();
+
+	// Waits for the device and destroys what is still queued for release
+	frameResources.destroy();
+
+	destroyReadbackSlots();
+	destroyAttachments();
+
+	vkDestroyBuffer(device, templateVertexBuffer, nullptr);
+	vkFreeMemory(device, templateVertexMemory, nullptr);
+	vkDestroyBuffer(device, templateIndexBuffer, nullptr);
+	vkFreeMemory(device, templateIndexMemory, nullptr);
+
+	vkDestroyPipeline(device, colorPipeline, nullptr);
+	vkDestroyPipeline(device, compactPipeline, nullptr);
+	vkDestroyPipeline(device, compactColorPipeline, nullptr);
+	vkDestroyPipeline(device, closedPipeline, nullptr);
+	vkDestroyPipeline(device, closedColorPipeline, nullptr);
+	vkDestroyPipeline(device, closedCompactPipeline, nullptr);
+	vkDestroyPipeline(device, closedCompactColorPipeline, nullptr);
+	vkDestroyPipeline(device, instancePipeline, nullptr);
+	vkDestroyPipeline(device, linePipeline, nullptr);
+	vkDestroyPipeline(device, pointPipeline, nullptr);
+	vkDestroyPipeline(device, pipeline, nullptr);
+	vkDestroyPipelineCache(device, pipelineCache, nullptr);
+	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+	vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+	vkDestroyRenderPass(device, renderPass, nullptr);
+
+	for (auto shadermodule : shaderModules) {
+		vkDestroyShaderModule(device, shadermodule, nullptr);
+	}
+
 	vkDestroyCommandPool(device, commandPool, nullptr);
 	vkDestroyDevice(device, nullptr);
 
@@ -48,7 +103,7 @@ HeadlessRenderer::~HeadlessRenderer() {
 	vkDestroyInstance(instance, nullptr);
 }
 
-static VKAPI_ATTR VkBool32 VKAPI_CALL debugMessageCallback(
+VKAPI_ATTR VkBool32 VKAPI_CALL HeadlessRenderer::debugMessageCallback(
 	VkDebugReportFlagsEXT flags,
 	VkDebugReportObjectTypeEXT objectType,
 	uint64_t object,
@@ -58,12 +113,10 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL debugMessageCallback(
 	const char* pMessage,
 	void* pUserData)
 {
-	LOG("[VALIDATION]: %s - %s\n", pLayerPrefix, pMessage);
+	std::cout << "[VALIDATION]: " << pLayerPrefix << " - " << pMessage << std::endl;
 	return VK_FALSE;
 }
 
-VkDebugReportCallbackEXT debugReportCallback{};
-
 uint32_t HeadlessRenderer::getMemoryTypeIndex(uint32_t typeBits, VkMemoryPropertyFlags properties) {
 	VkPhysicalDeviceMemoryProperties deviceMemoryProperties;
 	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &deviceMemoryProperties);
@@ -104,18 +157,6 @@ VkResult HeadlessRenderer::createBuffer(VkBufferUsageFlags usageFlags, VkMemoryP
 	return VK_SUCCESS;
 }
 
-void HeadlessRenderer::submitWork(VkCommandBuffer cmdBuffer, VkQueue queue) {
-	VkSubmitInfo submitInfo = vks::initializers::submitInfo();
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &cmdBuffer;
-	VkFenceCreateInfo fenceInfo = vks::initializers::fenceCreateInfo();
-	VkFence fence;
-	VK_CHECK_RESULT(vkCreateFence(device, &fenceInfo, nullptr, &fence));
-	VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, fence));
-	VK_CHECK_RESULT(vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX));
-	vkDestroyFence(device, fence, nullptr);
-}
-
 void HeadlessRenderer::createInstance() {
 	VkApplicationInfo appInfo = {};
 	appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
@@ -219,93 +260,228 @@ void HeadlessRenderer::createLogicalDevice(VkDeviceQueueCreateInfo* queueCreateI
 
 	deviceCreateInfo.enabledExtensionCount = (uint32_t)deviceExtensions.size();
 	deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
+
+	// Pixels are drawn as points wider than one pixel where the device allows it
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
+	VkPhysicalDeviceFeatures enabledFeatures{};
+	enabledFeatures.largePoints = supportedFeatures.largePoints;
+	deviceCreateInfo.pEnabledFeatures = &enabledFeatures;
+
+	if (supportedFeatures.largePoints) {
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		pointSize = std::clamp(PIXEL_POINT_SIZE, properties.limits.pointSizeRange[0], properties.limits.pointSizeRange[1]);
+	}
+
 	VK_CHECK_RESULT(vkCreateDevice(physicalDevice, &deviceCreateInfo, nullptr, &device));
 }
 
-void HeadlessRenderer::copyVertexDataToGPU(const std::vector<float>& vertices) {
-	const VkDeviceSize vertexBufferSize = vertices.size() * sizeof(float);
-
+void HeadlessRenderer::copyDataToGPU(VkCommandBuffer copyCmd, VkBufferUsageFlags usageFlags, const void* data, VkDeviceSize size, VkBuffer* buffer, VkDeviceMemory* memory) {
 	VkBuffer stagingBuffer;
 	VkDeviceMemory stagingMemory;
 
-	// Command buffer for copy commands (reused)
-	VkCommandBufferAllocateInfo cmdBufAllocateInfo = vks::initializers::commandBufferAllocateInfo(commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
-	VkCommandBuffer copyCmd;
-	VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &copyCmd));
-	VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
-
 	createBuffer(
 		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 		&stagingBuffer,
 		&stagingMemory,
-		vertexBufferSize,
-		(void*)vertices.data()
+		size,
+		(void*)data
 	);
 
 	createBuffer(
-		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		usageFlags | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		&vertexBuffer,
-		&vertexMemory,
-		vertexBufferSize
+		buffer,
+		memory,
+		size
 	);
 
-	VK_CHECK_RESULT(vkBeginCommandBuffer(copyCmd, &cmdBufInfo));
 	VkBufferCopy copyRegion = {};
-	copyRegion.size = vertexBufferSize;
-	vkCmdCopyBuffer(copyCmd, stagingBuffer, vertexBuffer, 1, &copyRegion);
-	VK_CHECK_RESULT(vkEndCommandBuffer(copyCmd));
+	copyRegion.size = size;
+	vkCmdCopyBuffer(copyCmd, stagingBuffer, *buffer, 1, &copyRegion);
+
+	frameResources.releaseAfterTransfer(stagingBuffer, stagingMemory);
+}
+
+void HeadlessRenderer::uploadTemplateMeshes() {
+	TemplateMeshes meshes = buildTemplateMeshes();
+	templateLods = meshes.lods;
+
+	VkCommandBuffer copyCmd = frameResources.beginTransfer();
 
-	submitWork(copyCmd, queue);
+	copyDataToGPU(copyCmd, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, meshes.vertices.data(), meshes.vertices.size() * sizeof(float), &templateVertexBuffer, &templateVertexMemory);
+	copyDataToGPU(copyCmd, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, meshes.indices.data(), meshes.indices.size() * sizeof(unsigned int), &templateIndexBuffer, &templateIndexMemory);
 
-	vkDestroyBuffer(device, stagingBuffer, nullptr);
-	vkFreeMemory(device, stagingMemory, nullptr);	
+	frameResources.submitTransfer(queue);
 }
 
-void HeadlessRenderer::copyIndexDataToGPU(const std::vector<unsigned int>& indices) {
-	const VkDeviceSize indexBufferSize = indices.size() * sizeof(unsigned int);
+void HeadlessRenderer::uploadIndices(VkCommandBuffer copyCmd, const std::vector<unsigned int>& indices, uint32_t primitiveSize, VkBuffer* buffer, VkDeviceMemory* memory,
+	VkIndexType& indexType, std::vector<IndexChunk>& chunks) {
+	SplitIndices split;
 
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingMemory;
+	if (splitIndices16(indices, primitiveSize, split)) {
+		copyDataToGPU(copyCmd, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, split.indices.data(), split.indices.size() * sizeof(uint16_t), buffer, memory);
 
-	// Command buffer for copy commands (reused)
-	VkCommandBufferAllocateInfo cmdBufAllocateInfo = vks::initializers::commandBufferAllocateInfo(commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
-	VkCommandBuffer copyCmd;
-	VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &copyCmd));
-	VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
+		indexType = VK_INDEX_TYPE_UINT16;
+		chunks = std::move(split.chunks);
+	} else {
+		copyDataToGPU(copyCmd, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indices.data(), indices.size() * sizeof(unsigned int), buffer, memory);
 
-	// Indices
-	createBuffer(
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		&stagingBuffer,
-		&stagingMemory,
-		indexBufferSize,
-		(void*)indices.data()
-	);
+		indexType = VK_INDEX_TYPE_UINT32;
+		chunks = { IndexChunk{ 0, static_cast<uint32_t>(indices.size()), 0 } };
+	}
+}
 
-	createBuffer(
-		VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		&indexBuffer,
-		&indexMemory,
-		indexBufferSize
-	);
+GeometryHandle HeadlessRenderer::uploadGeometry(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, const std::vector<uint32_t>& colors, const InstanceLists& instances,
+	const std::vector<float>& lineVertices, const std::vector<unsigned int>& lineIndices, const std::vector<float>& pointVertices, VertexFormat vertexFormat) {
+	GpuGeometry geometry{ };
 
-	VK_CHECK_RESULT(vkBeginCommandBuffer(copyCmd, &cmdBufInfo));
-	VkBufferCopy copyRegion = {};
-	copyRegion.size = indexBufferSize;
-	vkCmdCopyBuffer(copyCmd, stagingBuffer, indexBuffer, 1, &copyRegion);
-	VK_CHECK_RESULT(vkEndCommandBuffer(copyCmd));
+	// The upload is not waited on here, the next frame submission waits for it on the GPU
+	VkCommandBuffer copyCmd = frameResources.beginTransfer();
+
+	if (!indices.empty()) {
+		if (vertexFormat == VertexFormat::Compact) {
+			CompactMesh compact = compactVertices(vertices);
+			copyDataToGPU(copyCmd, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, compact.vertices.data(), compact.vertices.size() * sizeof(CompactVertex), &geometry.vertexBuffer, &geometry.vertexMemory);
+
+			geometry.positionOffset = compact.positionOffset;
+			geometry.positionScale = compact.positionScale;
+		} else {
+			copyDataToGPU(copyCmd, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertices.data(), vertices.size() * sizeof(float), &geometry.vertexBuffer, &geometry.vertexMemory);
+		}
+
+		geometry.vertexFormat = vertexFormat;
+		uploadIndices(copyCmd, indices, 3, &geometry.indexBuffer, &geometry.indexMemory, geometry.indexType, geometry.indexChunks);
+
+		geometry.indexCount = static_cast<uint32_t>(indices.size());
+
+		if (indices.size() > 3 * CLUSTER_TRIANGLES) {
+			geometry.clusters = buildMeshClusters(vertices, indices, geometry.indexChunks);
+
+			// Quantized positions move by up to half a step on each axis
+			if (vertexFormat == VertexFormat::Compact) {
+				float padding = 0.5f * glm::length(glm::vec3{ geometry.positionScale }) / 65535.0f;
+
+				for (MeshCluster& cluster : geometry.clusters) {
+					cluster.radius += padding;
+				}
+			}
+		}
+
+		if (!colors.empty()) {
+			copyDataToGPU(copyCmd, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, colors.data(), colors.size() * sizeof(uint32_t), &geometry.colorBuffer, &geometry.colorMemory);
+		}
+
+		// Back faces of a translucent mesh show through its front, alpha is the high byte of the packed colors
+		bool opaque = std::all_of(colors.begin(), colors.end(), [](uint32_t color) { return (color >> 24) == 0xff; });
+		geometry.closed = opaque && isClosedMesh(vertices, indices);
+	}
+
+	for (uint32_t templateIndex = 0; templateIndex < INSTANCE_TEMPLATE_COUNT; ++templateIndex) {
+		if (instances[templateIndex].empty()) {
+			continue;
+		}
+
+		std::vector<PrimitiveInstance> sorted = instances[templateIndex];
+		std::sort(sorted.begin(), sorted.end(), [](const PrimitiveInstance& a, const PrimitiveInstance& b) { return a.radius < b.radius; });
 
-	submitWork(copyCmd, queue);
+		InstanceSet& set = geometry.instances[templateIndex];
 
-	vkDestroyBuffer(device, stagingBuffer, nullptr);
-	vkFreeMemory(device, stagingMemory, nullptr);
+		set.radii.reserve(sorted.size());
+		for (const PrimitiveInstance& instance : sorted) {
+			set.radii.push_back(instance.radius);
+		}
+
+		copyDataToGPU(copyCmd, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sorted.data(), sorted.size() * sizeof(PrimitiveInstance), &set.buffer, &set.memory);
+	}
+
+	if (!lineIndices.empty() || !pointVertices.empty()) {
+		std::vector<float> linesAndPoints;
+		linesAndPoints.reserve(lineVertices.size() + pointVertices.size());
+		linesAndPoints.insert(linesAndPoints.end(), lineVertices.begin(), lineVertices.end());
+		linesAndPoints.insert(linesAndPoints.end(), pointVertices.begin(), pointVertices.end());
+
+		copyDataToGPU(copyCmd, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, linesAndPoints.data(), linesAndPoints.size() * sizeof(float), &geometry.lineVertexBuffer, &geometry.lineVertexMemory);
+
+		if (!lineIndices.empty()) {
+			uploadIndices(copyCmd, lineIndices, 2, &geometry.lineIndexBuffer, &geometry.lineIndexMemory, geometry.lineIndexType, geometry.lineIndexChunks);
+		}
+
+		geometry.lineIndexCount = static_cast<uint32_t>(lineIndices.size());
+		geometry.firstPoint = static_cast<uint32_t>(lineVertices.size() / 6);
+		geometry.pointCount = static_cast<uint32_t>(pointVertices.size() / 6);
+	}
+
+	frameResources.submitTransfer(queue);
+
+	uint32_t geometryId = nextGeometryId++;
+	geometries[geometryId] = geometry;
+
+	return GeometryHandle{ this, geometryId };
 }
 
-void HeadlessRenderer::createAttachments(VkFormat colorFormat, VkFormat depthFormat, int targetWidth, int targetHeight) {
+void HeadlessRenderer::freeGeometry(uint32_t geometryId) {
+	auto it = geometries.find(geometryId);
+
+	if (it == geometries.end()) {
+		return;
+	}
+
+	// The upload or a frame that draws this geometry may still be in flight, its buffers are destroyed once they finish
+	releaseGeometry(it->second);
+	geometries.erase(it);
+}
+
+void HeadlessRenderer::uploadLods(const GeometryHandle& geometry, const std::vector<std::vector<unsigned int>>& lodIndices) {
+	GpuGeometry& gpuGeometry = geometries.at(geometry.id());
+
+	// The upload of the levels being replaced, or frames that draw them, may still be in flight
+	releaseLods(gpuGeometry);
+
+	VkCommandBuffer copyCmd = frameResources.beginTransfer();
+
+	for (const std::vector<unsigned int>& indices : lodIndices) {
+		if (indices.empty()) {
+			continue;
+		}
+
+		MeshLod lod;
+		uploadIndices(copyCmd, indices, 3, &lod.indexBuffer, &lod.indexMemory, lod.indexType, lod.indexChunks);
+		gpuGeometry.lods.push_back(std::move(lod));
+	}
+
+	frameResources.submitTransfer(queue);
+}
+
+void HeadlessRenderer::releaseGeometry(GpuGeometry& geometry) {
+	uint64_t submission = geometry.lastSubmission;
+
+	frameResources.releaseAfterSubmission(submission, geometry.vertexBuffer, geometry.vertexMemory);
+	frameResources.releaseAfterSubmission(submission, geometry.indexBuffer, geometry.indexMemory);
+	frameResources.releaseAfterSubmission(submission, geometry.colorBuffer, geometry.colorMemory);
+
+	for (InstanceSet& set : geometry.instances) {
+		frameResources.releaseAfterSubmission(submission, set.buffer, set.memory);
+	}
+
+	frameResources.releaseAfterSubmission(submission, geometry.lineVertexBuffer, geometry.lineVertexMemory);
+	frameResources.releaseAfterSubmission(submission, geometry.lineIndexBuffer, geometry.lineIndexMemory);
+
+	releaseLods(geometry);
+}
+
+void HeadlessRenderer::releaseLods(GpuGeometry& geometry) {
+	for (MeshLod& lod : geometry.lods) {
+		frameResources.releaseAfterSubmission(geometry.lastSubmission, lod.indexBuffer, lod.indexMemory);
+	}
+
+	geometry.lods.clear();
+}
+
+void HeadlessRenderer::createAttachments(int targetWidth, int targetHeight) {
 	VkImageCreateInfo image = vks::initializers::imageCreateInfo();
 	image.imageType = VK_IMAGE_TYPE_2D;
 	image.format = colorFormat;
@@ -367,7 +543,7 @@ void HeadlessRenderer::createAttachments(VkFormat colorFormat, VkFormat depthFor
 	VK_CHECK_RESULT(vkCreateImageView(device, &depthStencilView, nullptr, &depthAttachment.view));
 }
 
-void HeadlessRenderer::createRenderPipeline(VkFormat colorFormat, VkFormat depthFormat, int targetWidth, int targetHeight) {
+void HeadlessRenderer::createRenderPass() {
 	std::array<VkAttachmentDescription, 2> attchmentDescriptions = {};
 	// Color attachment
 	attchmentDescriptions[0].format = colorFormat;
@@ -400,21 +576,24 @@ void HeadlessRenderer::createRenderPipeline(VkFormat colorFormat, VkFormat depth
 	// Use subpass dependencies for layout transitions
 	std::array<VkSubpassDependency, 2> dependencies;
 
+	// The attachments are shared by consecutive frames that may be in flight at the same time, so the clear has to wait for the
+	// previous frame's depth writes and for its color attachment to be copied out
 	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
 	dependencies[0].dstSubpass = 0;
-	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[0].dependencyFlags = 0;
 
+	// Make the color attachment available to the copy into the readback buffer
 	dependencies[1].srcSubpass = 0;
 	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
 	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	dependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-	dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	dependencies[1].dependencyFlags = 0;
 
 	// Create the actual renderpass
 	VkRenderPassCreateInfo renderPassInfo = {};
@@ -426,7 +605,9 @@ void HeadlessRenderer::createRenderPipeline(VkFormat colorFormat, VkFormat depth
 	renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
 	renderPassInfo.pDependencies = dependencies.data();
 	VK_CHECK_RESULT(vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass));
+}
 
+void HeadlessRenderer::createFramebuffer(int targetWidth, int targetHeight) {
 	VkImageView attachments[2];
 	attachments[0] = colorAttachment.view;
 	attachments[1] = depthAttachment.view;
@@ -441,6 +622,45 @@ void HeadlessRenderer::createRenderPipeline(VkFormat colorFormat, VkFormat depth
 	VK_CHECK_RESULT(vkCreateFramebuffer(device, &framebufferCreateInfo, nullptr, &framebuffer));
 }
 
+VkShaderModule HeadlessRenderer::loadShader(const std::string& fileName) {
+	std::ifstream file{ shaderPath + fileName, std::ios::binary | std::ios::ate };
+
+	if (!file.is_open()) {
+		std::cerr << "Error: Could not open shader file \"" << shaderPath + fileName << "\"" << "\n";
+		return VK_NULL_HANDLE;
+	}
+
+	std::streamsize size = file.tellg();
+	std::vector<char> code(static_cast<size_t>(size));
+
+	file.seekg(0, std::ios::beg);
+	file.read(code.data(), size);
+
+	shaderHash = hashBytes(code.data(), code.size(), shaderHash);
+
+	VkShaderModuleCreateInfo moduleCreateInfo{};
+	moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	moduleCreateInfo.codeSize = code.size();
+	moduleCreateInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+	VkShaderModule shaderModule;
+	VK_CHECK_RESULT(vkCreateShaderModule(device, &moduleCreateInfo, nullptr, &shaderModule));
+
+	shaderModules.push_back(shaderModule);
+
+	return shaderModule;
+}
+
+void HeadlessRenderer::createShaderModules() {
+	vertexShader = loadShader("vertex.spv");
+	colorVertexShader = loadShader("colorVertex.spv");
+	compactVertexShader = loadShader("compactVertex.spv");
+	compactColorVertexShader = loadShader("compactColorVertex.spv");
+	instanceVertexShader = loadShader("instanceVertex.spv");
+	pointVertexShader = loadShader("pointVertex.spv");
+	fragmentShader = loadShader("fragment.spv");
+}
+
 void HeadlessRenderer::createGraphicsPipeline() {
 	std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings = {};
 	VkDescriptorSetLayoutCreateInfo descriptorLayout =
@@ -450,23 +670,91 @@ void HeadlessRenderer::createGraphicsPipeline() {
 	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo =
 		vks::initializers::pipelineLayoutCreateInfo(nullptr, 0);
 
-	// MVP via push constant block
-	VkPushConstantRange pushConstantRange = vks::initializers::pushConstantRange(VK_SHADER_STAGE_VERTEX_BIT, sizeof(glm::mat4), 0);
+	// MVP and the bounds of compact meshes via push constant block
+	VkPushConstantRange pushConstantRange = vks::initializers::pushConstantRange(VK_SHADER_STAGE_VERTEX_BIT, sizeof(PushConstants), 0);
 	pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
 	pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
 
 	VK_CHECK_RESULT(vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout));
 
-	VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
-	pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-	VK_CHECK_RESULT(vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &pipelineCache));
+	// Binding description
+	VkVertexInputBindingDescription meshBinding =
+		vks::initializers::vertexInputBindingDescription(0, (3 * sizeof(float)) + (3 * sizeof(float)), VK_VERTEX_INPUT_RATE_VERTEX);
+
+	// Attribute descriptions
+	std::vector<VkVertexInputAttributeDescription> meshAttributes = {
+		vks::initializers::vertexInputAttributeDescription(0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0), 					// Position
+		vks::initializers::vertexInputAttributeDescription(0, 1, VK_FORMAT_R32G32B32_SFLOAT, sizeof(float) * 3)		// Normal
+	};
+
+	// Vertex colors come from a buffer of their own so meshes without them keep the plain layout
+	std::vector<VkVertexInputAttributeDescription> colorAttributes = meshAttributes;
+	colorAttributes.push_back(vks::initializers::vertexInputAttributeDescription(1, 2, VK_FORMAT_R8G8B8A8_UNORM, 0));	// Color
+
+	std::vector<VkVertexInputBindingDescription> colorBindings = {
+		meshBinding,
+		vks::initializers::vertexInputBindingDescription(1, sizeof(uint32_t), VK_VERTEX_INPUT_RATE_VERTEX)
+	};
+
+	// Compact meshes have the same bindings with quantized attributes
+	VkVertexInputBindingDescription compactBinding =
+		vks::initializers::vertexInputBindingDescription(0, sizeof(CompactVertex), VK_VERTEX_INPUT_RATE_VERTEX);
 
-	// Create pipeline
+	std::vector<VkVertexInputAttributeDescription> compactAttributes = {
+		vks::initializers::vertexInputAttributeDescription(0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(CompactVertex, position)),	// Position
+		vks::initializers::vertexInputAttributeDescription(0, 1, VK_FORMAT_R16G16_SNORM, offsetof(CompactVertex, normal))			// Normal
+	};
+
+	std::vector<VkVertexInputAttributeDescription> compactColorAttributes = compactAttributes;
+	compactColorAttributes.push_back(colorAttributes.back());
+
+	std::vector<VkVertexInputBindingDescription> compactColorBindings = {
+		compactBinding,
+		vks::initializers::vertexInputBindingDescription(1, sizeof(uint32_t), VK_VERTEX_INPUT_RATE_VERTEX)
+	};
+
+	const VkPrimitiveTopology triangles = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	pipeline = buildPipeline(vertexShader, fragmentShader, { meshBinding }, meshAttributes);
+	colorPipeline = buildPipeline(colorVertexShader, fragmentShader, colorBindings, colorAttributes);
+	compactPipeline = buildPipeline(compactVertexShader, fragmentShader, { compactBinding }, compactAttributes);
+	compactColorPipeline = buildPipeline(compactColorVertexShader, fragmentShader, compactColorBindings, compactColorAttributes);
+
+	closedPipeline = buildPipeline(vertexShader, fragmentShader, { meshBinding }, meshAttributes, triangles, nullptr, VK_CULL_MODE_BACK_BIT);
+	closedColorPipeline = buildPipeline(colorVertexShader, fragmentShader, colorBindings, colorAttributes, triangles, nullptr, VK_CULL_MODE_BACK_BIT);
+	closedCompactPipeline = buildPipeline(compactVertexShader, fragmentShader, { compactBinding }, compactAttributes, triangles, nullptr, VK_CULL_MODE_BACK_BIT);
+	closedCompactColorPipeline = buildPipeline(compactColorVertexShader, fragmentShader, compactColorBindings, compactColorAttributes, triangles, nullptr, VK_CULL_MODE_BACK_BIT);
+
+	// Template meshes use the same vertex layout, each instance record is read once per instance from binding 1
+	std::vector<VkVertexInputAttributeDescription> instanceAttributes = meshAttributes;
+	for (uint32_t row = 0; row < 3; ++row) {
+		instanceAttributes.push_back(vks::initializers::vertexInputAttributeDescription(1, 2 + row, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(PrimitiveInstance, transform) + row * sizeof(glm::vec4)));	// Transform
+	}
+
+	instancePipeline = buildPipeline(instanceVertexShader, fragmentShader, {
+		meshBinding,
+		vks::initializers::vertexInputBindingDescription(1, sizeof(PrimitiveInstance), VK_VERTEX_INPUT_RATE_INSTANCE)
+	}, instanceAttributes);
+
+	// Lines and points use the mesh vertex layout as well
+	linePipeline = buildPipeline(vertexShader, fragmentShader, { meshBinding }, meshAttributes, VK_PRIMITIVE_TOPOLOGY_LINE_LIST);
+
+	// The point size is a specialization constant of the point vertex shader
+	VkSpecializationMapEntry pointSizeEntry = vks::initializers::specializationMapEntry(0, 0, sizeof(float));
+	VkSpecializationInfo pointSpecialization = vks::initializers::specializationInfo(1, &pointSizeEntry, sizeof(float), &pointSize);
+
+	pointPipeline = buildPipeline(pointVertexShader, fragmentShader, { meshBinding }, meshAttributes, VK_PRIMITIVE_TOPOLOGY_POINT_LIST, &pointSpecialization);
+}
+
+VkPipeline HeadlessRenderer::buildPipeline(VkShaderModule vertexModule, VkShaderModule fragmentModule, const std::vector<VkVertexInputBindingDescription>& vertexInputBindings, const std::vector<VkVertexInputAttributeDescription>& vertexInputAttributes,
+	VkPrimitiveTopology topology, const VkSpecializationInfo* vertexSpecialization, VkCullModeFlags cullMode) {
 	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState =
-		vks::initializers::pipelineInputAssemblyStateCreateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
+		vks::initializers::pipelineInputAssemblyStateCreateInfo(topology, 0, VK_FALSE);
 
+	// Faces wound counter-clockwise around their outward normal stay counter-clockwise in the framebuffer under a y
+	// flipping projection like V3dModel's
 	VkPipelineRasterizationStateCreateInfo rasterizationState =
-		vks::initializers::pipelineRasterizationStateCreateInfo(VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE, VK_FRONT_FACE_CLOCKWISE);
+		vks::initializers::pipelineRasterizationStateCreateInfo(VK_POLYGON_MODE_FILL, cullMode, VK_FRONT_FACE_COUNTER_CLOCKWISE);
 
 	VkPipelineColorBlendAttachmentState blendAttachmentState =
 		vks::initializers::pipelineColorBlendAttachmentState(0xf, VK_FALSE);
@@ -505,18 +793,6 @@ void HeadlessRenderer::createGraphicsPipeline() {
 	pipelineCreateInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
 	pipelineCreateInfo.pStages = shaderStages.data();
 
-	// Vertex bindings an attributes
-	// Binding description
-	std::vector<VkVertexInputBindingDescription> vertexInputBindings = {
-		vks::initializers::vertexInputBindingDescription(0, (3 * sizeof(float)) + (3 * sizeof(float)), VK_VERTEX_INPUT_RATE_VERTEX),
-	};
-
-	// Attribute descriptions
-	std::vector<VkVertexInputAttributeDescription> vertexInputAttributes = {
-		vks::initializers::vertexInputAttributeDescription(0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0), 					// Position
-		vks::initializers::vertexInputAttributeDescription(0, 1, VK_FORMAT_R32G32B32_SFLOAT, sizeof(float) * 3)		// Normal
-	};
-
 	VkPipelineVertexInputStateCreateInfo vertexInputState = vks::initializers::pipelineVertexInputStateCreateInfo();
 	vertexInputState.vertexBindingDescriptionCount = static_cast<uint32_t>(vertexInputBindings.size());
 	vertexInputState.pVertexBindingDescriptions = vertexInputBindings.data();
@@ -532,24 +808,154 @@ void HeadlessRenderer::createGraphicsPipeline() {
 	shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
 	shaderStages[1].pName = "main";
 
-	shaderStages[0].module = vks::tools::loadShader((shaderPath + "vertex.spv").c_str(), device);
-	shaderStages[1].module = vks::tools::loadShader((shaderPath + "fragment.spv").c_str(), device);
+	shaderStages[0].module = vertexModule;
+	shaderStages[0].pSpecializationInfo = vertexSpecialization;
+	shaderStages[1].module = fragmentModule;
+
+	VkPipeline result;
+	VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCreateInfo, nullptr, &result));
+
+	return result;
+}
+
+void HeadlessRenderer::resizeTarget(int targetWidth, int targetHeight) {
+	if (framebuffer != VK_NULL_HANDLE && targetWidth == framebufferWidth && targetHeight == framebufferHeight) {
+		return;
+	}
+
+	// Frames still in flight reference the old attachments
+	frameResources.waitIdle();
+	destroyAttachments();
+
+	createAttachments(targetWidth, targetHeight);
+	createFramebuffer(targetWidth, targetHeight);
+
+	framebufferWidth = targetWidth;
+	framebufferHeight = targetHeight;
+}
+
+void HeadlessRenderer::destroyAttachments() {
+	if (framebuffer == VK_NULL_HANDLE) {
+		return;
+	}
+
+	vkDestroyFramebuffer(device, framebuffer, nullptr);
+	vkDestroyImageView(device, colorAttachment.view, nullptr);
+	vkDestroyImage(device, colorAttachment.image, nullptr);
+	vkFreeMemory(device, colorAttachment.memory, nullptr);
+	vkDestroyImageView(device, depthAttachment.view, nullptr);
+	vkDestroyImage(device, depthAttachment.image, nullptr);
+	vkFreeMemory(device, depthAttachment.memory, nullptr);
+
+	framebuffer = VK_NULL_HANDLE;
+	framebufferWidth = 0;
+	framebufferHeight = 0;
+}
+
+void HeadlessRenderer::resizeReadbackBuffer(ReadbackSlot& slot, int targetWidth, int targetHeight) {
+	if (slot.buffer != VK_NULL_HANDLE && slot.width == targetWidth && slot.height == targetHeight) {
+		return;
+	}
+
+	if (slot.buffer != VK_NULL_HANDLE) {
+		vkUnmapMemory(device, slot.memory);
+		vkDestroyBuffer(device, slot.buffer, nullptr);
+		vkFreeMemory(device, slot.memory, nullptr);
+	}
+
+	VkDeviceSize size = static_cast<VkDeviceSize>(targetWidth) * targetHeight * 4;
+
+	createBuffer(
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		&slot.buffer,
+		&slot.memory,
+		size
+	);
+
+	VK_CHECK_RESULT(vkMapMemory(device, slot.memory, 0, VK_WHOLE_SIZE, 0, (void**)&slot.mapped));
+
+	slot.width = targetWidth;
+	slot.height = targetHeight;
+}
+
+void HeadlessRenderer::destroyReadbackSlots() {
+	for (auto& slot : readbackSlots) {
+		if (slot.buffer != VK_NULL_HANDLE) {
+			vkUnmapMemory(device, slot.memory);
+			vkDestroyBuffer(device, slot.buffer, nullptr);
+			vkFreeMemory(device, slot.memory, nullptr);
+		}
+
+		slot = ReadbackSlot{ };
+	}
+}
+
+void HeadlessRenderer::recordInstances(VkCommandBuffer commandBuffer, const GpuGeometry& geometry, float pixelSize) {
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, instancePipeline);
+
+	VkDeviceSize offsets[1] = { 0 };
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &templateVertexBuffer, offsets);
+	vkCmdBindIndexBuffer(commandBuffer, templateIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+	for (uint32_t templateIndex = 0; templateIndex < INSTANCE_TEMPLATE_COUNT; ++templateIndex) {
+		const InstanceSet& set = geometry.instances[templateIndex];
+
+		if (set.radii.empty()) {
+			continue;
+		}
+
+		vkCmdBindVertexBuffers(commandBuffer, 1, 1, &set.buffer, offsets);
+
+		// Instances are sorted by radius, so the instances of one level of detail are a contiguous range
+		uint32_t first = 0;
+		for (uint32_t lod = 0; lod < TEMPLATE_LOD_COUNT; ++lod) {
+			uint32_t last = static_cast<uint32_t>(set.radii.size());
 
-	shaderModules = { shaderStages[0].module, shaderStages[1].module };
-	VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipeline));
+			if (lod + 1 < TEMPLATE_LOD_COUNT) {
+				float minRadius = TEMPLATE_LOD_MIN_RADIUS[lod + 1] * pixelSize;
+				last = static_cast<uint32_t>(std::lower_bound(set.radii.begin() + first, set.radii.end(), minRadius) - set.radii.begin());
+			}
+
+			if (last > first) {
+				const TemplateLod& mesh = templateLods[templateIndex][lod];
+				vkCmdDrawIndexed(commandBuffer, mesh.indexCount, last - first, mesh.firstIndex, mesh.vertexOffset, first);
+			}
+
+			first = last;
+		}
+	}
 }
 
-void HeadlessRenderer::recordCommandBuffer(int targetWidth, int targetHeight, size_t indexCount, const glm::mat4& mvp) {
-	VkCommandBuffer commandBuffer;
-	VkCommandBufferAllocateInfo cmdBufAllocateInfo =
-		vks::initializers::commandBufferAllocateInfo(commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
-	VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &commandBuffer));
+void HeadlessRenderer::recordIndexedDraws(VkCommandBuffer commandBuffer, VkBuffer indexBuffer, VkIndexType indexType, const std::vector<IndexChunk>& chunks) {
+	vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, indexType);
 
-	VkCommandBufferBeginInfo cmdBufInfo =
-		vks::initializers::commandBufferBeginInfo();
+	for (const IndexChunk& chunk : chunks) {
+		vkCmdDrawIndexed(commandBuffer, chunk.indexCount, 1, chunk.firstIndex, chunk.vertexOffset, 0);
+	}
+}
 
-	VK_CHECK_RESULT(vkBeginCommandBuffer(commandBuffer, &cmdBufInfo));
+void HeadlessRenderer::recordLinesAndPoints(VkCommandBuffer commandBuffer, const GpuGeometry& geometry) {
+	if (geometry.lineVertexBuffer == VK_NULL_HANDLE) {
+		return;
+	}
+
+	VkDeviceSize offsets[1] = { 0 };
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &geometry.lineVertexBuffer, offsets);
+
+	// One draw per topology, however many objects the lines and points came from
+	if (geometry.lineIndexCount > 0) {
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, linePipeline);
+		recordIndexedDraws(commandBuffer, geometry.lineIndexBuffer, geometry.lineIndexType, geometry.lineIndexChunks);
+	}
+
+	if (geometry.pointCount > 0) {
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pointPipeline);
+		vkCmdDraw(commandBuffer, geometry.pointCount, 1, geometry.firstPoint, 0);
+	}
+}
 
+void HeadlessRenderer::recordCommandBuffer(VkCommandBuffer commandBuffer, const ReadbackSlot& slot, int targetWidth, int targetHeight, const GpuGeometry& geometry, const glm::mat4& mvp, float pixelSize, uint32_t lod) {
 	VkClearValue clearValues[2];
 	clearValues[0].color = { { 1.0f, 1.0f, 1.0f, 1.0f } };
 	clearValues[1].depthStencil = { 1.0f, 0 };
@@ -579,175 +985,124 @@ void HeadlessRenderer::recordCommandBuffer(int targetWidth, int targetHeight, si
 	scissor.extent.height = targetHeight;
 	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	// All pipelines share the layout, so the push constant stays bound across the pipeline switch
+	PushConstants pushConstants{ mvp, geometry.positionOffset, geometry.positionScale };
+	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(pushConstants), &pushConstants);
 
 	// Render scene
-	VkDeviceSize offsets[1] = { 0 };
-	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, offsets);
-	vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+	if (geometry.indexCount > 0) {
+		VkDeviceSize offsets[1] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &geometry.vertexBuffer, offsets);
+
+		bool compact = geometry.vertexFormat == VertexFormat::Compact;
+		bool drawLod = lod > 0 && !geometry.lods.empty();
+
+		// Simplification may fold triangles over, so the levels of detail keep both faces. A projection that does not flip y
+		// mirrors the winding and the mvp's determinant turns negative, its frames keep both faces as well.
+		bool cullBackFaces = geometry.closed && !drawLod && glm::determinant(mvp) > 0.0f;
+
+		if (geometry.colorBuffer != VK_NULL_HANDLE) {
+			VkPipeline colorMeshPipeline = compact ? (cullBackFaces ? closedCompactColorPipeline : compactColorPipeline) : (cullBackFaces ? closedColorPipeline : colorPipeline);
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, colorMeshPipeline);
+			vkCmdBindVertexBuffers(commandBuffer, 1, 1, &geometry.colorBuffer, offsets);
+		} else {
+			VkPipeline meshPipeline = compact ? (cullBackFaces ? closedCompactPipeline : compactPipeline) : (cullBackFaces ? closedPipeline : pipeline);
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, meshPipeline);
+		}
 
-	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(mvp), &mvp);
-	vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+		if (drawLod) {
+			const MeshLod& level = geometry.lods[std::min<size_t>(lod, geometry.lods.size()) - 1];
+			recordIndexedDraws(commandBuffer, level.indexBuffer, level.indexType, level.indexChunks);
+		} else if (geometry.clusters.empty()) {
+			recordIndexedDraws(commandBuffer, geometry.indexBuffer, geometry.indexType, geometry.indexChunks);
+		} else {
+			std::vector<IndexChunk> visible;
+			cullMeshClusters(geometry.clusters, mvp, cullBackFaces, visible);
+			recordIndexedDraws(commandBuffer, geometry.indexBuffer, geometry.indexType, visible);
+		}
+	}
 
-	vkCmdEndRenderPass(commandBuffer);
-	VK_CHECK_RESULT(vkEndCommandBuffer(commandBuffer));
-	submitWork(commandBuffer, queue);
+	recordInstances(commandBuffer, geometry, pixelSize);
+	recordLinesAndPoints(commandBuffer, geometry);
 
-	vkDeviceWaitIdle(device);
-}
+	vkCmdEndRenderPass(commandBuffer);
 
-unsigned char* HeadlessRenderer::copyToHost(int targetWidth, int targetHeight, VkSubresourceLayout* imageSubresourceLayout) {
-	// Copy framebuffer image to host visible image
-	const char* imagedata;
-	unsigned char* returnData;
-	
-	// Create the linear tiled destination image to copy to and to read the memory from
-	VkImageCreateInfo imgCreateInfo(vks::initializers::imageCreateInfo());
-	imgCreateInfo.imageType = VK_IMAGE_TYPE_2D;
-	imgCreateInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
-	imgCreateInfo.extent.width = targetWidth;
-	imgCreateInfo.extent.height = targetHeight;
-	imgCreateInfo.extent.depth = 1;
-	imgCreateInfo.arrayLayers = 1;
-	imgCreateInfo.mipLevels = 1;
-	imgCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	imgCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-	imgCreateInfo.tiling = VK_IMAGE_TILING_LINEAR;
-	imgCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-	// Create the image
-	VkImage dstImage;
-	VK_CHECK_RESULT(vkCreateImage(device, &imgCreateInfo, nullptr, &dstImage));
-	// Create memory to back up the image
-	VkMemoryRequirements memRequirements;
-	VkMemoryAllocateInfo memAllocInfo(vks::initializers::memoryAllocateInfo());
-	VkDeviceMemory dstImageMemory;
-	vkGetImageMemoryRequirements(device, dstImage, &memRequirements);
-	memAllocInfo.allocationSize = memRequirements.size;
-	// Memory must be host visible to copy from
-	memAllocInfo.memoryTypeIndex = getMemoryTypeIndex(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-	VK_CHECK_RESULT(vkAllocateMemory(device, &memAllocInfo, nullptr, &dstImageMemory));
-	VK_CHECK_RESULT(vkBindImageMemory(device, dstImage, dstImageMemory, 0));
-
-	// Do the actual blit from the offscreen image to our host visible destination image
-	VkCommandBufferAllocateInfo cmdBufAllocateInfo = vks::initializers::commandBufferAllocateInfo(commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
-	VkCommandBuffer copyCmd;
-	VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &copyCmd));
-	VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
-	VK_CHECK_RESULT(vkBeginCommandBuffer(copyCmd, &cmdBufInfo));
-
-	// Transition destination image to transfer destination layout
-	vks::tools::insertImageMemoryBarrier(
-		copyCmd,
-		dstImage,
-		0,
-		VK_ACCESS_TRANSFER_WRITE_BIT,
-		VK_IMAGE_LAYOUT_UNDEFINED,
-		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 });
-
-	// colorAttachment.image is already in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, and does not need to be transitioned
-
-	VkImageCopy imageCopyRegion{};
-	imageCopyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	imageCopyRegion.srcSubresource.layerCount = 1;
-	imageCopyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	imageCopyRegion.dstSubresource.layerCount = 1;
-	imageCopyRegion.extent.width = targetWidth;
-	imageCopyRegion.extent.height = targetHeight;
-	imageCopyRegion.extent.depth = 1;
-
-	vkCmdCopyImage(
-		copyCmd,
-		colorAttachment.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-		dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		1,
-		&imageCopyRegion);
-
-	// Transition destination image to general layout, which is the required layout for mapping the image memory later on
-	vks::tools::insertImageMemoryBarrier(
-		copyCmd,
-		dstImage,
-		VK_ACCESS_TRANSFER_WRITE_BIT,
-		VK_ACCESS_MEMORY_READ_BIT,
-		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		VK_IMAGE_LAYOUT_GENERAL,
+	// colorAttachment.image is left in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL by the render pass
+	VkBufferImageCopy copyRegion{};
+	copyRegion.bufferOffset = 0;
+	copyRegion.bufferRowLength = 0;
+	copyRegion.bufferImageHeight = 0;
+	copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	copyRegion.imageSubresource.layerCount = 1;
+	copyRegion.imageExtent.width = targetWidth;
+	copyRegion.imageExtent.height = targetHeight;
+	copyRegion.imageExtent.depth = 1;
+
+	vkCmdCopyImageToBuffer(commandBuffer, colorAttachment.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer, 1, &copyRegion);
+
+	// Make the copied pixels visible to the host once the fence is signaled
+	VkBufferMemoryBarrier hostBarrier = vks::initializers::bufferMemoryBarrier();
+	hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	hostBarrier.buffer = slot.buffer;
+	hostBarrier.offset = 0;
+	hostBarrier.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(
+		commandBuffer,
 		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 });
-
-	VK_CHECK_RESULT(vkEndCommandBuffer(copyCmd));
-
-	submitWork(copyCmd, queue);
+		VK_PIPELINE_STAGE_HOST_BIT,
+		0,
+		0, nullptr,
+		1, &hostBarrier,
+		0, nullptr);
+}
 
-	// Get layout of the image (including row pitch)
-	VkImageSubresource subResource{};
-	subResource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	VkSubresourceLayout subResourceLayout;
+HeadlessRenderer::FrameTicket HeadlessRenderer::submitFrame(int targetWidth, int targetHeight, const GeometryHandle& geometry, const glm::mat4& mvp, float pixelSize, uint32_t lod) {
+	resizeTarget(targetWidth, targetHeight);
 
-	vkGetImageSubresourceLayout(device, dstImage, &subResource, &subResourceLayout);
+	uint32_t slotIndex = nextReadbackSlot;
+	nextReadbackSlot = (nextReadbackSlot + 1) % READBACK_SLOT_COUNT;
 
-	*imageSubresourceLayout = subResourceLayout;
+	ReadbackSlot& slot = readbackSlots[slotIndex];
+	GpuGeometry& gpuGeometry = geometries.at(geometry.id());
 
-	// Map image memory so we can start copying from it
-	vkMapMemory(device, dstImageMemory, 0, VK_WHOLE_SIZE, 0, (void**)&imagedata);
-	imagedata += subResourceLayout.offset;
+	// Waits for the slot's previous frame before its command buffer and readback buffer are reused
+	VkCommandBuffer commandBuffer = frameResources.beginFrame(slotIndex);
 
-	returnData = new unsigned char[imageSubresourceLayout->size];
+	resizeReadbackBuffer(slot, targetWidth, targetHeight);
 
-	std::memcpy(returnData, imagedata, imageSubresourceLayout->size);
+	recordCommandBuffer(commandBuffer, slot, targetWidth, targetHeight, gpuGeometry, mvp, pixelSize, lod);
 
-	// Clean up resources
-	vkUnmapMemory(device, dstImageMemory);
-	vkFreeMemory(device, dstImageMemory, nullptr);
-	vkDestroyImage(device, dstImage, nullptr);
+	uint64_t submission = frameResources.submitFrame(slotIndex, queue);
+	gpuGeometry.lastSubmission = submission;
 
-	return returnData;
+	return FrameTicket{ slotIndex, submission };
 }
 
-void HeadlessRenderer::cleanup() {
-	vkDestroyBuffer(device, vertexBuffer, nullptr);
-	vkFreeMemory(device, vertexMemory, nullptr);
-	vkDestroyBuffer(device, indexBuffer, nullptr);
-	vkFreeMemory(device, indexMemory, nullptr);
-	vkDestroyImageView(device, colorAttachment.view, nullptr);
-	vkDestroyImage(device, colorAttachment.image, nullptr);
-	vkFreeMemory(device, colorAttachment.memory, nullptr);
-	vkDestroyImageView(device, depthAttachment.view, nullptr);
-	vkDestroyImage(device, depthAttachment.image, nullptr);
-	vkFreeMemory(device, depthAttachment.memory, nullptr);
-	vkDestroyRenderPass(device, renderPass, nullptr);
-	vkDestroyFramebuffer(device, framebuffer, nullptr);
-	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
-	vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
-	vkDestroyPipeline(device, pipeline, nullptr);
-	vkDestroyPipelineCache(device, pipelineCache, nullptr);
+bool HeadlessRenderer::readFrame(const FrameTicket& ticket, unsigned char* destination, size_t destinationBytesPerLine) {
+	ReadbackSlot& slot = readbackSlots[ticket.slot];
 
-	for (auto shadermodule : shaderModules) {
-		vkDestroyShaderModule(device, shadermodule, nullptr);
+	if (frameResources.frame(ticket.slot).submission != ticket.submission) {
+		return false;
 	}
-}
-
-unsigned char* HeadlessRenderer::render(int targetWidth, int targetHeight, VkSubresourceLayout* imageSubresourceLayout, const std::vector<float>& vertices, const std::vector<unsigned int>& indices, const glm::mat4& mvp) {	
-	copyVertexDataToGPU(vertices);
-	copyIndexDataToGPU(indices);
-
-	VkFormat colorFormat = VK_FORMAT_R8G8B8A8_UNORM;
-	VkFormat depthFormat;
-	vks::tools::getSupportedDepthFormat(physicalDevice, &depthFormat);
-
-	createAttachments(colorFormat, depthFormat, targetWidth, targetHeight);
-	createRenderPipeline(colorFormat, depthFormat, targetWidth, targetHeight);
-	createGraphicsPipeline();
 
-	recordCommandBuffer(targetWidth, targetHeight, indices.size(), mvp);
+	frameResources.waitForFrame(ticket.slot);
 
-	unsigned char* returnData = copyToHost(targetWidth, targetHeight, imageSubresourceLayout);
+	size_t rowBytes = static_cast<size_t>(slot.width) * 4;
 
-	vkQueueWaitIdle(queue);
+	if (destinationBytesPerLine == rowBytes) {
+		std::memcpy(destination, slot.mapped, rowBytes * slot.height);
+	} else {
+		for (int y = 0; y < slot.height; ++y) {
+			std::memcpy(destination + y * destinationBytesPerLine, slot.mapped + y * rowBytes, rowBytes);
+		}
+	}
 
-	cleanup();
+	return true;
+}
 
-	return returnData;
+void HeadlessRenderer::render(int targetWidth, int targetHeight, const GeometryHandle& geometry, const glm::mat4& mvp, float pixelSize, unsigned char* destination, size_t destinationBytesPerLine, uint32_t lod) {
+	FrameTicket ticket = submitFrame(targetWidth, targetHeight, geometry, mvp, pixelSize, lod);
+	readFrame(ticket, destination, destinationBytesPerLine);
 }
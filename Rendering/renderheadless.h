@@ -8,6 +8,7 @@
 #include <array>
 #include <iostream>
 #include <algorithm>
+#include <unordered_map>
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -17,12 +18,18 @@
 #include <vulkan/vulkan.h>
 #include "../3rdParty/VulkanTools/VulkanTools.h"
 
+#include "GeometryHandle.h"
+#include "FrameResources.h"
+#include "PipelineCacheFile.h"
+#include "TemplateMeshes.h"
+#include "CompactVertices.h"
+#include "IndexChunks.h"
+#include "MeshClusters.h"
+
 #define DEBUG (!NDEBUG)
 
 #define BUFFER_ELEMENTS 32
 
-#define LOG(...) printf(__VA_ARGS__)
-
 #define VULKAN_DEBUG 1
 
 class HeadlessRenderer
@@ -39,13 +46,140 @@ public:
 	VkDescriptorSetLayout descriptorSetLayout;
 	VkPipelineLayout pipelineLayout;
 	VkPipeline pipeline;
+	VkPipeline colorPipeline;
+	VkPipeline compactPipeline;
+	VkPipeline compactColorPipeline;
+	// The four mesh pipelines again with back faces culled, for closed meshes
+	VkPipeline closedPipeline;
+	VkPipeline closedColorPipeline;
+	VkPipeline closedCompactPipeline;
+	VkPipeline closedCompactColorPipeline;
+	VkPipeline instancePipeline;
+	VkPipeline linePipeline;
+	VkPipeline pointPipeline;
 	std::vector<VkShaderModule> shaderModules;
 
-	VkBuffer vertexBuffer;
-	VkDeviceMemory vertexMemory;
+	VkShaderModule vertexShader;
+	VkShaderModule colorVertexShader;
+	VkShaderModule compactVertexShader;
+	VkShaderModule compactColorVertexShader;
+	VkShaderModule instanceVertexShader;
+	VkShaderModule pointVertexShader;
+	VkShaderModule fragmentShader;
+
+	// Hash of every SPIR-V module the pipelines are built from, part of the pipeline cache file key
+	uint64_t shaderHash{ hashBytes(nullptr, 0) };
+
+	PipelineCacheFile pipelineCacheFile;
+
+	// Instances of one template, sorted by radius so each level of detail is a contiguous range
+	struct InstanceSet {
+		VkBuffer buffer{ VK_NULL_HANDLE };
+		VkDeviceMemory memory{ VK_NULL_HANDLE };
+
+		std::vector<float> radii;
+	};
+
+	// Index buffer of a simplified version of a mesh
+	struct MeshLod {
+		VkBuffer indexBuffer{ VK_NULL_HANDLE };
+		VkDeviceMemory indexMemory{ VK_NULL_HANDLE };
+
+		VkIndexType indexType{ VK_INDEX_TYPE_UINT32 };
+		std::vector<IndexChunk> indexChunks;
+	};
+
+	// Device local vertex and index buffers of a mesh uploaded through uploadGeometry
+	struct GpuGeometry {
+		VkBuffer vertexBuffer{ VK_NULL_HANDLE };
+		VkDeviceMemory vertexMemory{ VK_NULL_HANDLE };
+
+		VkBuffer indexBuffer{ VK_NULL_HANDLE };
+		VkDeviceMemory indexMemory{ VK_NULL_HANDLE };
+
+		uint32_t indexCount{ 0 };
+
+		// 16 bit whenever the mesh splits into chunks of at most 65536 vertices, a single chunk at offset 0 otherwise
+		VkIndexType indexType{ VK_INDEX_TYPE_UINT32 };
+		std::vector<IndexChunk> indexChunks;
+
+		// The chunks split further into clusters the CPU culls against the view every frame, empty for small meshes
+		std::vector<MeshCluster> clusters;
+
+		// Closed and opaque, see isClosedMesh. Drawn with back faces culled, and clusters facing away are dropped as well.
+		bool closed{ false };
+
+		// Coarser index lists over the same vertices, finest first, drawn instead of the mesh while it is being dragged
+		std::vector<MeshLod> lods;
+
+		// Compact meshes are dequantized in the vertex shader from the bounds in the push constants
+		VertexFormat vertexFormat{ VertexFormat::Float };
+		glm::vec4 positionOffset{ 0.0f };
+		glm::vec4 positionScale{ 1.0f };
+
+		// Packed RGBA8 per vertex in binding 1, only allocated for meshes with vertex colors
+		VkBuffer colorBuffer{ VK_NULL_HANDLE };
+		VkDeviceMemory colorMemory{ VK_NULL_HANDLE };
+
+		std::array<InstanceSet, INSTANCE_TEMPLATE_COUNT> instances;
+
+		// Lines and points share one vertex buffer, the points follow the line vertices
+		VkBuffer lineVertexBuffer{ VK_NULL_HANDLE };
+		VkDeviceMemory lineVertexMemory{ VK_NULL_HANDLE };
+
+		VkBuffer lineIndexBuffer{ VK_NULL_HANDLE };
+		VkDeviceMemory lineIndexMemory{ VK_NULL_HANDLE };
 
-	VkBuffer indexBuffer;
-	VkDeviceMemory indexMemory;
+		uint32_t lineIndexCount{ 0 };
+		VkIndexType lineIndexType{ VK_INDEX_TYPE_UINT32 };
+		std::vector<IndexChunk> lineIndexChunks;
+		uint32_t firstPoint{ 0 };
+		uint32_t pointCount{ 0 };
+
+		// Last frame submission that draws this geometry
+		uint64_t lastSubmission{ 0 };
+	};
+
+	// Push constant block shared by every pipeline, the position bounds are only read by the compact mesh shaders
+	struct PushConstants {
+		glm::mat4 mvp;
+		glm::vec4 positionOffset;
+		glm::vec4 positionScale;
+	};
+
+	std::unordered_map<uint32_t, GpuGeometry> geometries;
+	uint32_t nextGeometryId{ 1 };
+
+	// Unit meshes shared by every instanced primitive, uploaded once with the renderer
+	std::array<std::array<TemplateLod, TEMPLATE_LOD_COUNT>, INSTANCE_TEMPLATE_COUNT> templateLods;
+
+	VkBuffer templateVertexBuffer{ VK_NULL_HANDLE };
+	VkDeviceMemory templateVertexMemory{ VK_NULL_HANDLE };
+	VkBuffer templateIndexBuffer{ VK_NULL_HANDLE };
+	VkDeviceMemory templateIndexMemory{ VK_NULL_HANDLE };
+
+	// Persistently mapped host buffer the color attachment is copied into at the end of a frame
+	struct ReadbackSlot {
+		VkBuffer buffer{ VK_NULL_HANDLE };
+		VkDeviceMemory memory{ VK_NULL_HANDLE };
+		unsigned char* mapped{ nullptr };
+		int width{ 0 };
+		int height{ 0 };
+	};
+
+	static constexpr uint32_t READBACK_SLOT_COUNT = 2;
+
+	// Each readback slot is recorded and submitted with the frame resources of the same index
+	std::array<ReadbackSlot, READBACK_SLOT_COUNT> readbackSlots;
+	uint32_t nextReadbackSlot{ 0 };
+
+	FrameResources frameResources;
+
+	// Identifies a submitted frame, becomes stale once its slot is reused by a later frame
+	struct FrameTicket {
+		uint32_t slot{ 0 };
+		uint64_t submission{ 0 };
+	};
 
 	struct FrameBufferAttachment {
 		VkImage image;
@@ -53,39 +187,86 @@ public:
 		VkImageView view;
 	};
 
-	VkFramebuffer framebuffer;
-	FrameBufferAttachment colorAttachment, depthAttachment;
+	VkFramebuffer framebuffer{ VK_NULL_HANDLE };
+	FrameBufferAttachment colorAttachment{ }, depthAttachment{ };
 	VkRenderPass renderPass;
 
+	VkFormat colorFormat{ VK_FORMAT_R8G8B8A8_UNORM };
+	VkFormat depthFormat;
+
+	// Size of the current attachments and framebuffer, these are only rebuilt when the target size changes
+	int framebufferWidth{ 0 };
+	int framebufferHeight{ 0 };
+
+	// Size in pixels pixels are drawn with, clamped to what the device supports
+	static constexpr float PIXEL_POINT_SIZE = 2.0f;
+	float pointSize{ 1.0f };
+
 	std::string shaderPath;
 
+	// Validation messages of this renderer's instance, only created with VULKAN_DEBUG when the validation layer is installed
 	VkDebugReportCallbackEXT debugReportCallback{};
 
 	HeadlessRenderer(std::string shaderPath);
 	~HeadlessRenderer();
 
 private:
+	static VKAPI_ATTR VkBool32 VKAPI_CALL debugMessageCallback(VkDebugReportFlagsEXT flags, VkDebugReportObjectTypeEXT objectType, uint64_t object,
+		size_t location, int32_t messageCode, const char* pLayerPrefix, const char* pMessage, void* pUserData);
+
 	void createInstance();
 	void createPhysicalDevice();
 	VkDeviceQueueCreateInfo requestGraphicsQueue();
 	void createLogicalDevice(VkDeviceQueueCreateInfo* queueCreateInfo);
-	void copyVertexDataToGPU(const std::vector<float>& vertices);
-	void copyIndexDataToGPU(const std::vector<unsigned int>& indices);
-	void createAttachments(VkFormat colorFormat, VkFormat depthFormat, int targetWidth, int targetHeight);
-	void createRenderPipeline(VkFormat colorFormat, VkFormat depthFormat, int targetWidth, int targetHeight);
+	void copyDataToGPU(VkCommandBuffer copyCmd, VkBufferUsageFlags usageFlags, const void* data, VkDeviceSize size, VkBuffer* buffer, VkDeviceMemory* memory);
+	void createAttachments(int targetWidth, int targetHeight);
+	void createFramebuffer(int targetWidth, int targetHeight);
+	void createRenderPass();
+	VkShaderModule loadShader(const std::string& fileName);
+	void createShaderModules();
+	VkPipeline buildPipeline(VkShaderModule vertexModule, VkShaderModule fragmentModule, const std::vector<VkVertexInputBindingDescription>& vertexInputBindings, const std::vector<VkVertexInputAttributeDescription>& vertexInputAttributes,
+		VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, const VkSpecializationInfo* vertexSpecialization = nullptr, VkCullModeFlags cullMode = VK_CULL_MODE_NONE);
 	void createGraphicsPipeline();
-	void recordCommandBuffer(int targetWidth, int targetHeight, size_t indexCount, const glm::mat4& mvp);
-	unsigned char* copyToHost(int targetWidth, int targetHeight, VkSubresourceLayout* imageSubresourceLayout);
+	void uploadTemplateMeshes();
+	void uploadIndices(VkCommandBuffer copyCmd, const std::vector<unsigned int>& indices, uint32_t primitiveSize, VkBuffer* buffer, VkDeviceMemory* memory,
+		VkIndexType& indexType, std::vector<IndexChunk>& chunks);
+	void recordIndexedDraws(VkCommandBuffer commandBuffer, VkBuffer indexBuffer, VkIndexType indexType, const std::vector<IndexChunk>& chunks);
+	void resizeTarget(int targetWidth, int targetHeight);
+	void destroyAttachments();
+	void resizeReadbackBuffer(ReadbackSlot& slot, int targetWidth, int targetHeight);
+	void destroyReadbackSlots();
+	void recordCommandBuffer(VkCommandBuffer commandBuffer, const ReadbackSlot& slot, int targetWidth, int targetHeight, const GpuGeometry& geometry, const glm::mat4& mvp, float pixelSize, uint32_t lod);
+	void recordInstances(VkCommandBuffer commandBuffer, const GpuGeometry& geometry, float pixelSize);
+	void recordLinesAndPoints(VkCommandBuffer commandBuffer, const GpuGeometry& geometry);
 
-	void cleanup();
+	// Hands the buffers to frameResources, which destroys them once the frames drawing them have finished
+	void releaseGeometry(GpuGeometry& geometry);
+	void releaseLods(GpuGeometry& geometry);
 
 public:
-	unsigned char* render(int targetWidth, int targetHeight, VkSubresourceLayout* imageSubresourceLayout, const std::vector<float>& vertices, const std::vector<unsigned int>& indices, const glm::mat4& mvp);
+	// Uploads a mesh, its instanced primitives, lines and points once into device local memory, it stays resident until the returned handle is destroyed.
+	// Line and point vertices have the same layout as the mesh vertices. colors is either empty or holds a packed RGBA8 color per mesh vertex.
+	// With VertexFormat::Compact the mesh vertices are quantized before the upload, lines and points always stay float.
+	GeometryHandle uploadGeometry(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, const std::vector<uint32_t>& colors = { }, const InstanceLists& instances = { },
+		const std::vector<float>& lineVertices = { }, const std::vector<unsigned int>& lineIndices = { }, const std::vector<float>& pointVertices = { },
+		VertexFormat vertexFormat = VertexFormat::Float);
+	void freeGeometry(uint32_t geometryId);
+
+	// Uploads simplified index lists over the mesh vertices of an uploaded geometry, finest first, replacing any uploaded before
+	void uploadLods(const GeometryHandle& geometry, const std::vector<std::vector<unsigned int>>& lodIndices);
+
+	// Records and submits a frame without waiting for it to finish. pixelSize is the size of a pixel in model
+	// units, it picks the level of detail of every instance. lod 0 draws the full mesh, higher ones its uploaded
+	// simplifications, clamped to the coarsest one there is.
+	FrameTicket submitFrame(int targetWidth, int targetHeight, const GeometryHandle& geometry, const glm::mat4& mvp, float pixelSize, uint32_t lod = 0);
+
+	// Waits for a submitted frame and copies its pixels into destination, returns false if the ticket is stale
+	bool readFrame(const FrameTicket& ticket, unsigned char* destination, size_t destinationBytesPerLine);
+
+	// Renders a frame and waits for its pixels, rows are written top to bottom into destination
+	void render(int targetWidth, int targetHeight, const GeometryHandle& geometry, const glm::mat4& mvp, float pixelSize, unsigned char* destination, size_t destinationBytesPerLine, uint32_t lod = 0);
 
 	uint32_t getMemoryTypeIndex(uint32_t typeBits, VkMemoryPropertyFlags properties);
 
 	VkResult createBuffer(VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, VkBuffer *buffer, VkDeviceMemory *memory, VkDeviceSize size, void *data = nullptr);
-    
-    // Submit command buffer to a queue and wait for fence until queue operations have been finished
-	void submitWork(VkCommandBuffer cmdBuffer, VkQueue queue);
 };
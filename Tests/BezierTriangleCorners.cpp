@@ -0,0 +1,87 @@
+// Checks that a cubic Bezier triangle in Asymptote's control point order is meshed with its corners on p[0], p[6] and
+// p[9], its corner colors on those corners, and its edge 0-1-3-6 on the cubic through those control points.
+
+#include <array>
+#include <cmath>
+#include <iostream>
+
+#include "../V3dFile/BezierPatchTessellator.h"
+
+namespace {
+
+int failures = 0;
+
+bool near(const TRIPLE& a, const TRIPLE& b) {
+	return glm::length(a - b) <= 1e-4f * (1.0f + glm::length(b));
+}
+
+TRIPLE vertexPosition(const MeshBuffer& mesh, size_t vertex) {
+	return TRIPLE{ mesh.vertices[6 * vertex], mesh.vertices[6 * vertex + 1], mesh.vertices[6 * vertex + 2] };
+}
+
+void checkPoint(const char* name, const TRIPLE& actual, const TRIPLE& expected) {
+	if (!near(actual, expected)) {
+		std::cout << "ERROR: " << name << " is at (" << actual.x << ", " << actual.y << ", " << actual.z << "), expected ("
+				  << expected.x << ", " << expected.y << ", " << expected.z << ")" << std::endl;
+		++failures;
+	}
+}
+
+void checkColor(const char* name, uint32_t actual, const RGBA& expected) {
+	if (actual != packColor(expected)) {
+		std::cout << "ERROR: " << name << " color is " << std::hex << actual << ", expected " << packColor(expected) << std::dec << std::endl;
+		++failures;
+	}
+}
+
+TRIPLE cubic(const TRIPLE& a, const TRIPLE& b, const TRIPLE& c, const TRIPLE& d, float t) {
+	float u = 1.0f - t;
+	return u * u * u * a + 3.0f * u * u * t * b + 3.0f * u * t * t * c + t * t * t * d;
+}
+
+}
+
+int main() {
+	// Rows of 1, 2, 3 and 4 points, bulged out of the plane so every direction has a second difference
+	std::array<TRIPLE, 10> net = {
+		TRIPLE{ 0.0f, 3.0f, 0.0f },
+		TRIPLE{ -0.5f, 2.0f, 0.4f }, TRIPLE{ 0.5f, 2.0f, -0.2f },
+		TRIPLE{ -1.0f, 1.0f, 0.3f }, TRIPLE{ 0.0f, 1.0f, 1.0f }, TRIPLE{ 1.0f, 1.0f, 0.6f },
+		TRIPLE{ -1.5f, 0.0f, 0.0f }, TRIPLE{ -0.5f, 0.0f, -0.5f }, TRIPLE{ 0.5f, 0.0f, 0.8f }, TRIPLE{ 1.5f, 0.0f, 0.0f }
+	};
+
+	BezierPatchDescriptor triangle{ };
+	std::copy(net.begin(), net.end(), triangle.controlPoints.begin());
+	triangle.tolerance = 0.01f;
+	triangle.triangle = true;
+	triangle.colored = true;
+	triangle.cornerColors = { RGBA{ 1.0f, 0.0f, 0.0f, 1.0f }, RGBA{ 0.0f, 1.0f, 0.0f, 1.0f }, RGBA{ 0.0f, 0.0f, 1.0f, 1.0f }, RGBA{ } };
+
+	MeshBuffer mesh;
+	tessellateBezierPatch(triangle, mesh);
+
+	// The grid has n + 1 vertices along its first row and (n + 1)(n + 2) / 2 in total, ending on the corner 9
+	size_t vertexCount = mesh.vertexCount();
+	size_t n = static_cast<size_t>(std::lround((std::sqrt(8.0 * double(vertexCount) + 1.0) - 3.0) / 2.0));
+
+	if (n < 2 || (n + 1) * (n + 2) / 2 != vertexCount || mesh.colors.size() != vertexCount) {
+		std::cout << "ERROR: " << vertexCount << " vertices and " << mesh.colors.size() << " colors do not form a triangular grid" << std::endl;
+		return 1;
+	}
+
+	checkPoint("corner p[0]", vertexPosition(mesh, 0), net[0]);
+	checkPoint("corner p[6]", vertexPosition(mesh, n), net[6]);
+	checkPoint("corner p[9]", vertexPosition(mesh, vertexCount - 1), net[9]);
+
+	checkColor("corner p[0]", mesh.colors[0], triangle.cornerColors[0]);
+	checkColor("corner p[6]", mesh.colors[n], triangle.cornerColors[1]);
+	checkColor("corner p[9]", mesh.colors[vertexCount - 1], triangle.cornerColors[2]);
+
+	for (size_t i = 1; i < n; ++i) {
+		checkPoint("edge 0-1-3-6", vertexPosition(mesh, i), cubic(net[0], net[1], net[3], net[6], float(i) / float(n)));
+	}
+
+	std::cout << "Bezier triangle corners: " << n << " segments, " << (failures ? "FAILED" : "passed") << std::endl;
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,163 @@
+// Renders a closed sphere, whose back faces and back facing clusters HeadlessRenderer drops, and the same sphere made
+// translucent, which it draws with both faces, and compares the images. From outside they must match, from inside the
+// closed one must show nothing. Needs a Vulkan device and the compiled shaders, without either it reports the check as
+// skipped.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../Rendering/renderheadless.h"
+#include "VulkanDevice.h"
+
+namespace {
+
+constexpr float PI = 3.14159265358979f;
+constexpr int WIDTH = 256;
+constexpr int HEIGHT = 256;
+const char* SHADER_PATH = "../shaders/";
+
+const glm::vec3 CENTER{ 2.0f, -1.0f, -6.0f };
+constexpr float RADIUS = 1.5f;
+
+struct Mesh {
+	std::vector<float> vertices;
+	std::vector<unsigned int> indices;
+};
+
+// Sphere of rings bands with single pole vertices and no seam, every face wound counter-clockwise seen from outside
+Mesh sphere(int rings, int segments) {
+	Mesh mesh;
+
+	auto addVertex = [&mesh](const glm::vec3& normal) {
+		glm::vec3 position = CENTER + RADIUS * normal;
+		mesh.vertices.insert(mesh.vertices.end(), { position.x, position.y, position.z, normal.x, normal.y, normal.z });
+	};
+
+	addVertex(glm::vec3{ 0.0f, 0.0f, 1.0f });
+	for (int r = 1; r < rings; ++r) {
+		float polar = PI * r / rings;
+		for (int s = 0; s < segments; ++s) {
+			float azimuth = 2.0f * PI * s / segments;
+			addVertex(glm::vec3{ std::sin(polar) * std::cos(azimuth), std::sin(polar) * std::sin(azimuth), std::cos(polar) });
+		}
+	}
+	addVertex(glm::vec3{ 0.0f, 0.0f, -1.0f });
+
+	auto ringVertex = [segments](int r, int s) {
+		return static_cast<unsigned int>(1 + (r - 1) * segments + s % segments);
+	};
+	unsigned int southPole = static_cast<unsigned int>(mesh.vertices.size() / 6 - 1);
+
+	for (int s = 0; s < segments; ++s) {
+		mesh.indices.insert(mesh.indices.end(), { 0, ringVertex(1, s), ringVertex(1, s + 1) });
+		mesh.indices.insert(mesh.indices.end(), { ringVertex(rings - 1, s), southPole, ringVertex(rings - 1, s + 1) });
+	}
+
+	for (int r = 1; r < rings - 1; ++r) {
+		for (int s = 0; s < segments; ++s) {
+			unsigned int a = ringVertex(r, s);
+			unsigned int b = ringVertex(r, s + 1);
+			unsigned int c = ringVertex(r + 1, s);
+			unsigned int d = ringVertex(r + 1, s + 1);
+			mesh.indices.insert(mesh.indices.end(), { a, c, b, b, c, d });
+		}
+	}
+
+	return mesh;
+}
+
+// The renderer clears to white, which the lit sphere never reaches
+bool covered(const unsigned char* pixel) {
+	return pixel[0] != 255 || pixel[1] != 255 || pixel[2] != 255;
+}
+
+size_t coveredPixels(const std::vector<unsigned char>& image) {
+	size_t count = 0;
+	for (size_t i = 0; i < image.size(); i += 4) {
+		count += covered(&image[i]) ? 1 : 0;
+	}
+	return count;
+}
+
+size_t differingPixels(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b) {
+	size_t count = 0;
+	for (size_t i = 0; i < a.size(); i += 4) {
+		count += (a[i] != b[i] || a[i + 1] != b[i + 1] || a[i + 2] != b[i + 2]) ? 1 : 0;
+	}
+	return count;
+}
+
+}
+
+int main() {
+	if (!vulkanDeviceAvailable()) {
+		std::cout << "Closed mesh culling: skipped, no Vulkan device" << std::endl;
+		return 0;
+	}
+	if (!shadersCompiled(SHADER_PATH)) {
+		std::cout << "Closed mesh culling: skipped, run shaders/compileShaders.sh first" << std::endl;
+		return 0;
+	}
+
+	Mesh mesh = sphere(90, 180);
+	HeadlessRenderer renderer{ SHADER_PATH };
+
+	// The alpha of the colors alone decides whether the sphere counts as closed, the pipelines draw both opaque
+	std::vector<uint32_t> opaque(mesh.vertices.size() / 6, 0xff4080c0u);
+	std::vector<uint32_t> translucent(opaque.size(), 0xfe4080c0u);
+
+	GeometryHandle closedSphere = renderer.uploadGeometry(mesh.vertices, mesh.indices, opaque);
+	GeometryHandle twoSidedSphere = renderer.uploadGeometry(mesh.vertices, mesh.indices, translucent);
+
+	auto render = [&renderer](const GeometryHandle& geometry, const glm::mat4& mvp) {
+		std::vector<unsigned char> image(size_t(WIDTH) * HEIGHT * 4);
+		renderer.render(WIDTH, HEIGHT, geometry, mvp, 4.0f / WIDTH, image.data(), WIDTH * 4);
+		return image;
+	};
+
+	// Flipped in y like V3dModel's projection, the only handedness back faces are culled for
+	glm::mat4 flipY = glm::scale(glm::mat4{ 1.0f }, glm::vec3{ 1.0f, -1.0f, 1.0f });
+	glm::mat4 turned = glm::rotate(glm::mat4{ 1.0f }, 0.8f, glm::vec3{ 1.0f, 0.4f, 0.0f });
+	glm::mat4 model = glm::translate(glm::mat4{ 1.0f }, CENTER) * turned * glm::translate(glm::mat4{ 1.0f }, -CENTER);
+
+	struct View {
+		const char* name;
+		glm::mat4 mvp;
+		bool inside;
+	};
+
+	View views[] = {
+		{ "orthographic", flipY * glm::orthoRH_ZO(0.0f, 4.0f, -3.0f, 1.0f, 1.0f, 12.0f) * model, false },
+		{ "perspective", flipY * glm::frustumRH_ZO(-0.5f, 0.5f, -0.5f, 0.5f, 1.0f, 12.0f) * glm::translate(glm::mat4{ 1.0f }, glm::vec3{ -2.0f, 1.0f, 0.0f }) * model, false },
+		{ "perspective from the center", flipY * glm::frustumRH_ZO(-0.1f, 0.1f, -0.1f, 0.1f, 0.1f, 12.0f) * turned * glm::translate(glm::mat4{ 1.0f }, -CENTER), true },
+		{ "orthographic without the y flip", glm::orthoRH_ZO(0.0f, 4.0f, -3.0f, 1.0f, 1.0f, 12.0f) * model, false }
+	};
+
+	std::cout << "Closed mesh culling: " << mesh.indices.size() / 3 << " triangles rendered at " << WIDTH << "x" << HEIGHT << std::endl;
+
+	bool passed = true;
+	for (const View& view : views) {
+		std::vector<unsigned char> closedImage = render(closedSphere, view.mvp);
+		std::vector<unsigned char> twoSidedImage = render(twoSidedSphere, view.mvp);
+
+		size_t closedCovered = coveredPixels(closedImage);
+		size_t twoSidedCovered = coveredPixels(twoSidedImage);
+		size_t differing = differingPixels(closedImage, twoSidedImage);
+
+		std::cout << "  " << view.name << ": " << closedCovered << " pixels covered closed, " << twoSidedCovered << " with both faces, "
+			<< differing << " differ" << std::endl;
+
+		bool viewPassed = view.inside ? closedCovered == 0 && twoSidedCovered == size_t(WIDTH) * HEIGHT : twoSidedCovered > 0 && differing == 0;
+		if (!viewPassed) {
+			std::cout << "ERROR: " << (view.inside ? "the inside of the closed sphere was drawn" : "culling back faces changed the image") << std::endl;
+		}
+		passed = passed && viewPassed;
+	}
+
+	return passed ? 0 : 1;
+}
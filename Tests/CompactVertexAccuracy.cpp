@@ -0,0 +1,163 @@
+// Renders the same mesh through the float and the compact vertex pipelines of HeadlessRenderer, with and without
+// vertex colors, and compares the read-back images. Needs a Vulkan device and the compiled shaders, without either it
+// reports the check as skipped.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../Rendering/renderheadless.h"
+#include "VulkanDevice.h"
+
+namespace {
+
+constexpr float PI = 3.14159265358979f;
+constexpr int WIDTH = 512;
+constexpr int HEIGHT = 512;
+const char* SHADER_PATH = "../shaders/";
+
+struct Mesh {
+	std::vector<float> vertices;
+	std::vector<unsigned int> indices;
+	std::vector<uint32_t> colors;
+};
+
+// A sphere away from the origin with its analytic normals, so the quantization bounds do not start at zero
+Mesh sphere() {
+	const int rings = 181;
+	const int segments = 360;
+	const glm::vec3 center{ 12.5f, -3.0f, 40.0f };
+	const float radius = 7.25f;
+
+	Mesh mesh;
+
+	for (int r = 0; r <= rings; ++r) {
+		float polar = PI * r / rings;
+
+		for (int s = 0; s <= segments; ++s) {
+			float azimuth = 2.0f * PI * s / segments;
+			glm::vec3 normal{ std::sin(polar) * std::cos(azimuth), std::sin(polar) * std::sin(azimuth), std::cos(polar) };
+			glm::vec3 position = center + radius * normal;
+
+			mesh.vertices.insert(mesh.vertices.end(), { position.x, position.y, position.z, normal.x, normal.y, normal.z });
+			// Colors that change slowly over the whole sphere, a steep one would turn a sub-pixel shift into a wrong pixel
+			uint32_t red = uint32_t(127.5f + 127.0f * normal.x);
+			uint32_t green = uint32_t(127.5f + 127.0f * normal.y);
+			mesh.colors.push_back(0xff000000u | (green << 8) | red);
+		}
+	}
+
+	for (int r = 0; r < rings; ++r) {
+		for (int s = 0; s < segments; ++s) {
+			unsigned int v = static_cast<unsigned int>(r * (segments + 1) + s);
+			mesh.indices.insert(mesh.indices.end(), { v, v + segments + 1, v + 1, v + 1, v + segments + 1, v + segments + 2 });
+		}
+	}
+
+	return mesh;
+}
+
+std::vector<unsigned char> renderImage(HeadlessRenderer& renderer, const Mesh& mesh, bool withColors, VertexFormat vertexFormat) {
+	GeometryHandle geometry = renderer.uploadGeometry(mesh.vertices, mesh.indices, withColors ? mesh.colors : std::vector<uint32_t>{ },
+		{ }, { }, { }, { }, vertexFormat);
+
+	glm::mat4 projection = glm::orthoRH_ZO(-8.0f, 8.0f, -8.0f, 8.0f, -20.0f, 20.0f);
+	glm::mat4 view = glm::rotate(glm::mat4(1.0f), 0.7f, glm::vec3(1.0f, 0.3f, 0.0f));
+	glm::mat4 mvp = projection * view * glm::translate(glm::mat4(1.0f), -glm::vec3{ 12.5f, -3.0f, 40.0f });
+
+	std::vector<unsigned char> image(size_t(WIDTH) * HEIGHT * 4);
+	renderer.render(WIDTH, HEIGHT, geometry, mvp, 16.0f / WIDTH, image.data(), WIDTH * 4);
+	return image;
+}
+
+// The renderer clears to white, which the lit sphere never reaches
+bool covered(const unsigned char* pixel) {
+	return pixel[0] != 255 || pixel[1] != 255 || pixel[2] != 255;
+}
+
+// Compares two renderings pixel by pixel, quantized positions may move a silhouette by a fraction of a pixel and flip
+// single edge pixels, everywhere else the colors may only differ by the rounding of the quantized normals
+bool compareImages(const char* name, const std::vector<unsigned char>& floatImage, const std::vector<unsigned char>& compactImage) {
+	const int channelTolerance = 3;
+	const double differingFractionBound = 0.002;
+
+	size_t coveredPixels = 0;
+	size_t differingPixels = 0;
+	int maxChannelDifference = 0;
+	int maxInteriorDifference = 0;
+
+	for (int y = 0; y < HEIGHT; ++y) {
+		for (int x = 0; x < WIDTH; ++x) {
+			const unsigned char* a = &floatImage[(size_t(y) * WIDTH + x) * 4];
+			const unsigned char* b = &compactImage[(size_t(y) * WIDTH + x) * 4];
+
+			int difference = 0;
+			for (int channel = 0; channel < 3; ++channel) {
+				difference = std::max(difference, std::abs(int(a[channel]) - int(b[channel])));
+			}
+
+			if (covered(a)) {
+				++coveredPixels;
+			}
+			if (difference > channelTolerance) {
+				++differingPixels;
+			}
+			maxChannelDifference = std::max(maxChannelDifference, difference);
+
+			// A pixel whose neighbours are all covered in both images lies inside the silhouette
+			bool interior = x > 0 && y > 0 && x < WIDTH - 1 && y < HEIGHT - 1;
+			for (int dy = -1; interior && dy <= 1; ++dy) {
+				for (int dx = -1; interior && dx <= 1; ++dx) {
+					size_t neighbour = ((size_t(y) + dy) * WIDTH + x + dx) * 4;
+					interior = covered(&floatImage[neighbour]) && covered(&compactImage[neighbour]);
+				}
+			}
+			if (interior) {
+				maxInteriorDifference = std::max(maxInteriorDifference, difference);
+			}
+		}
+	}
+
+	double differingFraction = coveredPixels ? double(differingPixels) / coveredPixels : 1.0;
+
+	std::cout << "  " << name << ": " << coveredPixels << " covered pixels, " << differingPixels << " differ by more than " << channelTolerance
+		<< " (bound " << differingFractionBound * 100.0 << "%), max difference " << maxChannelDifference << ", inside the silhouette "
+		<< maxInteriorDifference << std::endl;
+
+	bool passed = coveredPixels > 0 && differingFraction <= differingFractionBound && maxInteriorDifference <= channelTolerance;
+	if (!passed) {
+		std::cout << "ERROR: the compact " << name << " rendering is further from the float one than the quantization allows" << std::endl;
+	}
+	return passed;
+}
+
+}
+
+int main() {
+	if (!vulkanDeviceAvailable()) {
+		std::cout << "Compact vertices: skipped, no Vulkan device" << std::endl;
+		return 0;
+	}
+	if (!shadersCompiled(SHADER_PATH)) {
+		std::cout << "Compact vertices: skipped, run shaders/compileShaders.sh first" << std::endl;
+		return 0;
+	}
+
+	Mesh mesh = sphere();
+	HeadlessRenderer renderer{ SHADER_PATH };
+
+	std::cout << "Compact vertices: " << mesh.vertices.size() / 6 << " vertices rendered at " << WIDTH << "x" << HEIGHT << std::endl;
+
+	bool passed = true;
+	for (bool withColors : { false, true }) {
+		std::vector<unsigned char> floatImage = renderImage(renderer, mesh, withColors, VertexFormat::Float);
+		std::vector<unsigned char> compactImage = renderImage(renderer, mesh, withColors, VertexFormat::Compact);
+		passed = compareImages(withColors ? "vertex colors" : "material color", floatImage, compactImage) && passed;
+	}
+
+	return passed ? 0 : 1;
+}
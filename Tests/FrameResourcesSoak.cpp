@@ -0,0 +1,260 @@
+// Runs FrameResources through 100k frames against an in-process fake of the few Vulkan entry points it calls.
+// The fake executes submissions in queue order whenever a fence is waited on or polled, and reports any command
+// buffer recorded while pending, fence reset while pending, binary semaphore misuse, buffer destroyed while a
+// submission still uses it, and any buffer leaked once the ring is destroyed.
+// This is a model check only: it shows FrameResources keeps to the rules the fake enforces, it never runs
+// HeadlessRenderer, a driver or the validation layer.
+
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <set>
+
+#include "../Rendering/FrameResources.h"
+
+struct VkCommandBuffer_T { bool pending{ false }; };
+struct VkFence_T { bool signaled{ false }; bool pending{ false }; };
+struct VkSemaphore_T { bool signaled{ false }; };
+struct VkBuffer_T { uint64_t lastUse{ 0 }; };
+struct VkDeviceMemory_T {};
+
+namespace {
+
+int failures = 0;
+
+#define SOAK_CHECK(condition, message)                                        \
+	if (!(condition)) {                                                       \
+		if (failures++ < 20) {                                                \
+			std::cout << "ERROR: " << message << " (line " << __LINE__ << ")" << std::endl; \
+		}                                                                     \
+	}
+
+struct Submission {
+	uint64_t id;
+	VkCommandBuffer commandBuffer;
+	VkFence fence;
+	VkSemaphore signalSemaphore;
+};
+
+std::deque<Submission> queue;
+uint64_t submittedCount = 0;
+uint64_t completedCount = 0;
+uint32_t pollCount = 0;
+
+std::set<VkBuffer> liveBuffers;
+std::set<VkDeviceMemory> liveMemory;
+size_t liveObjects = 0;
+
+void completeNext() {
+	Submission& submission = queue.front();
+
+	submission.commandBuffer->pending = false;
+	submission.fence->pending = false;
+	submission.fence->signaled = true;
+	completedCount = submission.id;
+
+	queue.pop_front();
+}
+
+void completeUntilSignaled(VkFence fence) {
+	while (!fence->signaled && !queue.empty()) {
+		completeNext();
+	}
+}
+
+VkBuffer createBuffer() {
+	VkBuffer buffer = new VkBuffer_T();
+	liveBuffers.insert(buffer);
+	return buffer;
+}
+
+VkDeviceMemory allocateMemory() {
+	VkDeviceMemory memory = new VkDeviceMemory_T();
+	liveMemory.insert(memory);
+	return memory;
+}
+
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAllocateCommandBuffers(VkDevice, const VkCommandBufferAllocateInfo* info, VkCommandBuffer* commandBuffers) {
+	for (uint32_t i = 0; i < info->commandBufferCount; ++i) {
+		commandBuffers[i] = new VkCommandBuffer_T();
+		++liveObjects;
+	}
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkFreeCommandBuffers(VkDevice, VkCommandPool, uint32_t count, const VkCommandBuffer* commandBuffers) {
+	for (uint32_t i = 0; i < count; ++i) {
+		SOAK_CHECK(!commandBuffers[i]->pending, "command buffer freed while pending");
+		delete commandBuffers[i];
+		--liveObjects;
+	}
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateFence(VkDevice, const VkFenceCreateInfo* info, const VkAllocationCallbacks*, VkFence* fence) {
+	*fence = new VkFence_T();
+	(*fence)->signaled = (info->flags & VK_FENCE_CREATE_SIGNALED_BIT) != 0;
+	++liveObjects;
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyFence(VkDevice, VkFence fence, const VkAllocationCallbacks*) {
+	SOAK_CHECK(!fence->pending, "fence destroyed while pending");
+	delete fence;
+	--liveObjects;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateSemaphore(VkDevice, const VkSemaphoreCreateInfo*, const VkAllocationCallbacks*, VkSemaphore* semaphore) {
+	*semaphore = new VkSemaphore_T();
+	++liveObjects;
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroySemaphore(VkDevice, VkSemaphore semaphore, const VkAllocationCallbacks*) {
+	delete semaphore;
+	--liveObjects;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBeginCommandBuffer(VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo*) {
+	SOAK_CHECK(!commandBuffer->pending, "command buffer recorded while its previous submission is pending");
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkEndCommandBuffer(VkCommandBuffer) {
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkResetFences(VkDevice, uint32_t count, const VkFence* fences) {
+	for (uint32_t i = 0; i < count; ++i) {
+		SOAK_CHECK(!fences[i]->pending, "fence reset while pending");
+		fences[i]->signaled = false;
+	}
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkQueueSubmit(VkQueue, uint32_t count, const VkSubmitInfo* submits, VkFence fence) {
+	SOAK_CHECK(count == 1 && submits->commandBufferCount == 1, "unexpected batch");
+	SOAK_CHECK(!fence->pending && !fence->signaled, "fence submitted without being reset");
+
+	// Binary semaphores are tracked in submission order, which is also the order they execute in on a single queue
+	for (uint32_t i = 0; i < submits->waitSemaphoreCount; ++i) {
+		SOAK_CHECK(submits->pWaitSemaphores[i]->signaled, "wait on a semaphore without a pending signal");
+		submits->pWaitSemaphores[i]->signaled = false;
+	}
+	for (uint32_t i = 0; i < submits->signalSemaphoreCount; ++i) {
+		SOAK_CHECK(!submits->pSignalSemaphores[i]->signaled, "semaphore signaled twice without a wait");
+		submits->pSignalSemaphores[i]->signaled = true;
+	}
+
+	VkCommandBuffer commandBuffer = submits->pCommandBuffers[0];
+	SOAK_CHECK(!commandBuffer->pending, "command buffer submitted while pending");
+	commandBuffer->pending = true;
+	fence->pending = true;
+
+	queue.push_back(Submission{ ++submittedCount, commandBuffer, fence, submits->signalSemaphoreCount ? submits->pSignalSemaphores[0] : VK_NULL_HANDLE });
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkWaitForFences(VkDevice, uint32_t count, const VkFence* fences, VkBool32, uint64_t) {
+	for (uint32_t i = 0; i < count; ++i) {
+		completeUntilSignaled(fences[i]);
+	}
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetFenceStatus(VkDevice, VkFence fence) {
+	// Lets the GPU make some progress on every other poll so retirement is seen both early and late
+	if (!queue.empty() && (++pollCount & 1) == 0) {
+		completeNext();
+	}
+	return fence->signaled ? VK_SUCCESS : VK_NOT_READY;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyBuffer(VkDevice, VkBuffer buffer, const VkAllocationCallbacks*) {
+	SOAK_CHECK(liveBuffers.erase(buffer) == 1, "buffer destroyed twice");
+	SOAK_CHECK(buffer->lastUse <= completedCount, "buffer destroyed while submission " << buffer->lastUse << " still uses it");
+	delete buffer;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkFreeMemory(VkDevice, VkDeviceMemory memory, const VkAllocationCallbacks*) {
+	SOAK_CHECK(liveMemory.erase(memory) == 1, "memory freed twice");
+	delete memory;
+}
+
+// Referenced by VulkanTools.cpp, never reached by FrameResources
+VKAPI_ATTR void VKAPI_CALL vkCmdPipelineBarrier(VkCommandBuffer, VkPipelineStageFlags, VkPipelineStageFlags, VkDependencyFlags, uint32_t, const VkMemoryBarrier*, uint32_t, const VkBufferMemoryBarrier*, uint32_t, const VkImageMemoryBarrier*) {}
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateShaderModule(VkDevice, const VkShaderModuleCreateInfo*, const VkAllocationCallbacks*, VkShaderModule*) { return VK_ERROR_INITIALIZATION_FAILED; }
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFormatProperties(VkPhysicalDevice, VkFormat, VkFormatProperties*) {}
+
+int main() {
+	const uint32_t frameCount = 3;
+	const uint64_t soakFrames = 100000;
+
+	VkDevice device = reinterpret_cast<VkDevice>(uintptr_t(1));
+	VkQueue vkQueue = reinterpret_cast<VkQueue>(uintptr_t(1));
+	VkCommandPool commandPool = VK_NULL_HANDLE;
+
+	FrameResources frameResources;
+	frameResources.create(device, commandPool, frameCount);
+
+	// Geometry drawn by every frame until it is replaced, as V3dModelManager does when a model reloads
+	VkBuffer geometry = createBuffer();
+	VkDeviceMemory geometryMemory = allocateMemory();
+	uint64_t geometrySubmission = 0;
+
+	size_t peakBuffers = 0;
+
+	for (uint64_t i = 0; i < soakFrames; ++i) {
+		uint32_t index = static_cast<uint32_t>(i % frameCount);
+
+		if (i % 7 == 0) {
+			frameResources.beginTransfer();
+
+			VkBuffer staging = createBuffer();
+			staging->lastUse = submittedCount + 1;
+			frameResources.releaseAfterTransfer(staging, allocateMemory());
+
+			// Every other transfer is followed by a second one before any frame consumes the semaphore
+			frameResources.submitTransfer(vkQueue);
+			if (i % 14 == 0) {
+				frameResources.beginTransfer();
+				frameResources.submitTransfer(vkQueue);
+			}
+		}
+
+		uint64_t expectedPrevious = i >= frameCount ? i - frameCount + 1 : 0;
+		SOAK_CHECK(frameResources.frame(index).submission == expectedPrevious, "frame " << i << " reuses slot " << index << " out of order");
+
+		VkCommandBuffer commandBuffer = frameResources.beginFrame(index);
+		SOAK_CHECK(commandBuffer == frameResources.frame(index).commandBuffer, "beginFrame returned another slot's command buffer");
+		SOAK_CHECK(frameResources.frame(index).fence->signaled, "beginFrame returned before the slot's fence signaled");
+
+		geometry->lastUse = submittedCount + 1;
+		geometrySubmission = frameResources.submitFrame(index, vkQueue);
+		SOAK_CHECK(geometrySubmission == i + 1, "submission counter skipped at frame " << i);
+
+		if (i % 13 == 0) {
+			frameResources.releaseAfterSubmission(geometrySubmission, geometry, geometryMemory);
+			geometry = createBuffer();
+			geometryMemory = allocateMemory();
+		}
+
+		peakBuffers = std::max(peakBuffers, liveBuffers.size());
+	}
+
+	frameResources.releaseAfterSubmission(geometrySubmission, geometry, geometryMemory);
+	frameResources.destroy();
+
+	SOAK_CHECK(queue.empty(), queue.size() << " submissions still pending after destroy");
+	SOAK_CHECK(liveBuffers.empty() && liveMemory.empty(), liveBuffers.size() << " buffers and " << liveMemory.size() << " allocations leaked");
+	SOAK_CHECK(liveObjects == 0, liveObjects << " command buffers, fences or semaphores leaked");
+	// Replaced geometry is retired within a few frames, so the live set must not grow with the length of the run
+	SOAK_CHECK(peakBuffers <= 8, "retired buffers piled up to " << peakBuffers);
+
+	std::cout << "FrameResources soak: " << soakFrames << " frames, " << submittedCount << " submissions, peak live buffers " << peakBuffers
+			  << (failures ? ", FAILED" : ", passed") << std::endl;
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+// Checks the tests that render through HeadlessRenderer make before they start, without a device or the compiled
+// shaders they report themselves as skipped
+
+#include <fstream>
+#include <string>
+
+#include <vulkan/vulkan.h>
+
+inline bool vulkanDeviceAvailable() {
+	VkApplicationInfo appInfo{ VK_STRUCTURE_TYPE_APPLICATION_INFO };
+	appInfo.apiVersion = VK_API_VERSION_1_0;
+
+	VkInstanceCreateInfo instanceCreateInfo{ VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+	instanceCreateInfo.pApplicationInfo = &appInfo;
+
+	VkInstance instance;
+	if (vkCreateInstance(&instanceCreateInfo, nullptr, &instance) != VK_SUCCESS) {
+		return false;
+	}
+
+	uint32_t deviceCount = 0;
+	vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+	vkDestroyInstance(instance, nullptr);
+	return deviceCount > 0;
+}
+
+inline bool shadersCompiled(const std::string& shaderPath) {
+	for (const char* name : { "vertex.spv", "colorVertex.spv", "compactVertex.spv", "compactColorVertex.spv", "instanceVertex.spv", "pointVertex.spv", "fragment.spv" }) {
+		if (!std::ifstream{ shaderPath + name }.is_open()) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,27 @@
+#!/bin/bash
+# Builds and runs the standalone checks. VULKAN_INCLUDE must hold vulkan/vulkan.h and GLM_INCLUDE glm/glm.hpp.
+# CompactVertexAccuracy and ClosedMeshCulling render through the Vulkan loader in VULKAN_LIBS and skip themselves without a
+# device or the compiled shaders, set VULKAN_LIBS empty to leave them out where there is no loader to link against.
+VULKAN_INCLUDE=${VULKAN_INCLUDE:-$VULKAN_SDK/include}
+GLM_INCLUDE=${GLM_INCLUDE:-/usr/include}
+VULKAN_LIBS=${VULKAN_LIBS--lvulkan}
+CXX=${CXX:-g++}
+OUT=${OUT:-/tmp/v3dTests}
+mkdir -p $OUT
+cd "$(dirname "$0")"
+
+status=0
+run() {
+	name=$1; shift
+	$CXX -std=c++17 -O2 -pthread -I"$VULKAN_INCLUDE" -I"$GLM_INCLUDE" "$@" -o $OUT/$name && $OUT/$name || status=1
+}
+
+run FrameResourcesSoak FrameResourcesSoak.cpp ../Rendering/FrameResources.cpp ../3rdParty/VulkanTools/VulkanTools.cpp
+run BezierTriangleCorners BezierTriangleCorners.cpp ../V3dFile/BezierPatchTessellator.cpp ../V3dFile/BezierTriangleTessellator.cpp ../Utility/ThreadPool.cpp
+if [ -n "$VULKAN_LIBS" ]; then
+	RENDERER="../Rendering/*.cpp ../3rdParty/VulkanTools/VulkanTools.cpp $VULKAN_LIBS"
+	run CompactVertexAccuracy CompactVertexAccuracy.cpp $RENDERER
+	run ClosedMeshCulling ClosedMeshCulling.cpp $RENDERER
+fi
+
+exit $status
@@ -0,0 +1,101 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    // hardware_concurrency may report 0 when it cannot tell
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+
+    m_Threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        m_Threads.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock{ m_Mutex };
+        m_Stopping = true;
+    }
+    m_TaskAvailable.notify_all();
+
+    for (auto& thread : m_Threads) {
+        thread.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock{ m_Mutex };
+        m_Tasks.push(std::move(task));
+    }
+    m_TaskAvailable.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock{ m_Mutex };
+            m_TaskAvailable.wait(lock, [this]() { return m_Stopping || !m_Tasks.empty(); });
+
+            if (m_Tasks.empty()) {
+                return;
+            }
+
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop();
+        }
+
+        task();
+    }
+}
+
+void TaskGroup::run(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock{ m_Mutex };
+        ++m_Pending;
+    }
+
+    m_Pool.enqueue([this, task = std::move(task)]() {
+        task();
+
+        std::lock_guard<std::mutex> lock{ m_Mutex };
+        if (--m_Pending == 0) {
+            m_Done.notify_all();
+        }
+    });
+}
+
+void TaskGroup::wait() {
+    std::unique_lock<std::mutex> lock{ m_Mutex };
+    m_Done.wait(lock, [this]() { return m_Pending == 0; });
+}
+
+size_t parallelChunkCount(const ThreadPool& pool, size_t count) {
+    return std::min(count, pool.threadCount() * 4);
+}
+
+void parallelFor(ThreadPool& pool, size_t count, const std::function<void(size_t chunk, size_t begin, size_t end)>& fn) {
+    size_t chunkCount = parallelChunkCount(pool, count);
+
+    // Other files may be loading on the same pool at the same time
+    TaskGroup tasks{ pool };
+
+    for (size_t c = 0; c < chunkCount; ++c) {
+        size_t begin = c * count / chunkCount;
+        size_t end = (c + 1) * count / chunkCount;
+
+        tasks.run([&fn, c, begin, end]() { fn(c, begin, end); });
+    }
+
+    tasks.wait();
+}
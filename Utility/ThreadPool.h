@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Fixed set of worker threads pulling tasks from a shared queue
+class ThreadPool {
+public:
+    ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+    ThreadPool(const ThreadPool& other) = delete;
+    ThreadPool& operator=(const ThreadPool& other) = delete;
+    ~ThreadPool();
+
+    // Process wide pool sized to the number of hardware threads
+    static ThreadPool& shared();
+
+    size_t threadCount() const { return m_Threads.size(); }
+
+    void enqueue(std::function<void()> task);
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> m_Threads;
+    std::queue<std::function<void()>> m_Tasks;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_TaskAvailable;
+
+    bool m_Stopping{ false };
+};
+
+// Tracks a batch of tasks on a shared pool so a caller only waits for its own work
+class TaskGroup {
+public:
+    TaskGroup(ThreadPool& pool) : m_Pool{ pool } { }
+    TaskGroup(const TaskGroup& other) = delete;
+    TaskGroup& operator=(const TaskGroup& other) = delete;
+    ~TaskGroup() { wait(); }
+
+    void run(std::function<void()> task);
+    void wait();
+
+private:
+    ThreadPool& m_Pool;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Done;
+    size_t m_Pending{ 0 };
+};
+
+// Number of ranges parallelFor splits count items into, a few per thread keeps the workers busy when items vary in cost
+size_t parallelChunkCount(const ThreadPool& pool, size_t count);
+
+// Calls fn(chunk, begin, end) on the pool for each of parallelChunkCount contiguous ranges covering [0, count) and
+// returns once all of them have finished. Callers size their output first so every range writes straight into its
+// own place without locking.
+// Must not be called from one of the pool's own workers, it would block a worker on tasks queued behind it.
+void parallelFor(ThreadPool& pool, size_t count, const std::function<void(size_t chunk, size_t begin, size_t end)>& fn);
@@ -0,0 +1,85 @@
+#include "BezierCurveTessellator.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "../Utility/ThreadPool.h"
+
+namespace {
+
+constexpr unsigned int MAX_SEGMENTS = 64;
+
+}
+
+unsigned int bezierCurveSegmentCount(const BezierCurveDescriptor& curve) {
+    const std::array<TRIPLE, 4>& P = curve.controlPoints;
+
+    // Wang's bound for a cubic
+    float maxSecondDifference = std::max(glm::length(P[0] - 2.0f * P[1] + P[2]), glm::length(P[1] - 2.0f * P[2] + P[3]));
+
+    if (maxSecondDifference == 0.0f) {
+        return 1;
+    }
+
+    if (!(curve.tolerance > 0.0f)) {
+        return MAX_SEGMENTS;
+    }
+
+    float n = std::ceil(std::sqrt(0.75f * maxSecondDifference / curve.tolerance));
+    return n < MAX_SEGMENTS ? std::max(static_cast<unsigned int>(n), 1u) : MAX_SEGMENTS;
+}
+
+void flattenBezierCurve(const BezierCurveDescriptor& curve, unsigned int segments, float* vertices, unsigned int* indices, unsigned int baseVertex) {
+    const std::array<TRIPLE, 4>& P = curve.controlPoints;
+
+    for (unsigned int i = 0; i <= segments; ++i) {
+        float t = static_cast<float>(i) / segments;
+        float s = 1.0f - t;
+
+        TRIPLE point = s * s * s * P[0] + 3.0f * t * s * s * P[1] + 3.0f * t * t * s * P[2] + t * t * t * P[3];
+
+        // Lines carry no normal
+        vertices[0] = point.x;
+        vertices[1] = point.y;
+        vertices[2] = point.z;
+        vertices[3] = 0.0f;
+        vertices[4] = 0.0f;
+        vertices[5] = 0.0f;
+        vertices += 6;
+    }
+
+    for (unsigned int i = 0; i < segments; ++i) {
+        indices[0] = baseVertex + i;
+        indices[1] = baseVertex + i + 1;
+        indices += 2;
+    }
+}
+
+void flattenBezierCurves(const std::vector<BezierCurveDescriptor>& curves, ThreadPool& pool, MeshBuffer& lines) {
+    if (curves.empty()) {
+        return;
+    }
+
+    // Segment counts depend only on the control points
+    std::vector<unsigned int> segments(curves.size());
+    std::vector<size_t> vertexOffsets(curves.size() + 1);
+    std::vector<size_t> indexOffsets(curves.size() + 1);
+    vertexOffsets[0] = lines.vertexCount();
+    indexOffsets[0] = lines.indices.size();
+
+    for (size_t i = 0; i < curves.size(); ++i) {
+        segments[i] = bezierCurveSegmentCount(curves[i]);
+        vertexOffsets[i + 1] = vertexOffsets[i] + segments[i] + 1;
+        indexOffsets[i + 1] = indexOffsets[i] + 2 * size_t(segments[i]);
+    }
+
+    lines.vertices.resize(6 * vertexOffsets.back());
+    lines.indices.resize(indexOffsets.back());
+
+    parallelFor(pool, curves.size(), [&curves, &segments, &vertexOffsets, &indexOffsets, &lines](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            flattenBezierCurve(curves[i], segments[i], lines.vertices.data() + 6 * vertexOffsets[i], lines.indices.data() + indexOffsets[i],
+                static_cast<unsigned int>(vertexOffsets[i]));
+        }
+    });
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "BezierPatchTessellator.h"
+
+// Everything needed to flatten a curve once the file has been parsed
+struct BezierCurveDescriptor {
+    std::array<TRIPLE, 4> controlPoints;
+    float tolerance;
+};
+
+// Number of line segments that keeps the curve within its tolerance
+unsigned int bezierCurveSegmentCount(const BezierCurveDescriptor& curve);
+
+// Writes the segments + 1 points of the polyline and its 2 * segments line list indices, starting at baseVertex
+void flattenBezierCurve(const BezierCurveDescriptor& curve, unsigned int segments, float* vertices, unsigned int* indices, unsigned int baseVertex);
+
+// Flattens all curves in one batch with parallelFor and appends them to lines in order.
+void flattenBezierCurves(const std::vector<BezierCurveDescriptor>& curves, ThreadPool& pool, MeshBuffer& lines);
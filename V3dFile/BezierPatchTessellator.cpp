@@ -0,0 +1,263 @@
+#include "BezierPatchTessellator.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "BezierTriangleTessellator.h"
+#include "../Utility/ThreadPool.h"
+
+namespace {
+
+// Adaptive rendering constant of the Asymptote renderer
+constexpr float PIXEL = 0.75f;
+
+constexpr int MAX_SEGMENTS = 64;
+
+// Parameter distance used to step off a degenerate edge when its normal vanishes
+constexpr float NORMAL_OFFSET = 1e-3f;
+
+// Wang's bound on the number of segments along one parameter direction of a bicubic patch.
+// stride steps along the direction, rowStride between the four curves running in it.
+int segmentCount(const std::array<TRIPLE, 16>& P, int stride, int rowStride, float tolerance) {
+    float maxSecondDifference = 0.0f;
+
+    for (int row = 0; row < 4; ++row) {
+        for (int k = 0; k < 2; ++k) {
+            int i = row * rowStride + k * stride;
+            TRIPLE d = P[i] - 2.0f * P[i + stride] + P[i + 2 * stride];
+            maxSecondDifference = std::max(maxSecondDifference, glm::length(d));
+        }
+    }
+
+    if (maxSecondDifference == 0.0f) {
+        return 1;
+    }
+
+    if (!(tolerance > 0.0f)) {
+        return MAX_SEGMENTS;
+    }
+
+    float n = std::ceil(std::sqrt(0.75f * maxSecondDifference / tolerance));
+    return n < MAX_SEGMENTS ? std::max(static_cast<int>(n), 1) : MAX_SEGMENTS;
+}
+
+void bernstein(float t, float B[4], float dB[4]) {
+    float s = 1.0f - t;
+
+    B[0] = s * s * s;
+    B[1] = 3.0f * t * s * s;
+    B[2] = 3.0f * t * t * s;
+    B[3] = t * t * t;
+
+    dB[0] = -3.0f * s * s;
+    dB[1] = 3.0f * s * s - 6.0f * t * s;
+    dB[2] = 6.0f * t * s - 3.0f * t * t;
+    dB[3] = 3.0f * t * t;
+}
+
+// Control point 4*i+j, i runs along u and j along v
+void evaluate(const std::array<TRIPLE, 16>& P, float u, float v, TRIPLE& position, TRIPLE& normal) {
+    float Bu[4], dBu[4], Bv[4], dBv[4];
+    bernstein(u, Bu, dBu);
+    bernstein(v, Bv, dBv);
+
+    position = TRIPLE{ 0.0f };
+    TRIPLE Pu{ 0.0f };
+    TRIPLE Pv{ 0.0f };
+
+    for (int i = 0; i < 4; ++i) {
+        TRIPLE row{ 0.0f };
+        TRIPLE rowDv{ 0.0f };
+
+        for (int j = 0; j < 4; ++j) {
+            row += Bv[j] * P[4 * i + j];
+            rowDv += dBv[j] * P[4 * i + j];
+        }
+
+        position += Bu[i] * row;
+        Pu += dBu[i] * row;
+        Pv += Bu[i] * rowDv;
+    }
+
+    // Same orientation as the Asymptote renderer
+    normal = glm::cross(Pv, Pu);
+}
+
+}
+
+uint32_t packColor(const RGBA& color) {
+    auto channel = [](float value) {
+        return static_cast<uint32_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    };
+
+    return channel(color.r) | channel(color.g) << 8 | channel(color.b) << 16 | channel(color.a) << 24;
+}
+
+TessellationView tessellationViewForBounds(const TRIPLE& minBound, const TRIPLE& maxBound, float targetWidth, float targetHeight, bool orthographic) {
+    TessellationView view;
+
+    view.pixelSize = std::hypot(maxBound.x - minBound.x, maxBound.y - minBound.y) / std::hypot(targetWidth, targetHeight);
+    view.nearDepth = orthographic ? 0.0f : maxBound.z;
+
+    return view;
+}
+
+float viewTolerance(const TRIPLE* points, size_t count, const TessellationView& view) {
+    // Under perspective a pixel covers more of the scene the further a surface is behind the near plane
+    float s = 1.0f;
+
+    if (view.nearDepth != 0.0f && count > 0) {
+        float minZ = points[0].z;
+        for (size_t i = 1; i < count; ++i) {
+            minZ = std::min(minZ, points[i].z);
+        }
+
+        s = minZ / view.nearDepth;
+
+        if (!std::isfinite(s) || s <= 0.0f) {
+            s = 1.0f;
+        }
+    }
+
+    return PIXEL * s * view.pixelSize;
+}
+
+float bezierPatchTolerance(const std::array<TRIPLE, 16>& controlPoints, const TessellationView& view) {
+    return viewTolerance(controlPoints.data(), controlPoints.size(), view);
+}
+
+void tessellateBezierPatch(const BezierPatchDescriptor& patch, MeshBuffer& out) {
+    if (patch.triangle) {
+        tessellateBezierTriangle(patch, out);
+        return;
+    }
+
+    const std::array<TRIPLE, 16>& P = patch.controlPoints;
+
+    int nu = segmentCount(P, 4, 1, patch.tolerance);
+    int nv = segmentCount(P, 1, 4, patch.tolerance);
+
+    if (patch.colored) {
+        out.fillColors();
+    }
+
+    bool withColors = patch.colored || !out.colors.empty();
+
+    unsigned int base = static_cast<unsigned int>(out.vertexCount());
+
+    // No reserve, out usually collects many patches and growing it to the exact size every time would copy it per patch
+    for (int i = 0; i <= nu; ++i) {
+        float u = static_cast<float>(i) / nu;
+
+        for (int j = 0; j <= nv; ++j) {
+            float v = static_cast<float>(j) / nv;
+
+            TRIPLE position, normal;
+            evaluate(P, u, v, position, normal);
+
+            // Collapsed edges have no tangent plane, borrow the normal from just inside the patch
+            if (glm::dot(normal, normal) == 0.0f) {
+                TRIPLE unused;
+                evaluate(P, std::clamp(u, NORMAL_OFFSET, 1.0f - NORMAL_OFFSET), std::clamp(v, NORMAL_OFFSET, 1.0f - NORMAL_OFFSET), unused, normal);
+            }
+
+            float length = glm::length(normal);
+            if (length > 0.0f) {
+                normal /= length;
+            }
+
+            out.vertices.push_back(position.x);
+            out.vertices.push_back(position.y);
+            out.vertices.push_back(position.z);
+
+            out.vertices.push_back(normal.x);
+            out.vertices.push_back(normal.y);
+            out.vertices.push_back(normal.z);
+
+            if (withColors) {
+                uint32_t color = DEFAULT_VERTEX_COLOR;
+
+                // Bilinear between the corners 0, 12, 15 and 3
+                if (patch.colored) {
+                    const std::array<RGBA, 4>& C = patch.cornerColors;
+                    color = packColor((1.0f - u) * ((1.0f - v) * C[0] + v * C[3]) + u * ((1.0f - v) * C[1] + v * C[2]));
+                }
+
+                out.colors.push_back(color);
+            }
+        }
+    }
+
+    unsigned int rowLength = static_cast<unsigned int>(nv + 1);
+    for (int i = 0; i < nu; ++i) {
+        for (int j = 0; j < nv; ++j) {
+            unsigned int i0 = base + static_cast<unsigned int>(i) * rowLength + static_cast<unsigned int>(j);
+            unsigned int i1 = i0 + 1;
+            unsigned int i2 = i0 + rowLength;
+            unsigned int i3 = i2 + 1;
+
+            out.indices.insert(out.indices.end(), { i0, i1, i3, i0, i3, i2 });
+        }
+    }
+}
+
+void tessellateBezierPatches(const std::vector<BezierPatchDescriptor>& patches, ThreadPool& pool, MeshBuffer& out) {
+    if (patches.empty()) {
+        return;
+    }
+
+    std::vector<float>& vertices = out.vertices;
+    std::vector<unsigned int>& indices = out.indices;
+
+    bool colored = !out.colors.empty() || std::any_of(patches.begin(), patches.end(), [](const BezierPatchDescriptor& patch) { return patch.colored; });
+
+    // Patch sizes are only known once tessellated, so every chunk meshes into its own buffer first
+    size_t chunkCount = parallelChunkCount(pool, patches.size());
+    std::vector<MeshBuffer> chunks(chunkCount);
+
+    parallelFor(pool, patches.size(), [&patches, &chunks](size_t chunk, size_t begin, size_t end) {
+        for (size_t p = begin; p < end; ++p) {
+            tessellateBezierPatch(patches[p], chunks[chunk]);
+        }
+    });
+
+    // Prefix sums give every chunk its place in the output and the offset for its indices
+    std::vector<size_t> vertexOffsets(chunkCount + 1);
+    std::vector<size_t> indexOffsets(chunkCount + 1);
+    vertexOffsets[0] = vertices.size();
+    indexOffsets[0] = indices.size();
+
+    for (size_t c = 0; c < chunkCount; ++c) {
+        vertexOffsets[c + 1] = vertexOffsets[c] + chunks[c].vertices.size();
+        indexOffsets[c + 1] = indexOffsets[c] + chunks[c].indices.size();
+    }
+
+    vertices.resize(vertexOffsets[chunkCount]);
+    indices.resize(indexOffsets[chunkCount]);
+
+    // Chunks that met no colored patch have no colors, their vertices keep the default
+    if (colored) {
+        out.fillColors();
+    }
+
+    parallelFor(pool, chunkCount, [&chunks, &out, &vertices, &indices, &vertexOffsets, &indexOffsets](size_t, size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            const MeshBuffer& chunk = chunks[c];
+
+            if (!chunk.vertices.empty()) {
+                std::memcpy(&vertices[vertexOffsets[c]], chunk.vertices.data(), chunk.vertices.size() * sizeof(float));
+            }
+
+            if (!chunk.colors.empty()) {
+                std::memcpy(&out.colors[vertexOffsets[c] / 6], chunk.colors.data(), chunk.colors.size() * sizeof(uint32_t));
+            }
+
+            unsigned int indexOffset = static_cast<unsigned int>(vertexOffsets[c] / 6);
+            unsigned int* destination = indices.data() + indexOffsets[c];
+            for (size_t i = 0; i < chunk.indices.size(); ++i) {
+                destination[i] = chunk.indices[i] + indexOffset;
+            }
+        }
+    });
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "V3dTypes.h"
+
+class ThreadPool;
+
+// Color of vertices without one of their own in a mesh that has colors, the default object color of the fragment shader
+constexpr uint32_t DEFAULT_VERTEX_COLOR = 0xFFD1AB59;
+
+// RGBA8 with red in the lowest byte, the layout of VK_FORMAT_R8G8B8A8_UNORM
+uint32_t packColor(const RGBA& color);
+
+// Interleaved position and normal vertices, the same layout as V3dFile::vertices
+struct MeshBuffer {
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+
+    // Packed color of every vertex, empty as long as no vertex has a color of its own
+    std::vector<uint32_t> colors;
+
+    size_t vertexCount() const { return vertices.size() / 6; }
+
+    // Gives every vertex without a color the default one, call before appending vertices with colors
+    void fillColors() { colors.resize(vertexCount(), DEFAULT_VERTEX_COLOR); }
+};
+
+// Everything needed to mesh a Bezier patch or triangle once the file has been parsed
+struct BezierPatchDescriptor {
+    std::array<TRIPLE, 16> controlPoints;   // Triangles only use the first 10
+    float tolerance;
+
+    bool triangle{ false };
+    bool colored{ false };
+
+    // Colors of the corners 0, 12, 15 and 3 of a patch, or 0, 6 and 9 of a triangle
+    std::array<RGBA, 4> cornerColors{ };
+};
+
+// How finely the view samples the scene, patches are meshed to within a fraction of a pixel of it
+struct TessellationView {
+    float pixelSize{ 0.0f };    // World units covered by one pixel at the near plane
+    float nearDepth{ 0.0f };    // z of the near plane, 0 for an orthographic view
+};
+
+// View that fits the given bounds into a target of the given size in pixels
+TessellationView tessellationViewForBounds(const TRIPLE& minBound, const TRIPLE& maxBound, float targetWidth, float targetHeight, bool orthographic);
+
+// Allowed distance between a surface with the given control points and its mesh, in the units of the control points
+float viewTolerance(const TRIPLE* points, size_t count, const TessellationView& view);
+
+float bezierPatchTolerance(const std::array<TRIPLE, 16>& controlPoints, const TessellationView& view);
+
+// Appends the mesh of a single patch or triangle to out, indices are offset by the vertices already in out.
+// Only touches out, so patches and files can be meshed from any number of threads.
+void tessellateBezierPatch(const BezierPatchDescriptor& patch, MeshBuffer& out);
+
+// Meshes all patches and triangles with parallelFor and appends them to out in order.
+void tessellateBezierPatches(const std::vector<BezierPatchDescriptor>& patches, ThreadPool& pool, MeshBuffer& out);
@@ -0,0 +1,149 @@
+#include "BezierTriangleTessellator.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+constexpr int MAX_SEGMENTS = 64;
+
+// Barycentric distance used to step off a degenerate corner when its normal vanishes
+constexpr float NORMAL_OFFSET = 1e-3f;
+
+// Control point i steps from corner 0 towards corner 6 and j steps towards corner 9. The net is stored row by row
+// from corner 0, so the index does not depend on the degree and every de Casteljau level fits in the front of the net.
+int netIndex(int i, int j) {
+    return (i + j) * (i + j + 1) / 2 + j;
+}
+
+// Vertex i along the row j of the uniform grid with n segments, in the order the grid is emitted
+int gridIndex(int n, int i, int j) {
+    return j * (n + 1) - j * (j - 1) / 2 + i;
+}
+
+// Wang's bound over the second differences of the control net in its three directions
+int segmentCount(const std::array<TRIPLE, 16>& P, float tolerance) {
+    constexpr int directions[3][2] = { { 1, 0 }, { 0, 1 }, { 1, -1 } };
+
+    float maxSecondDifference = 0.0f;
+
+    for (int j = 0; j <= 3; ++j) {
+        for (int i = 0; i + j <= 3; ++i) {
+            for (auto& d : directions) {
+                int i2 = i + 2 * d[0];
+                int j2 = j + 2 * d[1];
+
+                if (i2 < 0 || j2 < 0 || i2 + j2 > 3) {
+                    continue;
+                }
+
+                TRIPLE difference = P[netIndex(i, j)] - 2.0f * P[netIndex(i + d[0], j + d[1])] + P[netIndex(i2, j2)];
+                maxSecondDifference = std::max(maxSecondDifference, glm::length(difference));
+            }
+        }
+    }
+
+    if (maxSecondDifference == 0.0f) {
+        return 1;
+    }
+
+    if (!(tolerance > 0.0f)) {
+        return MAX_SEGMENTS;
+    }
+
+    float n = std::ceil(std::sqrt(0.75f * maxSecondDifference / tolerance));
+    return n < MAX_SEGMENTS ? std::max(static_cast<int>(n), 1) : MAX_SEGMENTS;
+}
+
+// s runs towards corner 6 and t towards corner 9, de Casteljau down to the linear net gives both tangents
+void evaluate(const std::array<TRIPLE, 16>& P, float s, float t, TRIPLE& position, TRIPLE& normal) {
+    float w = 1.0f - s - t;
+
+    std::array<TRIPLE, 10> net;
+    std::copy(P.begin(), P.begin() + 10, net.begin());
+
+    // Rows in increasing order, so each row is overwritten only after the row before it has read it
+    for (int degree = 3; degree > 1; --degree) {
+        for (int row = 0; row < degree; ++row) {
+            for (int j = 0; j <= row; ++j) {
+                int i = row - j;
+                net[netIndex(i, j)] = w * net[netIndex(i, j)] + s * net[netIndex(i + 1, j)] + t * net[netIndex(i, j + 1)];
+            }
+        }
+    }
+
+    TRIPLE& origin = net[netIndex(0, 0)];
+    TRIPLE& towardsS = net[netIndex(1, 0)];
+    TRIPLE& towardsT = net[netIndex(0, 1)];
+
+    position = w * origin + s * towardsS + t * towardsT;
+
+    // Same orientation as the patches
+    normal = glm::cross(towardsS - origin, towardsT - origin);
+}
+
+}
+
+void tessellateBezierTriangle(const BezierPatchDescriptor& triangle, MeshBuffer& out) {
+    const std::array<TRIPLE, 16>& P = triangle.controlPoints;
+
+    int n = segmentCount(P, triangle.tolerance);
+
+    if (triangle.colored) {
+        out.fillColors();
+    }
+
+    bool withColors = triangle.colored || !out.colors.empty();
+
+    unsigned int base = static_cast<unsigned int>(out.vertexCount());
+
+    // No reserve, like the patches, out collects many triangles
+    for (int j = 0; j <= n; ++j) {
+        float t = static_cast<float>(j) / n;
+
+        for (int i = 0; i + j <= n; ++i) {
+            float s = static_cast<float>(i) / n;
+
+            TRIPLE position, normal;
+            evaluate(P, s, t, position, normal);
+
+            // Collapsed corners have no tangent plane, borrow the normal from just inside the triangle
+            if (glm::dot(normal, normal) == 0.0f) {
+                TRIPLE unused;
+                evaluate(P, (1.0f - 3.0f * NORMAL_OFFSET) * s + NORMAL_OFFSET, (1.0f - 3.0f * NORMAL_OFFSET) * t + NORMAL_OFFSET, unused, normal);
+            }
+
+            float length = glm::length(normal);
+            if (length > 0.0f) {
+                normal /= length;
+            }
+
+            out.vertices.insert(out.vertices.end(), { position.x, position.y, position.z, normal.x, normal.y, normal.z });
+
+            if (withColors) {
+                uint32_t color = DEFAULT_VERTEX_COLOR;
+
+                if (triangle.colored) {
+                    float w = 1.0f - s - t;
+                    color = packColor(w * triangle.cornerColors[0] + s * triangle.cornerColors[1] + t * triangle.cornerColors[2]);
+                }
+
+                out.colors.push_back(color);
+            }
+        }
+    }
+
+    auto vertex = [base, n](int i, int j) {
+        return base + static_cast<unsigned int>(gridIndex(n, i, j));
+    };
+
+    for (int j = 0; j < n; ++j) {
+        for (int i = 0; i + j < n; ++i) {
+            out.indices.insert(out.indices.end(), { vertex(i, j), vertex(i + 1, j), vertex(i, j + 1) });
+
+            if (i + j + 1 < n) {
+                out.indices.insert(out.indices.end(), { vertex(i + 1, j), vertex(i + 1, j + 1), vertex(i, j + 1) });
+            }
+        }
+    }
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "BezierPatchTessellator.h"
+
+// Cubic Bezier triangles in Asymptote's order, control points row by row from the corner 0 to the edge 6-9:
+//
+//          0
+//        1   2
+//      3   4   5
+//    6   7   8   9
+//
+// Meshed on a uniform triangular grid whose size bounds the distance to the surface by the tolerance.
+void tessellateBezierTriangle(const BezierPatchDescriptor& triangle, MeshBuffer& out);
@@ -0,0 +1,103 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const std::string& fileName) {
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    m_File = file;
+    m_Opened = true;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (mapping == nullptr) {
+        m_Opened = false;
+        return;
+    }
+
+    m_Mapping = mapping;
+
+    m_Data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    m_Size = m_Data != nullptr ? static_cast<size_t>(size.QuadPart) : 0;
+    m_Opened = m_Data != nullptr;
+}
+
+MappedFile::~MappedFile() {
+    if (m_Data != nullptr) {
+        UnmapViewOfFile(m_Data);
+    }
+
+    if (m_Mapping != nullptr) {
+        CloseHandle(m_Mapping);
+    }
+
+    if (m_File != nullptr) {
+        CloseHandle(m_File);
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& fileName) {
+    int fd = open(fileName.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0) {
+        close(fd);
+        return;
+    }
+
+    m_Opened = true;
+
+    if (fileStat.st_size == 0) {
+        close(fd);
+        return;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        m_Opened = false;
+        return;
+    }
+
+    // The parser walks the file front to back exactly once
+    madvise(data, static_cast<size_t>(fileStat.st_size), MADV_SEQUENTIAL);
+
+    m_Data = static_cast<const unsigned char*>(data);
+    m_Size = static_cast<size_t>(fileStat.st_size);
+}
+
+MappedFile::~MappedFile() {
+    if (m_Data != nullptr) {
+        munmap(const_cast<unsigned char*>(m_Data), m_Size);
+    }
+}
+
+#endif
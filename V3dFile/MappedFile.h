@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file, the mapping is released when the object is destroyed
+class MappedFile {
+public:
+    MappedFile(const std::string& fileName);
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile& operator=(const MappedFile& other) = delete;
+    ~MappedFile();
+
+    bool isOpen() const { return m_Opened; }
+
+    const unsigned char* data() const { return m_Data; }
+    size_t size() const { return m_Size; }
+
+private:
+    const unsigned char* m_Data{ nullptr };
+    size_t m_Size{ 0 };
+    bool m_Opened{ false };
+
+#if defined(_WIN32)
+    void* m_File{ nullptr };
+    void* m_Mapping{ nullptr };
+#endif
+};
@@ -0,0 +1,309 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <numeric>
+#include <limits>
+
+namespace {
+
+constexpr unsigned int NO_VERTEX = std::numeric_limits<unsigned int>::max();
+
+// Clusters smaller than this absorb the ones after them before sorting, so the sort keeps whole fans together
+constexpr size_t MIN_CLUSTER_TRIANGLES = 64;
+
+struct Adjacency {
+    std::vector<unsigned int> offsets;      // vertexCount + 1
+    std::vector<unsigned int> triangles;
+};
+
+Adjacency buildAdjacency(const unsigned int* indices, size_t triangleCount, size_t vertexCount) {
+    Adjacency adjacency;
+    adjacency.offsets.assign(vertexCount + 1, 0);
+    adjacency.triangles.resize(3 * triangleCount);
+
+    for (size_t i = 0; i < 3 * triangleCount; ++i) {
+        ++adjacency.offsets[indices[i] + 1];
+    }
+
+    std::partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(), adjacency.offsets.begin());
+
+    std::vector<unsigned int> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        for (size_t k = 0; k < 3; ++k) {
+            adjacency.triangles[fill[indices[3 * t + k]]++] = static_cast<unsigned int>(t);
+        }
+    }
+
+    return adjacency;
+}
+
+// Tipsify, returns the triangles in their new order and the first triangle of every cluster, a cluster starts
+// wherever the fanning had to jump to a vertex outside the cache
+void tipsify(const unsigned int* indices, size_t triangleCount, size_t vertexCount, unsigned int cacheSize,
+    std::vector<unsigned int>& order, std::vector<size_t>& clusterStarts) {
+    Adjacency adjacency = buildAdjacency(indices, triangleCount, vertexCount);
+
+    std::vector<unsigned int> live(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> deadEnd;
+    std::vector<unsigned int> candidates;
+
+    order.clear();
+    order.reserve(triangleCount);
+    clusterStarts.clear();
+
+    unsigned int time = cacheSize + 1;
+    size_t cursor = 0;
+
+    auto skipDeadEnd = [&]() {
+        while (!deadEnd.empty()) {
+            unsigned int v = deadEnd.back();
+            deadEnd.pop_back();
+
+            if (live[v] > 0) {
+                return v;
+            }
+        }
+
+        while (cursor < vertexCount) {
+            if (live[cursor] > 0) {
+                return static_cast<unsigned int>(cursor);
+            }
+            ++cursor;
+        }
+
+        return NO_VERTEX;
+    };
+
+    unsigned int fanning = skipDeadEnd();
+    if (fanning != NO_VERTEX) {
+        clusterStarts.push_back(0);
+    }
+
+    while (fanning != NO_VERTEX) {
+        candidates.clear();
+
+        for (unsigned int a = adjacency.offsets[fanning]; a < adjacency.offsets[fanning + 1]; ++a) {
+            unsigned int t = adjacency.triangles[a];
+
+            if (emitted[t]) {
+                continue;
+            }
+
+            for (size_t k = 0; k < 3; ++k) {
+                unsigned int v = indices[3 * t + k];
+
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+
+                if (time - cacheTime[v] > cacheSize) {
+                    cacheTime[v] = time++;
+                }
+            }
+
+            emitted[t] = true;
+            order.push_back(t);
+        }
+
+        // Prefer the candidate that stays in the cache longest while still having triangles left
+        unsigned int next = NO_VERTEX;
+        int bestPriority = -1;
+
+        for (unsigned int v : candidates) {
+            if (live[v] == 0) {
+                continue;
+            }
+
+            int priority = 0;
+            if (time - cacheTime[v] + 2 * live[v] <= cacheSize) {
+                priority = static_cast<int>(time - cacheTime[v]);
+            }
+
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                next = v;
+            }
+        }
+
+        if (next == NO_VERTEX) {
+            next = skipDeadEnd();
+
+            if (next != NO_VERTEX && order.size() < triangleCount) {
+                clusterStarts.push_back(order.size());
+            }
+        }
+
+        fanning = next;
+    }
+}
+
+// Outward facing clusters first, measured by how far their centroid lies in front of the mesh centroid along their normal
+void sortClusters(const float* vertices, const unsigned int* indices, std::vector<unsigned int>& order, const std::vector<size_t>& clusterStarts) {
+    // The last cluster may stay small
+    std::vector<size_t> starts;
+    for (size_t start : clusterStarts) {
+        if (starts.empty() || start - starts.back() >= MIN_CLUSTER_TRIANGLES) {
+            starts.push_back(start);
+        }
+    }
+
+    if (starts.size() < 2) {
+        return;
+    }
+
+    starts.push_back(order.size());
+
+    auto position = [vertices](unsigned int v) {
+        const float* p = vertices + 6 * size_t(v);
+        return TRIPLE{ p[0], p[1], p[2] };
+    };
+
+    std::vector<TRIPLE> centroids(starts.size() - 1, TRIPLE{ 0.0f });
+    std::vector<TRIPLE> normals(starts.size() - 1, TRIPLE{ 0.0f });
+    TRIPLE meshCentroid{ 0.0f };
+
+    for (size_t c = 0; c + 1 < starts.size(); ++c) {
+        for (size_t i = starts[c]; i < starts[c + 1]; ++i) {
+            const unsigned int* triangle = &indices[3 * size_t(order[i])];
+            TRIPLE p0 = position(triangle[0]);
+            TRIPLE p1 = position(triangle[1]);
+            TRIPLE p2 = position(triangle[2]);
+
+            centroids[c] += p0 + p1 + p2;
+
+            // Twice the area weighted normal
+            normals[c] += glm::cross(p1 - p0, p2 - p0);
+        }
+
+        meshCentroid += centroids[c];
+        centroids[c] /= 3.0f * static_cast<float>(starts[c + 1] - starts[c]);
+    }
+
+    meshCentroid /= 3.0f * static_cast<float>(order.size());
+
+    std::vector<float> keys(centroids.size());
+    for (size_t c = 0; c < centroids.size(); ++c) {
+        keys[c] = glm::dot(centroids[c] - meshCentroid, normals[c]);
+    }
+
+    std::vector<size_t> clusters(centroids.size());
+    std::iota(clusters.begin(), clusters.end(), 0);
+    std::stable_sort(clusters.begin(), clusters.end(), [&keys](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+    std::vector<unsigned int> sorted;
+    sorted.reserve(order.size());
+    for (size_t c : clusters) {
+        sorted.insert(sorted.end(), order.begin() + starts[c], order.begin() + starts[c + 1]);
+    }
+
+    order.swap(sorted);
+}
+
+}
+
+void optimizeMesh(MeshBuffer& mesh, size_t firstVertex, size_t firstIndex, const MeshOptimizeOptions& options) {
+    size_t vertexCount = mesh.vertexCount() - firstVertex;
+    size_t triangleCount = (mesh.indices.size() - firstIndex) / 3;
+
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // Work on indices relative to firstVertex
+    std::vector<unsigned int> local(mesh.indices.begin() + firstIndex, mesh.indices.begin() + firstIndex + 3 * triangleCount);
+    for (unsigned int& index : local) {
+        index -= static_cast<unsigned int>(firstVertex);
+    }
+
+    std::vector<unsigned int> order;
+    std::vector<size_t> clusterStarts;
+    tipsify(local.data(), triangleCount, vertexCount, options.cacheSize, order, clusterStarts);
+
+    if (options.sortForOverdraw) {
+        sortClusters(mesh.vertices.data() + 6 * firstVertex, local.data(), order, clusterStarts);
+    }
+
+    // Renumber the vertices by first use. Once a chunk of new vertices is full the next one starts, and vertices of
+    // earlier chunks are copied into it, so the triangles of each chunk only index their own maxChunkVertices vertices.
+    std::vector<unsigned int> remap(vertexCount, NO_VERTEX);
+    std::vector<unsigned int> sources;
+    sources.reserve(vertexCount);
+
+    unsigned int chunkStart = 0;
+    auto needsVertex = [&remap, &chunkStart](unsigned int v) {
+        return remap[v] == NO_VERTEX || remap[v] < chunkStart;
+    };
+
+    unsigned int* out = mesh.indices.data() + firstIndex;
+    for (unsigned int t : order) {
+        const unsigned int* corners = &local[3 * size_t(t)];
+
+        if (options.maxChunkVertices > 0) {
+            unsigned int needed = (needsVertex(corners[0]) ? 1 : 0) + (needsVertex(corners[1]) ? 1 : 0) + (needsVertex(corners[2]) ? 1 : 0);
+            if (sources.size() + needed - chunkStart > options.maxChunkVertices) {
+                chunkStart = static_cast<unsigned int>(sources.size());
+            }
+        }
+
+        for (size_t k = 0; k < 3; ++k) {
+            unsigned int v = corners[k];
+            if (needsVertex(v)) {
+                remap[v] = static_cast<unsigned int>(sources.size());
+                sources.push_back(v);
+            }
+            *out++ = remap[v] + static_cast<unsigned int>(firstVertex);
+        }
+    }
+
+    // Vertices no triangle uses keep their relative order at the end
+    for (unsigned int v = 0; v < vertexCount; ++v) {
+        if (remap[v] == NO_VERTEX) {
+            sources.push_back(v);
+        }
+    }
+
+    std::vector<float> vertices(6 * sources.size());
+    for (size_t v = 0; v < sources.size(); ++v) {
+        std::copy_n(&mesh.vertices[6 * (firstVertex + sources[v])], 6, &vertices[6 * v]);
+    }
+    mesh.vertices.resize(6 * firstVertex);
+    mesh.vertices.insert(mesh.vertices.end(), vertices.begin(), vertices.end());
+
+    if (!mesh.colors.empty()) {
+        std::vector<uint32_t> colors(sources.size());
+        for (size_t v = 0; v < sources.size(); ++v) {
+            colors[v] = mesh.colors[firstVertex + sources[v]];
+        }
+        mesh.colors.resize(firstVertex);
+        mesh.colors.insert(mesh.colors.end(), colors.begin(), colors.end());
+    }
+}
+
+float averageCacheMissRatio(const std::vector<unsigned int>& indices, unsigned int cacheSize) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || cacheSize == 0) {
+        return 0.0f;
+    }
+
+    unsigned int maxIndex = *std::max_element(indices.begin(), indices.end());
+
+    // FIFO cache, a vertex is a hit while fewer than cacheSize misses happened since it was loaded
+    std::vector<size_t> loadedAt(size_t(maxIndex) + 1, std::numeric_limits<size_t>::max());
+    size_t misses = 0;
+
+    for (size_t i = 0; i < 3 * triangleCount; ++i) {
+        size_t& loaded = loadedAt[indices[i]];
+
+        if (loaded == std::numeric_limits<size_t>::max() || misses - loaded >= cacheSize) {
+            loaded = misses++;
+        }
+    }
+
+    return static_cast<float>(misses) / static_cast<float>(triangleCount);
+}
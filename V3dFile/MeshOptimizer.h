@@ -0,0 +1,22 @@
+#pragma once
+
+#include "BezierPatchTessellator.h"
+
+struct MeshOptimizeOptions {
+    unsigned int cacheSize{ 16 };   // Post-transform cache entries the triangle order is tuned for
+    bool sortForOverdraw{ true };   // Also draw the clusters that face outwards first
+
+    // Vertices a run of consecutive triangles may span, so the indices still split into 16 bit chunks. 0 for no limit.
+    unsigned int maxChunkVertices{ 1u << 16 };
+};
+
+// Reorders the triangles in mesh.indices from firstIndex on for the post-transform vertex cache with Tipsify
+// (Sander, Nehab and Barczak 2007), optionally sorting the clusters it produces so outward facing ones come first.
+// The vertices from firstVertex on are then renumbered in the order they are first used, which is the order the
+// vertex fetch sees them. A vertex used again more than maxChunkVertices vertices after its first use is copied, so
+// the mesh may grow by a few vertices. Those triangles must only use vertices from firstVertex on. Runs in linear time
+// apart from the sort of the clusters.
+void optimizeMesh(MeshBuffer& mesh, size_t firstVertex, size_t firstIndex, const MeshOptimizeOptions& options = { });
+
+// Average cache misses per triangle of a FIFO cache of the given size, 3 is the worst and 0.5 about the best possible
+float averageCacheMissRatio(const std::vector<unsigned int>& indices, unsigned int cacheSize);
@@ -0,0 +1,398 @@
+#include "MeshSimplifier.h"
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+
+namespace {
+
+constexpr unsigned int NO_VERTEX = std::numeric_limits<unsigned int>::max();
+
+// Open borders resist collapsing across them this much more than the surface does
+constexpr double BORDER_WEIGHT = 10.0;
+
+// Collapses may turn a surviving triangle by at most the angle of this cosine, about 75 degrees
+constexpr float MIN_NORMAL_COSINE = 0.25f;
+
+// Each level of detail aims for this fraction of the triangles of the one before
+constexpr size_t LOD_REDUCTION = 4;
+
+// Levels that shrink by less than this factor end the chain
+constexpr double MIN_LOD_SHRINK = 1.5;
+
+// Error allowed for a level of detail, relative to the diagonal of the mesh bounds
+constexpr float LOD_RELATIVE_ERROR = 0.01f;
+
+// Symmetric 4x4 matrix of a sum of squared plane distances, with the weight it was accumulated with
+struct Quadric {
+    double a00{ 0 }, a01{ 0 }, a02{ 0 }, a11{ 0 }, a12{ 0 }, a22{ 0 };
+    double b0{ 0 }, b1{ 0 }, b2{ 0 };
+    double c{ 0 };
+    double weight{ 0 };
+
+    void addPlane(const glm::dvec3& normal, double distance, double planeWeight) {
+        a00 += planeWeight * normal.x * normal.x;
+        a01 += planeWeight * normal.x * normal.y;
+        a02 += planeWeight * normal.x * normal.z;
+        a11 += planeWeight * normal.y * normal.y;
+        a12 += planeWeight * normal.y * normal.z;
+        a22 += planeWeight * normal.z * normal.z;
+        b0 += planeWeight * normal.x * distance;
+        b1 += planeWeight * normal.y * distance;
+        b2 += planeWeight * normal.z * distance;
+        c += planeWeight * distance * distance;
+        weight += planeWeight;
+    }
+
+    void add(const Quadric& other) {
+        a00 += other.a00; a01 += other.a01; a02 += other.a02;
+        a11 += other.a11; a12 += other.a12; a22 += other.a22;
+        b0 += other.b0; b1 += other.b1; b2 += other.b2;
+        c += other.c;
+        weight += other.weight;
+    }
+
+    // Weighted mean squared distance of p to the planes
+    double error(const TRIPLE& p) const {
+        double x = p.x, y = p.y, z = p.z;
+
+        double squared = a00 * x * x + a11 * y * y + a22 * z * z
+            + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+            + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+
+        return weight > 0.0 ? std::max(squared, 0.0) / weight : 0.0;
+    }
+};
+
+double combinedError(const Quadric& a, const Quadric& b, const TRIPLE& p) {
+    Quadric sum = a;
+    sum.add(b);
+    return sum.error(p);
+}
+
+struct Collapse {
+    unsigned int from;
+    unsigned int to;
+    double error;
+};
+
+}
+
+std::vector<unsigned int> simplifyMesh(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, size_t targetIndexCount, float targetError) {
+    size_t vertexCount = vertices.size() / 6;
+    size_t triangleCount = indices.size() / 3;
+
+    auto position = [&vertices](unsigned int v) {
+        const float* p = &vertices[6 * size_t(v)];
+        return TRIPLE{ p[0], p[1], p[2] };
+    };
+
+    auto normal = [&vertices](unsigned int v) {
+        const float* p = &vertices[6 * size_t(v) + 3];
+        return TRIPLE{ p[0], p[1], p[2] };
+    };
+
+    // Vertices that share a position form one class, its members are contiguous in byPosition
+    std::vector<unsigned int> byPosition(vertexCount);
+    std::iota(byPosition.begin(), byPosition.end(), 0);
+    std::sort(byPosition.begin(), byPosition.end(), [&vertices](unsigned int a, unsigned int b) {
+        return std::lexicographical_compare(&vertices[6 * size_t(a)], &vertices[6 * size_t(a) + 3], &vertices[6 * size_t(b)], &vertices[6 * size_t(b) + 3]);
+    });
+
+    std::vector<unsigned int> classOf(vertexCount);
+    std::vector<unsigned int> classStart;
+
+    for (size_t i = 0; i < vertexCount; ++i) {
+        if (i == 0 || position(byPosition[i]) != position(byPosition[i - 1])) {
+            classStart.push_back(static_cast<unsigned int>(i));
+        }
+        classOf[byPosition[i]] = static_cast<unsigned int>(classStart.size() - 1);
+    }
+
+    size_t classCount = classStart.size();
+    classStart.push_back(static_cast<unsigned int>(vertexCount));
+
+    std::vector<TRIPLE> classPosition(classCount);
+    for (size_t c = 0; c < classCount; ++c) {
+        classPosition[c] = position(byPosition[classStart[c]]);
+    }
+
+    std::vector<std::array<unsigned int, 3>> triangles;
+    triangles.reserve(triangleCount);
+
+    for (size_t t = 0; t < triangleCount; ++t) {
+        std::array<unsigned int, 3> triangle{ indices[3 * t], indices[3 * t + 1], indices[3 * t + 2] };
+        unsigned int c0 = classOf[triangle[0]], c1 = classOf[triangle[1]], c2 = classOf[triangle[2]];
+
+        if (c0 != c1 && c1 != c2 && c2 != c0) {
+            triangles.push_back(triangle);
+        }
+    }
+
+    // Area weighted planes of the triangles around every class
+    std::vector<Quadric> quadrics(classCount);
+    std::vector<std::array<unsigned int, 3>> edges;     // Smaller class, larger class, triangle
+    edges.reserve(3 * triangles.size());
+
+    for (size_t t = 0; t < triangles.size(); ++t) {
+        std::array<unsigned int, 3> c{ classOf[triangles[t][0]], classOf[triangles[t][1]], classOf[triangles[t][2]] };
+
+        glm::dvec3 p0{ classPosition[c[0]] };
+        glm::dvec3 n = glm::cross(glm::dvec3{ classPosition[c[1]] } - p0, glm::dvec3{ classPosition[c[2]] } - p0);
+        double length = glm::length(n);
+
+        if (length > 0.0) {
+            n /= length;
+            for (unsigned int k : c) {
+                quadrics[k].addPlane(n, -glm::dot(n, p0), 0.5 * length);
+            }
+        }
+
+        for (size_t k = 0; k < 3; ++k) {
+            unsigned int a = c[k], b = c[(k + 1) % 3];
+            edges.push_back({ std::min(a, b), std::max(a, b), static_cast<unsigned int>(t) });
+        }
+    }
+
+    // Edges of a single triangle are open borders, kept in place by a plane through them perpendicular to the triangle
+    std::sort(edges.begin(), edges.end());
+
+    for (size_t i = 0; i < edges.size(); ) {
+        size_t j = i + 1;
+        while (j < edges.size() && edges[j][0] == edges[i][0] && edges[j][1] == edges[i][1]) {
+            ++j;
+        }
+
+        if (j - i == 1) {
+            const std::array<unsigned int, 3>& triangle = triangles[edges[i][2]];
+            glm::dvec3 p0{ classPosition[classOf[triangle[0]]] };
+            glm::dvec3 faceNormal = glm::cross(glm::dvec3{ classPosition[classOf[triangle[1]]] } - p0, glm::dvec3{ classPosition[classOf[triangle[2]]] } - p0);
+
+            glm::dvec3 a{ classPosition[edges[i][0]] };
+            glm::dvec3 edge = glm::dvec3{ classPosition[edges[i][1]] } - a;
+            glm::dvec3 n = glm::cross(edge, faceNormal);
+            double length = glm::length(n);
+
+            if (length > 0.0) {
+                n /= length;
+                double planeWeight = BORDER_WEIGHT * glm::dot(edge, edge);
+                quadrics[edges[i][0]].addPlane(n, -glm::dot(n, a), planeWeight);
+                quadrics[edges[i][1]].addPlane(n, -glm::dot(n, a), planeWeight);
+            }
+        }
+
+        i = j;
+    }
+
+    edges.clear();
+    edges.shrink_to_fit();
+
+    double maxError = static_cast<double>(targetError) * targetError;
+    size_t targetTriangles = targetIndexCount / 3;
+
+    std::vector<unsigned int> collapseTarget(classCount);
+    std::iota(collapseTarget.begin(), collapseTarget.end(), 0);
+
+    // Vertex every corner of a collapsed vertex moves to, found on first use
+    std::vector<unsigned int> vertexTarget(vertexCount, NO_VERTEX);
+
+    std::vector<unsigned int> adjacencyOffsets(classCount + 1);
+    std::vector<unsigned int> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<bool> locked(classCount);
+
+    while (triangles.size() > targetTriangles) {
+        // Triangles around every class
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (const std::array<unsigned int, 3>& triangle : triangles) {
+            for (unsigned int v : triangle) {
+                ++adjacencyOffsets[classOf[v] + 1];
+            }
+        }
+
+        std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+        adjacency.resize(3 * triangles.size());
+
+        std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t t = 0; t < triangles.size(); ++t) {
+            for (unsigned int v : triangles[t]) {
+                adjacency[fill[classOf[v]]++] = static_cast<unsigned int>(t);
+            }
+        }
+
+        // Cheaper direction of every edge, once per triangle it borders
+        collapses.clear();
+        for (const std::array<unsigned int, 3>& triangle : triangles) {
+            for (size_t k = 0; k < 3; ++k) {
+                unsigned int a = classOf[triangle[k]];
+                unsigned int b = classOf[triangle[(k + 1) % 3]];
+
+                double toB = combinedError(quadrics[a], quadrics[b], classPosition[b]);
+                double toA = combinedError(quadrics[a], quadrics[b], classPosition[a]);
+
+                Collapse collapse = toB <= toA ? Collapse{ a, b, toB } : Collapse{ b, a, toA };
+                if (collapse.error <= maxError) {
+                    collapses.push_back(collapse);
+                }
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+        // Classes around a collapse are locked for the rest of the pass, their triangles are out of date
+        std::fill(locked.begin(), locked.end(), false);
+
+        size_t remaining = triangles.size();
+        size_t collapsed = 0;
+
+        for (const Collapse& collapse : collapses) {
+            if (remaining <= targetTriangles) {
+                break;
+            }
+
+            if (locked[collapse.from] || locked[collapse.to]) {
+                continue;
+            }
+
+            // Moving the vertex must neither flip nor sharply turn any triangle that survives the collapse
+            bool flips = false;
+            size_t removed = 0;
+
+            for (unsigned int a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1] && !flips; ++a) {
+                const std::array<unsigned int, 3>& triangle = triangles[adjacency[a]];
+                std::array<TRIPLE, 3> before, after;
+                bool degenerate = false;
+
+                for (size_t k = 0; k < 3; ++k) {
+                    unsigned int c = classOf[triangle[k]];
+                    degenerate |= c == collapse.to;
+
+                    before[k] = classPosition[c];
+                    after[k] = c == collapse.from ? classPosition[collapse.to] : before[k];
+                }
+
+                if (degenerate) {
+                    ++removed;
+                    continue;
+                }
+
+                TRIPLE normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+                TRIPLE normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+
+                flips = glm::dot(normalBefore, normalAfter) <= MIN_NORMAL_COSINE * glm::length(normalBefore) * glm::length(normalAfter);
+            }
+
+            if (flips) {
+                continue;
+            }
+
+            collapseTarget[collapse.from] = collapse.to;
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+
+            for (unsigned int a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1]; ++a) {
+                for (unsigned int v : triangles[adjacency[a]]) {
+                    locked[classOf[v]] = true;
+                }
+            }
+
+            remaining -= removed;
+            ++collapsed;
+        }
+
+        if (collapsed == 0) {
+            break;
+        }
+
+        // Corners of collapsed classes move to the member of the target class with the closest normal
+        auto moved = [&](unsigned int v) {
+            unsigned int from = classOf[v];
+            unsigned int to = collapseTarget[from];
+
+            if (to == from) {
+                return v;
+            }
+
+            if (vertexTarget[v] == NO_VERTEX) {
+                TRIPLE n = normal(v);
+                float bestDot = -std::numeric_limits<float>::max();
+
+                for (unsigned int i = classStart[to]; i < classStart[to + 1]; ++i) {
+                    float d = glm::dot(n, normal(byPosition[i]));
+                    if (d > bestDot) {
+                        bestDot = d;
+                        vertexTarget[v] = byPosition[i];
+                    }
+                }
+            }
+
+            return vertexTarget[v];
+        };
+
+        size_t kept = 0;
+        for (std::array<unsigned int, 3>& triangle : triangles) {
+            for (unsigned int& v : triangle) {
+                v = moved(v);
+            }
+
+            unsigned int c0 = classOf[triangle[0]], c1 = classOf[triangle[1]], c2 = classOf[triangle[2]];
+            if (c0 != c1 && c1 != c2 && c2 != c0) {
+                triangles[kept++] = triangle;
+            }
+        }
+
+        triangles.resize(kept);
+
+        // Collapses are only ever one step deep within a pass, the next pass starts from the moved classes
+        for (size_t c = 0; c < classCount; ++c) {
+            collapseTarget[c] = static_cast<unsigned int>(c);
+        }
+    }
+
+    std::vector<unsigned int> result;
+    result.reserve(3 * triangles.size());
+
+    for (const std::array<unsigned int, 3>& triangle : triangles) {
+        result.insert(result.end(), triangle.begin(), triangle.end());
+    }
+
+    return result;
+}
+
+std::vector<std::vector<unsigned int>> buildLodChain(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, size_t triangleBudget) {
+    std::vector<std::vector<unsigned int>> levels;
+
+    if (indices.size() / 3 <= triangleBudget || vertices.empty()) {
+        return levels;
+    }
+
+    TRIPLE minBound{ std::numeric_limits<float>::max() };
+    TRIPLE maxBound{ -std::numeric_limits<float>::max() };
+
+    for (size_t v = 0; v < vertices.size() / 6; ++v) {
+        TRIPLE p{ vertices[6 * v], vertices[6 * v + 1], vertices[6 * v + 2] };
+        minBound = glm::min(minBound, p);
+        maxBound = glm::max(maxBound, p);
+    }
+
+    float targetError = LOD_RELATIVE_ERROR * glm::length(maxBound - minBound);
+
+    while (true) {
+        const std::vector<unsigned int>& source = levels.empty() ? indices : levels.back();
+
+        if (source.size() / 3 <= triangleBudget) {
+            break;
+        }
+
+        std::vector<unsigned int> level = simplifyMesh(vertices, source, std::max(source.size() / LOD_REDUCTION, 3 * triangleBudget), targetError);
+
+        if (static_cast<double>(level.size()) * MIN_LOD_SHRINK > static_cast<double>(source.size())) {
+            break;
+        }
+
+        levels.push_back(std::move(level));
+    }
+
+    return levels;
+}
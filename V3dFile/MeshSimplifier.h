@@ -0,0 +1,16 @@
+#pragma once
+
+#include <vector>
+
+#include "V3dTypes.h"
+
+// Simplifies a triangle list by quadric error edge collapse (Garland and Heckbert 1997) until at most targetIndexCount
+// indices are left or every further collapse would move the surface by more than targetError model units. Only
+// collapses onto an existing vertex, so the result indexes the same interleaved position and normal vertices. Vertices
+// that share a position are collapsed together, each corner then takes the vertex with the closest normal.
+std::vector<unsigned int> simplifyMesh(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, size_t targetIndexCount, float targetError);
+
+// Successively coarser index lists over vertices, each about a quarter of the one before, down to at most
+// triangleBudget triangles. Stops early when the allowed error keeps a level from getting much smaller, empty when the
+// mesh already fits the budget.
+std::vector<std::vector<unsigned int>> buildLodChain(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, size_t triangleBudget);
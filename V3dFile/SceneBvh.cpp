@@ -0,0 +1,619 @@
+#include "SceneBvh.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "../Utility/ThreadPool.h"
+
+namespace {
+
+constexpr size_t SAH_BINS = 16;
+
+// Leaves hold at most this many primitives unless their centroids coincide
+constexpr size_t MAX_LEAF_PRIMITIVES = 4;
+
+// Cost of visiting an inner node relative to intersecting one primitive
+constexpr float TRAVERSAL_COST = 1.0f;
+
+// Deeper ranges become leaves, which bounds the traversal stack
+constexpr size_t MAX_DEPTH = 64;
+
+// Ranges up to this size are built in one task, the levels above them are split on the calling thread
+constexpr size_t MIN_TASK_PRIMITIVES = 4096;
+
+struct Bounds {
+    TRIPLE minBound{ std::numeric_limits<float>::max() };
+    TRIPLE maxBound{ -std::numeric_limits<float>::max() };
+
+    void grow(const TRIPLE& point) {
+        minBound = glm::min(minBound, point);
+        maxBound = glm::max(maxBound, point);
+    }
+
+    void grow(const Bounds& other) {
+        minBound = glm::min(minBound, other.minBound);
+        maxBound = glm::max(maxBound, other.maxBound);
+    }
+
+    // Half the surface area, only compared against other areas
+    float area() const {
+        TRIPLE extent = maxBound - minBound;
+        return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+    }
+};
+
+// Bounds of the unit meshes the instances place
+constexpr std::array<std::array<float, 6>, INSTANCE_TEMPLATE_COUNT> TEMPLATE_BOUNDS{ {
+    { -1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f },     // Sphere
+    { -1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 1.0f },      // Hemisphere
+    { -1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 0.0f },      // Disk
+    { -1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 1.0f },      // Cylinder
+} };
+
+Bounds instanceBounds(const PrimitiveInstance& instance, UINT source) {
+    const std::array<float, 6>& unit = TEMPLATE_BOUNDS[source];
+    TRIPLE center{ 0.5f * (unit[0] + unit[3]), 0.5f * (unit[1] + unit[4]), 0.5f * (unit[2] + unit[5]) };
+    TRIPLE extent{ 0.5f * (unit[3] - unit[0]), 0.5f * (unit[4] - unit[1]), 0.5f * (unit[5] - unit[2]) };
+
+    Bounds bounds;
+    for (int row = 0; row < 3; ++row) {
+        const glm::vec4& r = instance.transform[row];
+        float c = r.x * center.x + r.y * center.y + r.z * center.z + r.w;
+        float e = std::abs(r.x) * extent.x + std::abs(r.y) * extent.y + std::abs(r.z) * extent.z;
+
+        bounds.minBound[row] = c - e;
+        bounds.maxBound[row] = c + e;
+    }
+
+    return bounds;
+}
+
+std::array<glm::vec4, 3> invertTransform(const std::array<glm::vec4, 3>& transform) {
+    TRIPLE columns[3];
+    for (int column = 0; column < 3; ++column) {
+        columns[column] = TRIPLE{ transform[0][column], transform[1][column], transform[2][column] };
+    }
+    TRIPLE translation{ transform[0].w, transform[1].w, transform[2].w };
+
+    // Rows of the inverse are the cross products of the columns, over the determinant
+    TRIPLE rows[3] = { glm::cross(columns[1], columns[2]), glm::cross(columns[2], columns[0]), glm::cross(columns[0], columns[1]) };
+    float determinant = glm::dot(columns[0], rows[0]);
+
+    std::array<glm::vec4, 3> inverse{ };
+    if (determinant == 0.0f) {
+        // Collapsed instances are never hit
+        return inverse;
+    }
+
+    for (int row = 0; row < 3; ++row) {
+        TRIPLE r = rows[row] / determinant;
+        inverse[row] = glm::vec4{ r.x, r.y, r.z, -glm::dot(r, translation) };
+    }
+
+    return inverse;
+}
+
+TRIPLE transformPoint(const std::array<glm::vec4, 3>& transform, const TRIPLE& p) {
+    return TRIPLE{
+        transform[0].x * p.x + transform[0].y * p.y + transform[0].z * p.z + transform[0].w,
+        transform[1].x * p.x + transform[1].y * p.y + transform[1].z * p.z + transform[1].w,
+        transform[2].x * p.x + transform[2].y * p.y + transform[2].z * p.z + transform[2].w };
+}
+
+TRIPLE transformVector(const std::array<glm::vec4, 3>& transform, const TRIPLE& v) {
+    return TRIPLE{
+        transform[0].x * v.x + transform[0].y * v.y + transform[0].z * v.z,
+        transform[1].x * v.x + transform[1].y * v.y + transform[1].z * v.z,
+        transform[2].x * v.x + transform[2].y * v.y + transform[2].z * v.z };
+}
+
+// Roots of a t^2 + 2 b t + c in increasing order
+bool solveQuadratic(float a, float b, float c, float& t0, float& t1) {
+    float discriminant = b * b - a * c;
+    if (a == 0.0f || discriminant < 0.0f) {
+        return false;
+    }
+
+    float root = std::sqrt(discriminant);
+    t0 = (-b - root) / a;
+    t1 = (-b + root) / a;
+
+    return true;
+}
+
+// Primitive as the builder sorts it, kept contiguous so every pass over a range streams through memory
+struct BuildPrimitive {
+    Bounds bounds;
+    TRIPLE centroid;
+    UINT primitive;
+};
+
+// Range of build primitives with the bounds of their boxes and of their centroids
+struct BuildRange {
+    BuildRange() = default;
+    // Empty bounds, grown as primitives are added
+    BuildRange(size_t begin, size_t end) : begin{ begin }, end{ end } { }
+
+    size_t begin{ 0 };
+    size_t end{ 0 };
+    Bounds bounds;
+    Bounds centroidBounds;
+};
+
+BuildRange measureRange(const std::vector<BuildPrimitive>& primitives, size_t begin, size_t end) {
+    BuildRange range{ begin, end };
+    for (size_t i = begin; i < end; ++i) {
+        range.bounds.grow(primitives[i].bounds);
+        range.centroidBounds.grow(primitives[i].centroid);
+    }
+
+    return range;
+}
+
+// Builds the hierarchy over the build primitives, reordering them into leaf order
+class BvhBuilder {
+public:
+    BvhBuilder(std::vector<BuildPrimitive>& primitives) : m_Primitives{ primitives } { }
+
+    void build(ThreadPool& pool, std::vector<BvhNode>& nodes);
+
+private:
+    // Node of the levels split on the calling thread, either split further or built by a task
+    struct TopNode {
+        BuildRange range;
+        size_t firstChild{ 0 };
+        size_t task{ 0 };
+        bool split{ false };
+    };
+
+    // Partitions the range along the cheapest split into left and right, returns false for a leaf
+    bool split(const BuildRange& range, size_t depth, BuildRange& left, BuildRange& right);
+
+    void buildSubtree(const BuildRange& range, size_t depth, std::vector<BvhNode>& nodes);
+    void emitTop(size_t top, std::vector<BvhNode>& nodes);
+
+    std::vector<BuildPrimitive>& m_Primitives;
+
+    std::vector<TopNode> m_Top;
+    std::vector<std::vector<BvhNode>> m_Subtrees;
+};
+
+bool BvhBuilder::split(const BuildRange& range, size_t depth, BuildRange& left, BuildRange& right) {
+    size_t count = range.end - range.begin;
+
+    if (count <= 1 || depth >= MAX_DEPTH) {
+        return false;
+    }
+
+    const Bounds& centroidBounds = range.centroidBounds;
+    TRIPLE extent = centroidBounds.maxBound - centroidBounds.minBound;
+    TRIPLE scale{ 0.0f };
+
+    for (int axis = 0; axis < 3; ++axis) {
+        if (extent[axis] > 0.0f) {
+            scale[axis] = SAH_BINS / extent[axis];
+        }
+    }
+
+    // Every axis is binned in the same pass
+    std::array<std::array<Bounds, SAH_BINS>, 3> bins;
+    std::array<std::array<size_t, SAH_BINS>, 3> counts{ };
+
+    auto binOf = [&centroidBounds, &scale](const TRIPLE& centroid, int axis) {
+        return std::min(SAH_BINS - 1, static_cast<size_t>((centroid[axis] - centroidBounds.minBound[axis]) * scale[axis]));
+    };
+
+    for (size_t i = range.begin; i < range.end; ++i) {
+        const BuildPrimitive& primitive = m_Primitives[i];
+
+        for (int axis = 0; axis < 3; ++axis) {
+            size_t bin = binOf(primitive.centroid, axis);
+            bins[axis][bin].grow(primitive.bounds);
+            ++counts[axis][bin];
+        }
+    }
+
+    float bestCost = std::numeric_limits<float>::max();
+    int bestAxis = -1;
+    size_t bestBin = 0;
+
+    for (int axis = 0; axis < 3; ++axis) {
+        if (extent[axis] <= 0.0f) {
+            continue;
+        }
+
+        // Sweep from the right, then evaluate every split from the left
+        std::array<float, SAH_BINS> rightCosts{ };
+        Bounds rightBounds;
+        size_t rightCount = 0;
+
+        for (size_t bin = SAH_BINS - 1; bin > 0; --bin) {
+            rightBounds.grow(bins[axis][bin]);
+            rightCount += counts[axis][bin];
+            rightCosts[bin] = rightCount > 0 ? rightBounds.area() * rightCount : 0.0f;
+        }
+
+        Bounds leftBounds;
+        size_t leftCount = 0;
+
+        for (size_t bin = 0; bin + 1 < SAH_BINS; ++bin) {
+            leftBounds.grow(bins[axis][bin]);
+            leftCount += counts[axis][bin];
+
+            if (leftCount == 0 || leftCount == count) {
+                continue;
+            }
+
+            float cost = leftBounds.area() * leftCount + rightCosts[bin + 1];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = bin;
+            }
+        }
+    }
+
+    if (bestAxis < 0) {
+        // Every centroid coincides, halve oversized leaves anyway
+        if (count <= MAX_LEAF_PRIMITIVES) {
+            return false;
+        }
+
+        size_t middle = range.begin + count / 2;
+        left = measureRange(m_Primitives, range.begin, middle);
+        right = measureRange(m_Primitives, middle, range.end);
+        return true;
+    }
+
+    float nodeArea = range.bounds.area();
+    float splitCost = TRAVERSAL_COST + (nodeArea > 0.0f ? bestCost / nodeArea : 0.0f);
+
+    if (count <= MAX_LEAF_PRIMITIVES && static_cast<float>(count) <= splitCost) {
+        return false;
+    }
+
+    left = BuildRange{ range.begin, range.begin };
+    right = BuildRange{ range.end, range.end };
+
+    for (size_t bin = 0; bin < SAH_BINS; ++bin) {
+        (bin <= bestBin ? left : right).bounds.grow(bins[bestAxis][bin]);
+    }
+
+    // Partition from both ends, collecting the centroid bounds of either side on the way
+    while (left.end < right.begin) {
+        BuildPrimitive& primitive = m_Primitives[left.end];
+
+        if (binOf(primitive.centroid, bestAxis) <= bestBin) {
+            left.centroidBounds.grow(primitive.centroid);
+            ++left.end;
+        } else {
+            right.centroidBounds.grow(primitive.centroid);
+            std::swap(primitive, m_Primitives[--right.begin]);
+        }
+    }
+
+    return true;
+}
+
+void BvhBuilder::buildSubtree(const BuildRange& range, size_t depth, std::vector<BvhNode>& nodes) {
+    size_t index = nodes.size();
+    nodes.push_back(BvhNode{ range.bounds.minBound, 0, range.bounds.maxBound, 0 });
+
+    BuildRange left, right;
+
+    if (!split(range, depth, left, right)) {
+        nodes[index].count = static_cast<UINT>(range.end - range.begin);
+        nodes[index].offset = static_cast<UINT>(range.begin);
+        return;
+    }
+
+    buildSubtree(left, depth + 1, nodes);
+    nodes[index].offset = static_cast<UINT>(nodes.size() - index);
+    buildSubtree(right, depth + 1, nodes);
+}
+
+void BvhBuilder::emitTop(size_t top, std::vector<BvhNode>& nodes) {
+    const TopNode& node = m_Top[top];
+
+    if (!node.split) {
+        // Offsets within a subtree are relative, so it is appended as is
+        const std::vector<BvhNode>& subtree = m_Subtrees[node.task];
+        nodes.insert(nodes.end(), subtree.begin(), subtree.end());
+        return;
+    }
+
+    size_t index = nodes.size();
+    nodes.push_back(BvhNode{ node.range.bounds.minBound, 0, node.range.bounds.maxBound, 0 });
+
+    emitTop(node.firstChild, nodes);
+    nodes[index].offset = static_cast<UINT>(nodes.size() - index);
+    emitTop(node.firstChild + 1, nodes);
+}
+
+void BvhBuilder::build(ThreadPool& pool, std::vector<BvhNode>& nodes) {
+    size_t taskPrimitives = std::max(MIN_TASK_PRIMITIVES, m_Primitives.size() / (4 * std::max<size_t>(pool.threadCount(), 1)));
+
+    // Breadth first over the top levels, every range too small to split further here becomes a task
+    m_Top.push_back(TopNode{ measureRange(m_Primitives, 0, m_Primitives.size()) });
+    std::vector<std::pair<size_t, size_t>> tasks;   // Top node and depth
+
+    for (size_t top = 0, depth = 0, levelEnd = 1; top < m_Top.size(); ++top) {
+        if (top == levelEnd) {
+            ++depth;
+            levelEnd = m_Top.size();
+        }
+
+        BuildRange range = m_Top[top].range;
+        BuildRange left, right;
+
+        if (range.end - range.begin <= taskPrimitives || !split(range, depth, left, right)) {
+            m_Top[top].task = tasks.size();
+            tasks.emplace_back(top, depth);
+            continue;
+        }
+
+        m_Top[top].split = true;
+        m_Top[top].firstChild = m_Top.size();
+
+        m_Top.push_back(TopNode{ left });
+        m_Top.push_back(TopNode{ right });
+    }
+
+    m_Subtrees.resize(tasks.size());
+
+    TaskGroup group{ pool };
+
+    for (size_t t = 0; t < tasks.size(); ++t) {
+        group.run([this, &tasks, t]() {
+            buildSubtree(m_Top[tasks[t].first].range, tasks[t].second, m_Subtrees[t]);
+        });
+    }
+
+    group.wait();
+
+    emitTop(0, nodes);
+}
+
+}
+
+SceneBvh::SceneBvh(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, const InstanceLists& instances, ThreadPool& pool) {
+    size_t triangleCount = indices.size() / 3;
+
+    size_t primitiveCount = triangleCount;
+    for (const std::vector<PrimitiveInstance>& list : instances) {
+        primitiveCount += list.size();
+    }
+
+    if (primitiveCount == 0) {
+        return;
+    }
+
+    std::vector<ScenePrimitive> primitives;
+    primitives.reserve(primitiveCount);
+
+    for (UINT t = 0; t < triangleCount; ++t) {
+        primitives.push_back(ScenePrimitive{ TRIANGLE_SOURCE, t });
+    }
+
+    for (UINT source = 0; source < INSTANCE_TEMPLATE_COUNT; ++source) {
+        for (UINT i = 0; i < instances[source].size(); ++i) {
+            primitives.push_back(ScenePrimitive{ source, i });
+        }
+    }
+
+    m_Triangles.resize(triangleCount);
+    for (UINT source = 0; source < INSTANCE_TEMPLATE_COUNT; ++source) {
+        m_InverseTransforms[source].resize(instances[source].size());
+    }
+
+    std::vector<BuildPrimitive> build(primitiveCount);
+
+    parallelFor(pool, primitiveCount, [&](size_t, size_t begin, size_t end) {
+        for (size_t p = begin; p < end; ++p) {
+            const ScenePrimitive& primitive = primitives[p];
+            Bounds& bounds = build[p].bounds;
+
+            if (primitive.source == TRIANGLE_SOURCE) {
+                std::array<TRIPLE, 3>& triangle = m_Triangles[primitive.index];
+
+                for (size_t k = 0; k < 3; ++k) {
+                    const float* position = &vertices[6 * size_t(indices[3 * size_t(primitive.index) + k])];
+                    triangle[k] = TRIPLE{ position[0], position[1], position[2] };
+                    bounds.grow(triangle[k]);
+                }
+            } else {
+                const PrimitiveInstance& instance = instances[primitive.source][primitive.index];
+
+                m_InverseTransforms[primitive.source][primitive.index] = invertTransform(instance.transform);
+                bounds = instanceBounds(instance, primitive.source);
+            }
+
+            build[p].centroid = 0.5f * (bounds.minBound + bounds.maxBound);
+            build[p].primitive = static_cast<UINT>(p);
+        }
+    });
+
+    BvhBuilder builder{ build };
+    builder.build(pool, m_Nodes);
+
+    m_Primitives.resize(primitiveCount);
+    for (size_t i = 0; i < primitiveCount; ++i) {
+        m_Primitives[i] = primitives[build[i].primitive];
+    }
+}
+
+size_t SceneBvh::memoryUsage() const {
+    size_t bytes = sizeof(*this) + m_Nodes.capacity() * sizeof(BvhNode) + m_Primitives.capacity() * sizeof(ScenePrimitive)
+        + m_Triangles.capacity() * sizeof(std::array<TRIPLE, 3>);
+
+    for (const auto& transforms : m_InverseTransforms) {
+        bytes += transforms.capacity() * sizeof(std::array<glm::vec4, 3>);
+    }
+
+    return bytes;
+}
+
+bool SceneBvh::intersectPrimitive(const ScenePrimitive& primitive, const TRIPLE& origin, const TRIPLE& direction, float& distance) const {
+    if (primitive.source == TRIANGLE_SOURCE) {
+        // Moller and Trumbore, from both sides
+        const std::array<TRIPLE, 3>& triangle = m_Triangles[primitive.index];
+        TRIPLE edge1 = triangle[1] - triangle[0];
+        TRIPLE edge2 = triangle[2] - triangle[0];
+
+        TRIPLE p = glm::cross(direction, edge2);
+        float determinant = glm::dot(edge1, p);
+        if (determinant == 0.0f) {
+            return false;
+        }
+
+        float inverse = 1.0f / determinant;
+        TRIPLE s = origin - triangle[0];
+
+        float u = glm::dot(s, p) * inverse;
+        if (u < 0.0f || u > 1.0f) {
+            return false;
+        }
+
+        TRIPLE q = glm::cross(s, edge1);
+        float v = glm::dot(direction, q) * inverse;
+        if (v < 0.0f || u + v > 1.0f) {
+            return false;
+        }
+
+        distance = glm::dot(edge2, q) * inverse;
+        return distance >= 0.0f;
+    }
+
+    // In the space of the unit mesh, where t still measures along the original ray
+    const std::array<glm::vec4, 3>& inverse = m_InverseTransforms[primitive.source][primitive.index];
+    TRIPLE o = transformPoint(inverse, origin);
+    TRIPLE d = transformVector(inverse, direction);
+
+    float t0, t1;
+
+    switch (primitive.source) {
+    case SPHERE_TEMPLATE:
+    case HEMISPHERE_TEMPLATE:
+        if (!solveQuadratic(glm::dot(d, d), glm::dot(o, d), glm::dot(o, o) - 1.0f, t0, t1)) {
+            return false;
+        }
+
+        for (float t : { t0, t1 }) {
+            if (t >= 0.0f && (primitive.source == SPHERE_TEMPLATE || o.z + t * d.z >= 0.0f)) {
+                distance = t;
+                return true;
+            }
+        }
+        return false;
+
+    case DISK_TEMPLATE: {
+        if (d.z == 0.0f) {
+            return false;
+        }
+
+        float t = -o.z / d.z;
+        float x = o.x + t * d.x;
+        float y = o.y + t * d.y;
+
+        distance = t;
+        return t >= 0.0f && x * x + y * y <= 1.0f;
+    }
+
+    case CYLINDER_TEMPLATE:
+        if (!solveQuadratic(d.x * d.x + d.y * d.y, o.x * d.x + o.y * d.y, o.x * o.x + o.y * o.y - 1.0f, t0, t1)) {
+            return false;
+        }
+
+        for (float t : { t0, t1 }) {
+            float z = o.z + t * d.z;
+
+            if (t >= 0.0f && z >= 0.0f && z <= 1.0f) {
+                distance = t;
+                return true;
+            }
+        }
+        return false;
+
+    default:
+        return false;
+    }
+}
+
+bool SceneBvh::intersectRay(const TRIPLE& origin, const TRIPLE& direction, float maxDistance, BvhHit& hit) const {
+    if (m_Nodes.empty()) {
+        return false;
+    }
+
+    TRIPLE inverseDirection{ 1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z };
+
+    // Entry distance of the ray into a node, or infinity when it misses it or only enters beyond the nearest hit
+    auto enter = [&](const BvhNode& node, float limit) {
+        TRIPLE t0 = (node.minBound - origin) * inverseDirection;
+        TRIPLE t1 = (node.maxBound - origin) * inverseDirection;
+        TRIPLE near = glm::min(t0, t1);
+        TRIPLE far = glm::max(t0, t1);
+
+        float entry = std::max(std::max(near.x, near.y), std::max(near.z, 0.0f));
+        float exit = std::min(std::min(far.x, far.y), std::min(far.z, limit));
+
+        return entry <= exit ? entry : std::numeric_limits<float>::infinity();
+    };
+
+    float nearest = maxDistance;
+    bool found = false;
+
+    std::array<UINT, MAX_DEPTH + 1> stack;
+    size_t stackSize = 0;
+
+    UINT index = 0;
+    if (enter(m_Nodes[0], nearest) == std::numeric_limits<float>::infinity()) {
+        return false;
+    }
+
+    while (true) {
+        const BvhNode& node = m_Nodes[index];
+
+        if (node.count > 0) {
+            for (UINT i = node.offset; i < node.offset + node.count; ++i) {
+                float distance;
+
+                if (intersectPrimitive(m_Primitives[i], origin, direction, distance) && distance <= nearest) {
+                    nearest = distance;
+                    hit = BvhHit{ m_Primitives[i], distance };
+                    found = true;
+                }
+            }
+        } else {
+            // Nearer child first, the other one waits on the stack
+            UINT first = index + 1;
+            UINT second = index + node.offset;
+
+            float firstEntry = enter(m_Nodes[first], nearest);
+            float secondEntry = enter(m_Nodes[second], nearest);
+
+            if (secondEntry < firstEntry) {
+                std::swap(first, second);
+                std::swap(firstEntry, secondEntry);
+            }
+
+            if (firstEntry != std::numeric_limits<float>::infinity()) {
+                if (secondEntry != std::numeric_limits<float>::infinity()) {
+                    stack[stackSize++] = second;
+                }
+
+                index = first;
+                continue;
+            }
+        }
+
+        // Nodes on the stack may have fallen behind a hit found since they were pushed
+        do {
+            if (stackSize == 0) {
+                return found;
+            }
+
+            index = stack[--stackSize];
+        } while (enter(m_Nodes[index], nearest) == std::numeric_limits<float>::infinity());
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "V3dTypes.h"
+#include "V3dInstances.h"
+
+class ThreadPool;
+
+// Source of the triangles of a scene, the other sources are the instance templates
+constexpr UINT TRIANGLE_SOURCE = INSTANCE_TEMPLATE_COUNT;
+
+// Triangle indices[3 * index] when source is TRIANGLE_SOURCE, instances[source][index] otherwise
+struct ScenePrimitive {
+    UINT source;
+    UINT index;
+};
+
+struct BvhHit {
+    ScenePrimitive primitive;
+    float distance;     // In units of the ray direction
+};
+
+// Flattened depth first, the first child of an inner node follows it directly
+struct BvhNode {
+    TRIPLE minBound;
+    UINT count;         // Primitives of a leaf, 0 for an inner node
+    TRIPLE maxBound;
+    UINT offset;        // First primitive of a leaf, distance to the second child of an inner node
+};
+
+// Bounding volume hierarchy over the triangles and instanced primitives of a scene, split with the binned surface
+// area heuristic. Keeps its own copy of what the queries need, the geometry it was built from may change afterwards.
+class SceneBvh {
+public:
+    SceneBvh(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, const InstanceLists& instances, ThreadPool& pool);
+
+    // Nearest primitive along origin + t * direction with t in [0, maxDistance]. Surfaces are hit from either side,
+    // instances are hit on the shape of their unit mesh.
+    bool intersectRay(const TRIPLE& origin, const TRIPLE& direction, float maxDistance, BvhHit& hit) const;
+
+    bool empty() const { return m_Primitives.empty(); }
+    size_t nodeCount() const { return m_Nodes.size(); }
+    size_t memoryUsage() const;
+
+private:
+    bool intersectPrimitive(const ScenePrimitive& primitive, const TRIPLE& origin, const TRIPLE& direction, float& distance) const;
+
+    std::vector<BvhNode> m_Nodes;
+    std::vector<ScenePrimitive> m_Primitives;   // In leaf order
+
+    std::vector<std::array<TRIPLE, 3>> m_Triangles;
+
+    // Rows of the 3x4 matrix taking model space into the unit mesh of every instance, per template
+    std::array<std::vector<std::array<glm::vec4, 3>>, INSTANCE_TEMPLATE_COUNT> m_InverseTransforms;
+};
@@ -0,0 +1,48 @@
+#include "SurfaceControlData.h"
+
+#include <algorithm>
+
+void SurfaceControlData::push(const BezierPatchDescriptor& surface) {
+    size_t pointCount = surface.triangle ? 10 : 16;
+    size_t colorCount = surface.triangle ? 3 : 4;
+
+    m_FirstPoint.push_back(static_cast<uint32_t>(m_Points.size()));
+    m_Points.insert(m_Points.end(), surface.controlPoints.begin(), surface.controlPoints.begin() + pointCount);
+
+    if (surface.colored) {
+        m_FirstColor.push_back(static_cast<uint32_t>(m_CornerColors.size()));
+        m_CornerColors.insert(m_CornerColors.end(), surface.cornerColors.begin(), surface.cornerColors.begin() + colorCount);
+    } else {
+        m_FirstColor.push_back(NO_COLORS);
+    }
+}
+
+BezierPatchDescriptor SurfaceControlData::descriptor(size_t i) const {
+    size_t firstPoint = m_FirstPoint[i];
+    size_t lastPoint = i + 1 < m_FirstPoint.size() ? m_FirstPoint[i + 1] : m_Points.size();
+
+    BezierPatchDescriptor surface{ };
+    surface.triangle = lastPoint - firstPoint == 10;
+    std::copy(m_Points.begin() + firstPoint, m_Points.begin() + lastPoint, surface.controlPoints.begin());
+
+    if (m_FirstColor[i] != NO_COLORS) {
+        size_t colorCount = surface.triangle ? 3 : 4;
+
+        surface.colored = true;
+        std::copy_n(m_CornerColors.begin() + m_FirstColor[i], colorCount, surface.cornerColors.begin());
+    }
+
+    return surface;
+}
+
+void SurfaceControlData::shrinkToFit() {
+    m_Points.shrink_to_fit();
+    m_CornerColors.shrink_to_fit();
+    m_FirstPoint.shrink_to_fit();
+    m_FirstColor.shrink_to_fit();
+}
+
+size_t SurfaceControlData::memoryUsage() const {
+    return m_Points.capacity() * sizeof(TRIPLE) + m_CornerColors.capacity() * sizeof(RGBA)
+        + (m_FirstPoint.capacity() + m_FirstColor.capacity()) * sizeof(uint32_t);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+#include "BezierPatchTessellator.h"
+
+// Control points and corner colors of the Bezier surfaces of a file, kept for re-meshing as the view changes.
+// Stored back to back by field rather than as descriptors: a triangle takes 10 points instead of 16, and only
+// colored surfaces hold corner colors.
+class SurfaceControlData {
+public:
+    void push(const BezierPatchDescriptor& surface);
+
+    size_t size() const { return m_FirstPoint.size(); }
+    bool empty() const { return m_FirstPoint.empty(); }
+
+    // Descriptor of surface i, its tolerance is left at zero
+    BezierPatchDescriptor descriptor(size_t i) const;
+
+    // Releases the slack left by the pushes
+    void shrinkToFit();
+
+    size_t memoryUsage() const;
+
+private:
+    static constexpr uint32_t NO_COLORS = ~0u;
+
+    std::vector<TRIPLE> m_Points;
+    std::vector<RGBA> m_CornerColors;
+
+    // Per surface, its number of points tells a patch from a triangle
+    std::vector<uint32_t> m_FirstPoint;
+    std::vector<uint32_t> m_FirstColor;
+};
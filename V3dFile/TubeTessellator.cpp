@@ -0,0 +1,248 @@
+#include "TubeTessellator.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include <glm/ext/scalar_constants.hpp>
+
+#include "../Utility/ThreadPool.h"
+
+namespace {
+
+constexpr unsigned int MAX_SEGMENTS = 64;
+constexpr unsigned int MIN_SIDES = 3;
+constexpr unsigned int MAX_SIDES = 64;
+
+// Parameter distance used to step off an end of the centerline when its tangent vanishes
+constexpr float TANGENT_OFFSET = 1e-3f;
+
+TRIPLE bezier(const std::array<TRIPLE, 4>& P, float t) {
+    float s = 1.0f - t;
+    return s * s * s * P[0] + 3.0f * t * s * s * P[1] + 3.0f * t * t * s * P[2] + t * t * t * P[3];
+}
+
+TRIPLE bezierTangent(const std::array<TRIPLE, 4>& P, float t) {
+    float s = 1.0f - t;
+    return 3.0f * s * s * (P[1] - P[0]) + 6.0f * t * s * (P[2] - P[1]) + 3.0f * t * t * (P[3] - P[2]);
+}
+
+TRIPLE unitTangent(const std::array<TRIPLE, 4>& P, float t) {
+    TRIPLE tangent = bezierTangent(P, t);
+
+    // Coincident control points at an end, borrow the direction from just inside the curve
+    if (glm::dot(tangent, tangent) == 0.0f) {
+        tangent = bezierTangent(P, std::clamp(t, TANGENT_OFFSET, 1.0f - TANGENT_OFFSET));
+    }
+
+    if (glm::dot(tangent, tangent) == 0.0f) {
+        tangent = P[3] - P[0];
+    }
+
+    float length = glm::length(tangent);
+    return length > 0.0f ? tangent / length : TRIPLE{ 0.0f, 0.0f, 1.0f };
+}
+
+// Any unit vector perpendicular to t
+TRIPLE perpendicular(const TRIPLE& t) {
+    TRIPLE axis = std::abs(t.x) < std::abs(t.y)
+        ? (std::abs(t.x) < std::abs(t.z) ? TRIPLE{ 1.0f, 0.0f, 0.0f } : TRIPLE{ 0.0f, 0.0f, 1.0f })
+        : (std::abs(t.y) < std::abs(t.z) ? TRIPLE{ 0.0f, 1.0f, 0.0f } : TRIPLE{ 0.0f, 0.0f, 1.0f });
+
+    return glm::normalize(glm::cross(t, axis));
+}
+
+void writeVertex(float* destination, const TRIPLE& position, const TRIPLE& normal) {
+    destination[0] = position.x;
+    destination[1] = position.y;
+    destination[2] = position.z;
+    destination[3] = normal.x;
+    destination[4] = normal.y;
+    destination[5] = normal.z;
+}
+
+}
+
+TubeLayout tubeLayout(const TubeDescriptor& tube) {
+    const std::array<TRIPLE, 4>& P = tube.controlPoints;
+
+    if (!(tube.tolerance > 0.0f) || !(tube.radius > 0.0f)) {
+        return TubeLayout{ MAX_SEGMENTS, MAX_SIDES };
+    }
+
+    // Largest angle a ring may turn by, or a side may span, before the surface strays more than the tolerance
+    float maxAngle = 2.0f * std::acos(std::max(1.0f - tube.tolerance / tube.radius, -1.0f));
+
+    // Wang's bound keeps the centerline within the tolerance, the bend of the control polygon bounds how far the
+    // rings turn in between, which matters once the tube is wide compared to the tolerance
+    float maxSecondDifference = std::max(glm::length(P[0] - 2.0f * P[1] + P[2]), glm::length(P[1] - 2.0f * P[2] + P[3]));
+
+    float bend = 0.0f;
+    TRIPLE previous{ 0.0f };
+    for (int i = 0; i < 3; ++i) {
+        TRIPLE leg = P[i + 1] - P[i];
+
+        if (glm::dot(leg, leg) == 0.0f) {
+            continue;
+        }
+
+        leg = glm::normalize(leg);
+        if (glm::dot(previous, previous) != 0.0f) {
+            bend += std::acos(std::clamp(glm::dot(previous, leg), -1.0f, 1.0f));
+        }
+        previous = leg;
+    }
+
+    float segments = std::max(std::ceil(std::sqrt(0.75f * maxSecondDifference / tube.tolerance)), std::ceil(bend / maxAngle));
+    float sides = std::ceil(2.0f * glm::pi<float>() / maxAngle);
+
+    TubeLayout layout;
+    layout.segments = segments < MAX_SEGMENTS ? std::max(static_cast<unsigned int>(segments), 1u) : MAX_SEGMENTS;
+    layout.sides = sides < MAX_SIDES ? std::max(static_cast<unsigned int>(sides), MIN_SIDES) : MAX_SIDES;
+
+    return layout;
+}
+
+void tessellateTube(const TubeDescriptor& tube, const TubeLayout& layout, float* vertices, unsigned int* indices, unsigned int baseVertex,
+    float* coreVertices, unsigned int* coreIndices, unsigned int coreBaseVertex) {
+    const std::array<TRIPLE, 4>& P = tube.controlPoints;
+
+    std::vector<float> cosines(layout.sides);
+    std::vector<float> sines(layout.sides);
+    for (unsigned int side = 0; side < layout.sides; ++side) {
+        float angle = 2.0f * glm::pi<float>() * side / layout.sides;
+        cosines[side] = std::cos(angle);
+        sines[side] = std::sin(angle);
+    }
+
+    TRIPLE position = bezier(P, 0.0f);
+    TRIPLE tangent = unitTangent(P, 0.0f);
+    TRIPLE normal = perpendicular(tangent);
+
+    for (unsigned int segment = 0; segment <= layout.segments; ++segment) {
+        if (segment > 0) {
+            float t = static_cast<float>(segment) / layout.segments;
+
+            TRIPLE nextPosition = bezier(P, t);
+            TRIPLE nextTangent = unitTangent(P, t);
+
+            // Rotation minimizing frame by double reflection (Wang, Juttler, Zheng and Liu 2008)
+            TRIPLE v1 = nextPosition - position;
+            float c1 = glm::dot(v1, v1);
+
+            TRIPLE reflectedNormal = normal;
+            TRIPLE reflectedTangent = tangent;
+            if (c1 > 0.0f) {
+                reflectedNormal -= (2.0f / c1) * glm::dot(v1, normal) * v1;
+                reflectedTangent -= (2.0f / c1) * glm::dot(v1, tangent) * v1;
+            }
+
+            TRIPLE v2 = nextTangent - reflectedTangent;
+            float c2 = glm::dot(v2, v2);
+            if (c2 > 0.0f) {
+                reflectedNormal -= (2.0f / c2) * glm::dot(v2, reflectedNormal) * v2;
+            }
+
+            // Keep the frame orthonormal against rounding
+            reflectedNormal -= glm::dot(reflectedNormal, nextTangent) * nextTangent;
+            float length = glm::length(reflectedNormal);
+            normal = length > 0.0f ? reflectedNormal / length : perpendicular(nextTangent);
+
+            position = nextPosition;
+            tangent = nextTangent;
+        }
+
+        TRIPLE binormal = glm::cross(tangent, normal);
+
+        for (unsigned int side = 0; side < layout.sides; ++side) {
+            TRIPLE direction = cosines[side] * normal + sines[side] * binormal;
+            writeVertex(vertices, position + tube.radius * direction, direction);
+            vertices += 6;
+        }
+
+        if (tube.core) {
+            // Lines carry no normal
+            writeVertex(coreVertices, position, TRIPLE{ 0.0f });
+            coreVertices += 6;
+        }
+    }
+
+    for (unsigned int segment = 0; segment < layout.segments; ++segment) {
+        unsigned int ring = baseVertex + segment * layout.sides;
+
+        for (unsigned int side = 0; side < layout.sides; ++side) {
+            unsigned int next = (side + 1) % layout.sides;
+
+            unsigned int i0 = ring + side;
+            unsigned int i1 = ring + next;
+            unsigned int i2 = i0 + layout.sides;
+            unsigned int i3 = i1 + layout.sides;
+
+            indices[0] = i0;
+            indices[1] = i1;
+            indices[2] = i3;
+            indices[3] = i0;
+            indices[4] = i3;
+            indices[5] = i2;
+            indices += 6;
+        }
+
+        if (tube.core) {
+            coreIndices[0] = coreBaseVertex + segment;
+            coreIndices[1] = coreBaseVertex + segment + 1;
+            coreIndices += 2;
+        }
+    }
+}
+
+void tessellateTubes(const std::vector<TubeDescriptor>& tubes, ThreadPool& pool, MeshBuffer& triangles, MeshBuffer& lines) {
+    if (tubes.empty()) {
+        return;
+    }
+
+    std::vector<TubeLayout> layouts(tubes.size());
+
+    struct Offsets {
+        size_t vertex;
+        size_t index;
+        size_t coreVertex;
+        size_t coreIndex;
+    };
+
+    std::vector<Offsets> offsets(tubes.size() + 1);
+    offsets[0] = Offsets{ triangles.vertexCount(), triangles.indices.size(), lines.vertexCount(), lines.indices.size() };
+
+    for (size_t i = 0; i < tubes.size(); ++i) {
+        layouts[i] = tubeLayout(tubes[i]);
+
+        size_t coreVertexCount = tubes[i].core ? layouts[i].segments + 1 : 0;
+        size_t coreIndexCount = tubes[i].core ? 2 * size_t(layouts[i].segments) : 0;
+
+        offsets[i + 1] = Offsets{
+            offsets[i].vertex + layouts[i].vertexCount(),
+            offsets[i].index + layouts[i].indexCount(),
+            offsets[i].coreVertex + coreVertexCount,
+            offsets[i].coreIndex + coreIndexCount
+        };
+    }
+
+    triangles.vertices.resize(6 * offsets.back().vertex);
+    triangles.indices.resize(offsets.back().index);
+
+    // Tubes have no colors of their own
+    if (!triangles.colors.empty()) {
+        triangles.fillColors();
+    }
+
+    lines.vertices.resize(6 * offsets.back().coreVertex);
+    lines.indices.resize(offsets.back().coreIndex);
+
+    parallelFor(pool, tubes.size(), [&tubes, &layouts, &offsets, &triangles, &lines](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const Offsets& o = offsets[i];
+
+            tessellateTube(tubes[i], layouts[i],
+                triangles.vertices.data() + 6 * o.vertex, triangles.indices.data() + o.index, static_cast<unsigned int>(o.vertex),
+                lines.vertices.data() + 6 * o.coreVertex, lines.indices.data() + o.coreIndex, static_cast<unsigned int>(o.coreVertex));
+        }
+    });
+}
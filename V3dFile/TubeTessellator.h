@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "BezierPatchTessellator.h"
+
+// Everything needed to sweep a tube once the file has been parsed
+struct TubeDescriptor {
+    std::array<TRIPLE, 4> controlPoints;    // Cubic Bezier centerline
+    float radius;
+    float tolerance;
+    bool core;                              // Also emit the centerline as line geometry
+};
+
+// Size of the sweep of a tube, its mesh has (segments + 1) rings of sides vertices
+struct TubeLayout {
+    unsigned int segments;
+    unsigned int sides;
+
+    size_t vertexCount() const { return size_t(segments + 1) * sides; }
+    size_t indexCount() const { return 6 * size_t(segments) * sides; }
+};
+
+// Segments grow with the curvature of the centerline, sides with the projected width
+TubeLayout tubeLayout(const TubeDescriptor& tube);
+
+// Writes the mesh of a tube into vertices and indices, which have room for exactly layout's counts.
+// Indices start at baseVertex. With tube.core set, the layout.segments + 1 centerline points and
+// 2 * layout.segments line indices are written to coreVertices and coreIndices as well.
+void tessellateTube(const TubeDescriptor& tube, const TubeLayout& layout, float* vertices, unsigned int* indices, unsigned int baseVertex,
+    float* coreVertices, unsigned int* coreIndices, unsigned int coreBaseVertex);
+
+// Sweeps all tubes with parallelFor, appending their meshes to triangles and their cores to lines in order.
+void tessellateTubes(const std::vector<TubeDescriptor>& tubes, ThreadPool& pool, MeshBuffer& triangles, MeshBuffer& lines);
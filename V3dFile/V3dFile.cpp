@@ -8,6 +8,11 @@
 #include "xstream.h"
 
 #include "V3dUtil.h"
+#include "MappedFile.h"
+
+#include "MeshOptimizer.h"
+
+#include "../Utility/ThreadPool.h"
 
 // #define printObjectTypes
 
@@ -17,25 +22,41 @@
     #define PRINT_OBJECT_TYPE(t)
 #endif
 
-// append array b onto array a with offset
-void appendOffset(std::vector<UINT>& a, const std::vector<UINT>& b, size_t offset) {
-    size_t n=a.size();
-    size_t m=b.size();
-    a.resize(n+m);
-    for(size_t i=0; i < m; ++i)
-        a[n+i]=b[i]+(UINT)offset;
+namespace {
+
+// Lines and points carry no normal
+void appendUnlitVertex(std::vector<float>& vertices, const TRIPLE& position) {
+    vertices.insert(vertices.end(), { position.x, position.y, position.z, 0.0f, 0.0f, 0.0f });
+}
+
 }
 
-V3dFile::V3dFile(const std::string& fileName) { 
-    xdr::ixstream xdrFile{ fileName.c_str() };
+V3dFile::V3dFile(const std::string& fileName, const V3dLoadOptions& options)
+    : m_Options{ options } {
+    MappedFile file{ fileName };
+
+    if (!file.isOpen()) {
+        std::cout << "ERROR: Could not open v3d file: " << fileName << std::endl;
+        return;
+    }
+
+    XdrReader xdrFile{ file.data(), file.size() };
     load(xdrFile);
 }
 
-V3dFile::V3dFile(xdr::memixstream& xdrFile) {
-   load(xdrFile);
+V3dFile::V3dFile(const unsigned char* data, size_t size, const V3dLoadOptions& options)
+    : m_Options{ options } {
+    XdrReader xdrFile{ data, size };
+    load(xdrFile);
 }
 
-void V3dFile::load(xdr::ixstream& xdrFile) {
+V3dFile::V3dFile(xdr::memixstream& xdrFile, const V3dLoadOptions& options)
+    : m_Options{ options } {
+   load(static_cast<xdr::ixstream&>(xdrFile));
+}
+
+template<typename Reader>
+void V3dFile::load(Reader& xdrFile) {
     xdrFile >> versionNumber;
     xdrFile >> doublePrecisionFlag;
 
@@ -88,12 +109,7 @@ void V3dFile::load(xdr::ixstream& xdrFile) {
 
             if (centersLength > 0) {
                 centers.resize(centersLength);
-
-                for (UINT i = 0; i < centersLength; ++i) {
-                    centers[i].x = readReal(xdrFile, doublePrecisionFlag);
-                    centers[i].y = readReal(xdrFile, doublePrecisionFlag);
-                    centers[i].z = readReal(xdrFile, doublePrecisionFlag);
-                }
+                readReals(xdrFile, &centers[0].x, 3 * size_t(centersLength), doublePrecisionFlag);
             }
 
             break;
@@ -309,15 +325,216 @@ void V3dFile::load(xdr::ixstream& xdrFile) {
 
     xdrFile.close();
 
+    // Objects meshed once on load, assembled into the triangles below
+    std::vector<V3dObject*> meshObjects;
+
     for (auto& object : m_Objects) {
-        std::vector<float> vert = object->getVertexData();
-        std::vector<unsigned int> ind = object->getIndices();
+        switch (object->objectType) {
+            case ObjectTypes::BEZIER_PATCH:
+                m_Surfaces.push(static_cast<V3dBezierPatch*>(object.get())->descriptor(TessellationView{ }));
+                continue;
+            case ObjectTypes::BEZIER_TRIANGLE:
+                m_Surfaces.push(static_cast<V3dBezierTriangle*>(object.get())->descriptor(TessellationView{ }));
+                continue;
+            case ObjectTypes::BEZIER_PATCH_COLOR:
+                m_Surfaces.push(static_cast<V3dBezierPatchWithCornerColors*>(object.get())->descriptor(TessellationView{ }));
+                continue;
+            case ObjectTypes::BEZIER_TRIANGLE_COLOR:
+                m_Surfaces.push(static_cast<V3dBezierTriangleWithCornerColors*>(object.get())->descriptor(TessellationView{ }));
+                continue;
+            case ObjectTypes::LINE: {
+                auto segment = static_cast<V3dLineSegment*>(object.get());
+                UINT first = static_cast<UINT>(lineVertices.size() / 6);
+
+                appendUnlitVertex(lineVertices, segment->endpoints[0]);
+                appendUnlitVertex(lineVertices, segment->endpoints[1]);
+                lineIndices.insert(lineIndices.end(), { first, first + 1 });
+                continue;
+            }
+            case ObjectTypes::CURVE:
+                m_Curves.push_back(static_cast<V3dBezierCurve*>(object.get())->controlPoints);
+                continue;
+            case ObjectTypes::PIXEL:
+                appendUnlitVertex(pointVertices, static_cast<V3dPixel*>(object.get())->position);
+                continue;
+            case ObjectTypes::TUBE: {
+                auto tube = static_cast<V3dTube*>(object.get());
+                m_Tubes.push_back(TubeDescriptor{ tube->controlPoints, 0.5f * tube->width, 0.0f, tube->core != 0 });
+                continue;
+            }
+            case ObjectTypes::SPHERE:
+                instances[SPHERE_TEMPLATE].push_back(static_cast<V3dSphere*>(object.get())->instance());
+                continue;
+            case ObjectTypes::HALF_SPHERE:
+                instances[HEMISPHERE_TEMPLATE].push_back(static_cast<V3dHemiSphere*>(object.get())->instance());
+                continue;
+            case ObjectTypes::DISK:
+                instances[DISK_TEMPLATE].push_back(static_cast<V3dDisk*>(object.get())->instance());
+                continue;
+            case ObjectTypes::CYLINDER:
+                instances[CYLINDER_TEMPLATE].push_back(static_cast<V3dCylinder*>(object.get())->instance());
+                continue;
+            default:
+                meshObjects.push_back(object.get());
+                break;
+        }
+    }
+
+    MeshBuffer triangles;
+    assembleMesh(meshObjects, triangles);
 
-        appendOffset(indices, ind, vertices.size() / 6);
-        vertices.insert(vertices.end(), vert.begin(), vert.end());
+    m_StaticVertexCount = triangles.vertices.size();
+    m_StaticIndexCount = triangles.indices.size();
+    m_StaticColorCount = triangles.colors.size();
+    m_StaticLineVertexCount = lineVertices.size();
+    m_StaticLineIndexCount = lineIndices.size();
+
+    tessellationView = defaultTessellationView();
+
+    // Lines are never colored
+    MeshBuffer lines{ std::move(lineVertices), std::move(lineIndices), std::vector<uint32_t>{} };
+
+    if (m_Options.optimizeMeshes) {
+        optimizeMesh(triangles, 0, 0);
+
+        // Copies of vertices shared across 16 bit chunks are part of the static mesh
+        m_StaticVertexCount = triangles.vertices.size();
+        m_StaticColorCount = triangles.colors.size();
+    }
+
+    appendAdaptiveGeometry(tessellationView, triangles, lines);
+
+    mesh = std::make_shared<const MeshBuffer>(std::move(triangles));
+    lineVertices = std::move(lines.vertices);
+    lineIndices = std::move(lines.indices);
+
+    if (!m_Options.keepObjects) {
+        releaseObjects();
     }
 
-    if (indices.empty() || vertices.empty()) {
+    if (!hasGeometry()) {
         std::cout << "ERROR: Model is made up entirely of objects that cannot currently give vertices. It wont be rendered." << std::endl;
     }
 }
+
+void V3dFile::assembleMesh(const std::vector<V3dObject*>& objects, MeshBuffer& triangles) {
+    if (objects.empty()) {
+        return;
+    }
+
+    struct Offsets {
+        size_t vertex;
+        size_t index;
+    };
+
+    std::vector<Offsets> offsets(objects.size() + 1);
+    offsets[0] = Offsets{ triangles.vertexCount(), triangles.indices.size() };
+
+    bool withColors = !triangles.colors.empty();
+
+    for (size_t i = 0; i < objects.size(); ++i) {
+        offsets[i + 1] = Offsets{ offsets[i].vertex + objects[i]->vertexCount(), offsets[i].index + objects[i]->indexCount() };
+        withColors = withColors || objects[i]->hasColors();
+    }
+
+    triangles.vertices.resize(6 * offsets.back().vertex);
+    triangles.indices.resize(offsets.back().index);
+
+    // Objects without colors of their own keep the default
+    if (withColors) {
+        triangles.colors.resize(offsets.back().vertex, DEFAULT_VERTEX_COLOR);
+    }
+
+    parallelFor(ThreadPool::shared(), objects.size(), [&triangles, &objects, &offsets, withColors](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const Offsets& o = offsets[i];
+
+            objects[i]->writeVertices(triangles.vertices.data() + 6 * o.vertex);
+            objects[i]->writeIndices(triangles.indices.data() + o.index, static_cast<unsigned int>(o.vertex));
+
+            if (withColors && objects[i]->hasColors()) {
+                objects[i]->writeColors(triangles.colors.data() + o.vertex);
+            }
+        }
+    });
+}
+
+void V3dFile::releaseObjects() {
+    // Everything needed later lives in the buffers and the control data of the adaptive geometry
+    std::vector<std::unique_ptr<V3dObject>>{ }.swap(m_Objects);
+
+    m_Surfaces.shrinkToFit();
+    m_Tubes.shrink_to_fit();
+    m_Curves.shrink_to_fit();
+}
+
+bool V3dFile::hasGeometry() const {
+    if (!mesh->indices.empty() || !lineIndices.empty() || !pointVertices.empty()) {
+        return true;
+    }
+
+    for (auto& list : instances) {
+        if (!list.empty()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+TessellationView V3dFile::defaultTessellationView() const {
+    TessellationView view = tessellationViewForBounds(
+        headerInfo.minBound, headerInfo.maxBound,
+        static_cast<float>(headerInfo.canvasWidth), static_cast<float>(headerInfo.canvasHeight),
+        headerInfo.orthographic);
+
+    if (headerInfo.initialZoom > 0.0f) {
+        view.pixelSize /= headerInfo.initialZoom;
+    }
+
+    return view;
+}
+
+void V3dFile::buildMesh(const TessellationView& view, MeshBuffer& triangles, MeshBuffer& lines) const {
+    triangles.vertices.assign(mesh->vertices.begin(), mesh->vertices.begin() + m_StaticVertexCount);
+    triangles.indices.assign(mesh->indices.begin(), mesh->indices.begin() + m_StaticIndexCount);
+    triangles.colors.assign(mesh->colors.begin(), mesh->colors.begin() + m_StaticColorCount);
+    lines.vertices.assign(lineVertices.begin(), lineVertices.begin() + m_StaticLineVertexCount);
+    lines.indices.assign(lineIndices.begin(), lineIndices.begin() + m_StaticLineIndexCount);
+
+    appendAdaptiveGeometry(view, triangles, lines);
+}
+
+void V3dFile::appendAdaptiveGeometry(const TessellationView& view, MeshBuffer& triangles, MeshBuffer& lines) const {
+    size_t firstVertex = triangles.vertexCount();
+    size_t firstIndex = triangles.indices.size();
+
+    std::vector<BezierPatchDescriptor> patches(m_Surfaces.size());
+    for (size_t i = 0; i < patches.size(); ++i) {
+        patches[i] = m_Surfaces.descriptor(i);
+        patches[i].tolerance = viewTolerance(patches[i].controlPoints.data(), patches[i].triangle ? 10 : 16, view);
+    }
+
+    tessellateBezierPatches(patches, ThreadPool::shared(), triangles);
+
+    std::vector<TubeDescriptor> tubes = m_Tubes;
+    for (auto& tube : tubes) {
+        tube.tolerance = viewTolerance(tube.controlPoints.data(), tube.controlPoints.size(), view);
+    }
+
+    tessellateTubes(tubes, ThreadPool::shared(), triangles, lines);
+
+    // Patches and tubes only index their own vertices, so their part of the mesh is optimized on its own
+    if (m_Options.optimizeMeshes) {
+        optimizeMesh(triangles, firstVertex, firstIndex);
+    }
+
+    std::vector<BezierCurveDescriptor> curves;
+    curves.reserve(m_Curves.size());
+
+    for (auto& controlPoints : m_Curves) {
+        curves.push_back(BezierCurveDescriptor{ controlPoints, viewTolerance(controlPoints.data(), controlPoints.size(), view) });
+    }
+
+    flattenBezierCurves(curves, ThreadPool::shared(), lines);
+}
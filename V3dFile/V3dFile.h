@@ -1,14 +1,28 @@
 #pragma once
 
 #include "V3dObjects.h"
+#include "TubeTessellator.h"
+#include "BezierCurveTessellator.h"
+#include "SurfaceControlData.h"
 #include "V3dHeaderInfo.h"
 
 #include "xstream.h"
 
+struct V3dLoadOptions {
+    // Keep m_Objects after meshing. Without them a file only holds its buffers and what re-meshing needs.
+    bool keepObjects{ true };
+
+    // Reorder the triangles and vertices of the mesh for the vertex cache and overdraw, also after every re-mesh
+    bool optimizeMeshes{ false };
+};
+
 class V3dFile {
 public:
-    V3dFile(const std::string& fileName);
-    V3dFile(xdr::memixstream& xdrFile);
+    // Memory maps the file and decodes it in place
+    V3dFile(const std::string& fileName, const V3dLoadOptions& options = { });
+    // Decodes an XDR buffer owned by the caller, it only has to outlive the constructor
+    V3dFile(const unsigned char* data, size_t size, const V3dLoadOptions& options = { });
+    V3dFile(xdr::memixstream& xdrFile, const V3dLoadOptions& options = { });
 
     UINT versionNumber;
     V3D_BOOL doublePrecisionFlag;
@@ -16,13 +30,64 @@ public:
     std::vector<TRIPLE> centers;
     std::vector<V3dMaterial> materials;
 
+    // Empty once loaded unless V3dLoadOptions::keepObjects is set
     std::vector<std::unique_ptr<V3dObject>> m_Objects;
 
     V3dHeaderInfo headerInfo;
 
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
+    // Triangle list of interleaved positions and normals, its colors stay empty unless some surface has vertex colors.
+    // Every re-mesh swaps in a new buffer instead of modifying this one, so a worker can hold on to the mesh it reads.
+    std::shared_ptr<const MeshBuffer> mesh{ std::make_shared<const MeshBuffer>() };
+
+    // Line list with the same vertex layout as the mesh, holds line segments, curves and the cores of tubes
+    std::vector<float> lineVertices;
+    std::vector<unsigned int> lineIndices;
+
+    // Point list with the same vertex layout as the mesh, one point per pixel
+    std::vector<float> pointVertices;
+
+    // Spheres, hemispheres, disks and cylinders are drawn by instancing a shared unit mesh per kind
+    InstanceLists instances;
+
+    bool hasGeometry() const;
+
+    // View the Bezier surfaces, tubes and curves in the mesh and lines were meshed for
+    TessellationView tessellationView;
+
+    // View of the header's scene bounds on its canvas at the initial zoom
+    TessellationView defaultTessellationView() const;
+
+    // Whether part of the geometry is meshed for the view, and has to be rebuilt as it changes
+    bool hasAdaptiveGeometry() const { return !m_Surfaces.empty() || !m_Tubes.empty() || !m_Curves.empty(); }
+
+    // Builds the triangles and lines with the Bezier surfaces, tubes and curves meshed for view, without modifying the file.
+    // Safe on a background thread as long as mesh and the lines are not replaced in the meantime.
+    void buildMesh(const TessellationView& view, MeshBuffer& triangles, MeshBuffer& lines) const;
 
 private:
-    void load(xdr::ixstream& xdrFile);
+    // Sizes the meshes of objects in one pass and writes them in place on the thread pool in a second one
+    void assembleMesh(const std::vector<V3dObject*>& objects, MeshBuffer& triangles);
+
+    void releaseObjects();
+
+    void appendAdaptiveGeometry(const TessellationView& view, MeshBuffer& triangles, MeshBuffer& lines) const;
+
+    // Patches, Bezier triangles, tubes and curves are kept apart from the other objects so they can be re-meshed as
+    // the view changes. Their tolerances are filled in for the view being meshed.
+    SurfaceControlData m_Surfaces;
+    std::vector<TubeDescriptor> m_Tubes;
+    std::vector<std::array<TRIPLE, 4>> m_Curves;
+
+    // Leading part of the mesh and lines that holds every object meshed independently of the view
+    size_t m_StaticVertexCount{ 0 };
+    size_t m_StaticIndexCount{ 0 };
+    size_t m_StaticColorCount{ 0 };
+    size_t m_StaticLineVertexCount{ 0 };
+    size_t m_StaticLineIndexCount{ 0 };
+
+    V3dLoadOptions m_Options;
+
+    // Instantiated for xdr::ixstream and XdrReader
+    template<typename Reader>
+    void load(Reader& xdrFile);
 };
@@ -0,0 +1,25 @@
+#include "V3dInstances.h"
+
+#include <cmath>
+
+PrimitiveInstance makePrimitiveInstance(const TRIPLE& center, const TRIPLE& scale, REAL polarAngle, REAL azimuthalAngle, REAL radius, UINT materialIndex) {
+    float cp = std::cos(polarAngle);
+    float sp = std::sin(polarAngle);
+    float ca = std::cos(azimuthalAngle);
+    float sa = std::sin(azimuthalAngle);
+
+    // Columns of the rotation about y by the polar angle, followed by the one about z by the azimuthal angle
+    TRIPLE xAxis{ ca * cp, sa * cp, -sp };
+    TRIPLE yAxis{ -sa, ca, 0.0f };
+    TRIPLE zAxis{ ca * sp, sa * sp, cp };
+
+    PrimitiveInstance instance;
+    for (int row = 0; row < 3; ++row) {
+        instance.transform[row] = { xAxis[row] * scale.x, yAxis[row] * scale.y, zAxis[row] * scale.z, center[row] };
+    }
+
+    instance.radius = radius;
+    instance.materialIndex = materialIndex;
+
+    return instance;
+}
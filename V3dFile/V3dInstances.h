@@ -0,0 +1,28 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "V3dTypes.h"
+
+// Unit meshes that instanced primitives are drawn from
+enum InstanceTemplate : uint32_t {
+    SPHERE_TEMPLATE = 0,
+    HEMISPHERE_TEMPLATE = 1,
+    DISK_TEMPLATE = 2,
+    CYLINDER_TEMPLATE = 3,
+
+    INSTANCE_TEMPLATE_COUNT
+};
+
+// Placement of a shared unit mesh, laid out as the renderer's per instance vertex binding reads it
+struct PrimitiveInstance {
+    std::array<glm::vec4, 3> transform;     // Rows of the 3x4 matrix taking the unit mesh into model space
+    REAL radius;                            // Picks the level of detail
+    UINT materialIndex;
+};
+
+using InstanceLists = std::array<std::vector<PrimitiveInstance>, INSTANCE_TEMPLATE_COUNT>;
+
+// Scales the unit mesh by scale, turns its z axis towards the polar and azimuthal angle and moves it to center
+PrimitiveInstance makePrimitiveInstance(const TRIPLE& center, const TRIPLE& scale, REAL polarAngle, REAL azimuthalAngle, REAL radius, UINT materialIndex);
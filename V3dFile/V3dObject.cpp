@@ -1,4 +1,34 @@
 #include "V3dObject.h"
 
+#include <algorithm>
+
 V3dObject::V3dObject(UINT objectType) 
     : objectType{ objectType } { }
+
+size_t V3dObject::vertexCount() {
+    return getVertexData().size() / 6;
+}
+
+size_t V3dObject::indexCount() {
+    return getIndices().size();
+}
+
+bool V3dObject::hasColors() {
+    return !getColors().empty();
+}
+
+void V3dObject::writeVertices(float* out) {
+    std::vector<float> vertices = getVertexData();
+    std::copy(vertices.begin(), vertices.end(), out);
+}
+
+void V3dObject::writeIndices(unsigned int* out, unsigned int base) {
+    for (unsigned int index : getIndices()) {
+        *out++ = index + base;
+    }
+}
+
+void V3dObject::writeColors(uint32_t* out) {
+    std::vector<uint32_t> colors = getColors();
+    std::copy(colors.begin(), colors.end(), out);
+}
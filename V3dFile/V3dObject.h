@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
 
 #include "V3dTypes.h"
 
@@ -12,5 +13,22 @@ public:
     virtual std::vector<float> getVertexData() = 0;
     virtual std::vector<unsigned int> getIndices() = 0;
 
+    // Packed RGBA8 color per vertex of getVertexData, empty for objects without vertex colors
+    virtual std::vector<uint32_t> getColors() { return { }; }
+
+    // Two pass assembly, the counts size one shared mesh and each object then writes its part in place.
+    // The defaults go through the getters above, objects meshed on load override them to skip the copies.
+    virtual size_t vertexCount();
+    virtual size_t indexCount();
+    virtual bool hasColors();
+
+    // Six floats per vertex, indices offset by base and one color per vertex
+    virtual void writeVertices(float* out);
+    virtual void writeIndices(unsigned int* out, unsigned int base);
+    virtual void writeColors(uint32_t* out);
+
+    // Bytes held by the object, including what it allocated while parsing
+    virtual size_t memoryUsage() const { return sizeof(V3dObject); }
+
     UINT objectType;
 };
\ No newline at end of file
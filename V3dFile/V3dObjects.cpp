@@ -4,204 +4,153 @@
 
 #include "V3dUtil.h"
 
-#include "rgba.h"
-#include "bezierpatch.h"
-
-using namespace std;
-using namespace camp;
-
-namespace camp {
-    glm::dmat4 projViewMat;
-    glm::dmat4 normMat;
-}
-
+template<typename Reader>
 V3dBezierPatch::V3dBezierPatch(
-    xdr::ixstream& xdrFile, 
+    Reader& xdrFile, 
     V3D_BOOL doublePrecision)
     : V3dObject{ ObjectTypes::BEZIER_PATCH } { 
-        for (int i = 0; i < 16; ++i) {
-            controlPoints[i].x = readReal(xdrFile, doublePrecision);
-            controlPoints[i].y = readReal(xdrFile, doublePrecision);
-            controlPoints[i].z = readReal(xdrFile, doublePrecision);
-        }
+        readReals(xdrFile, &controlPoints[0].x, 3 * 16, doublePrecision);
 
         xdrFile >> centerIndex;
         xdrFile >> materialIndex;
+    }
 
-        int n=16;
-        triple Controls[] = {
-            triple(controlPoints[0].x, controlPoints[0].y, controlPoints[0].z),
-            triple(controlPoints[1].x, controlPoints[1].y, controlPoints[1].z),
-            triple(controlPoints[2].x, controlPoints[2].y, controlPoints[2].z),
-            triple(controlPoints[3].x, controlPoints[3].y, controlPoints[3].z),
-
-            triple(controlPoints[4].x, controlPoints[4].y, controlPoints[4].z),
-            triple(controlPoints[5].x, controlPoints[5].y, controlPoints[5].z),
-            triple(controlPoints[6].x, controlPoints[6].y, controlPoints[6].z),
-            triple(controlPoints[7].x, controlPoints[7].y, controlPoints[7].z),
-
-            triple(controlPoints[8].x, controlPoints[8].y, controlPoints[8].z),
-            triple(controlPoints[9].x, controlPoints[9].y, controlPoints[9].z),
-            triple(controlPoints[10].x, controlPoints[10].y, controlPoints[10].z),
-            triple(controlPoints[11].x, controlPoints[11].y, controlPoints[11].z),
-
-            triple(controlPoints[12].x, controlPoints[12].y, controlPoints[12].z),
-            triple(controlPoints[13].x, controlPoints[13].y, controlPoints[13].z),
-            triple(controlPoints[14].x, controlPoints[14].y, controlPoints[14].z),
-            triple(controlPoints[15].x, controlPoints[15].y, controlPoints[15].z),
-        };
-
-        BezierPatch S;
-
-        double width=1920;
-        double height=1080;
-
-        bool orthographic=false;
-        triple Min,Max;
-        boundstriples(Min,Max,n,Controls);
-
-        triple b=Min, B=Max; // cumulative scene bounds; for now use patch bounds
-        double Zmax=B.getz();
-
-        double perspective=orthographic ? 0.0 : 1.0/Zmax;
-        double s=perspective ? Min.getz()*perspective : 1.0; // Move to glrender
-        double size2=hypot(width,height);
-
-        const camp::pair size3(s*(B.getx()-b.getx()),s*(B.gety()-b.gety()));
-        bool transparent=false;
-        bool straight=false;
-        bool remesh=true;
-
-        S.queue(Controls,straight,size3.length()/size2,transparent,NULL);
-
-        unsigned int i = 0;
-        for (auto& materialVertex : materialData.materialVertices) {
-            m_Vertices.push_back(materialVertex.position.x);
-            m_Vertices.push_back(materialVertex.position.y);
-            m_Vertices.push_back(materialVertex.position.z);
-
-            m_Vertices.push_back(materialVertex.normal.x);
-            m_Vertices.push_back(materialVertex.normal.y);
-            m_Vertices.push_back(materialVertex.normal.z);
-        }
+BezierPatchDescriptor V3dBezierPatch::descriptor(const TessellationView& view) const {
+    return BezierPatchDescriptor{ controlPoints, bezierPatchTolerance(controlPoints, view) };
+}
+
+MeshBuffer V3dBezierPatch::tessellate(const TessellationView& view) const {
+    MeshBuffer mesh;
+    tessellateBezierPatch(descriptor(view), mesh);
+    return mesh;
+}
 
-        m_Indices = materialData.indices;
+// Without a scene the surface is meshed as if it filled a 1920x1080 perspective view
+template<size_t N>
+static TessellationView standaloneView(const std::array<TRIPLE, N>& controlPoints) {
+    TRIPLE Min = controlPoints[0];
+    TRIPLE Max = controlPoints[0];
+    for (auto& point : controlPoints) {
+        Min = glm::min(Min, point);
+        Max = glm::max(Max, point);
     }
 
+    return tessellationViewForBounds(Min, Max, 1920.0f, 1080.0f, false);
+}
+
+static MeshBuffer tessellateStandalone(const BezierPatchDescriptor& descriptor) {
+    MeshBuffer mesh;
+    tessellateBezierPatch(descriptor, mesh);
+    return mesh;
+}
+
+static BezierPatchDescriptor triangleDescriptor(const std::array<TRIPLE, 10>& controlPoints, const TessellationView& view) {
+    BezierPatchDescriptor descriptor{ };
+    std::copy(controlPoints.begin(), controlPoints.end(), descriptor.controlPoints.begin());
+    descriptor.tolerance = viewTolerance(controlPoints.data(), controlPoints.size(), view);
+    descriptor.triangle = true;
+
+    return descriptor;
+}
+
 std::vector<float> V3dBezierPatch::getVertexData() {
-    return m_Vertices;
+    return tessellate(standaloneView(controlPoints)).vertices;
 }
 
 std::vector<unsigned int> V3dBezierPatch::getIndices() {
-    return m_Indices;
+    return tessellate(standaloneView(controlPoints)).indices;
 }
 
+template<typename Reader>
 V3dBezierTriangle::V3dBezierTriangle(
-    xdr::ixstream& xdrFile, 
+    Reader& xdrFile, 
     V3D_BOOL doublePrecision)
     : V3dObject{ ObjectTypes::BEZIER_TRIANGLE } { 
-        for (int i = 0; i < 10; ++i) {
-            controlPoints[i].x = readReal(xdrFile, doublePrecision);
-            controlPoints[i].y = readReal(xdrFile, doublePrecision);
-            controlPoints[i].z = readReal(xdrFile, doublePrecision);
-        }
+        readReals(xdrFile, &controlPoints[0].x, 3 * 10, doublePrecision);
 
         xdrFile >> centerIndex;
         xdrFile >> materialIndex;
     }
 
+BezierPatchDescriptor V3dBezierTriangle::descriptor(const TessellationView& view) const {
+    return triangleDescriptor(controlPoints, view);
+}
+
 std::vector<float> V3dBezierTriangle::getVertexData() {
-    std::cout << "ERROR: V3dBezierTriangle cannot currently give vertices" << std::endl;
-    return std::vector<float>{};
+    return tessellateStandalone(descriptor(standaloneView(controlPoints))).vertices;
 }
 
 std::vector<unsigned int> V3dBezierTriangle::getIndices() {
-    std::cout << "ERROR: V3dBezierTriangle cannot currently give indices" << std::endl;
-    return std::vector<unsigned int>{};
+    return tessellateStandalone(descriptor(standaloneView(controlPoints))).indices;
 }
 
 
+template<typename Reader>
 V3dBezierPatchWithCornerColors::V3dBezierPatchWithCornerColors(
-    xdr::ixstream& xdrFile, 
+    Reader& xdrFile, 
     V3D_BOOL doublePrecision)
     : V3dObject{ ObjectTypes::BEZIER_PATCH_COLOR } {
-        for (int i = 0; i < 16; ++i) {
-            controlPoints[i].x = readReal(xdrFile, doublePrecision);
-            controlPoints[i].y = readReal(xdrFile, doublePrecision);
-            controlPoints[i].z = readReal(xdrFile, doublePrecision);
-        }
+        readReals(xdrFile, &controlPoints[0].x, 3 * 16, doublePrecision);
 
         xdrFile >> centerIndex;
         xdrFile >> materialIndex;    
 
-        for (int i = 0; i < 4; ++i) {
-            xdrFile >> cornerColors[i].r;
-            xdrFile >> cornerColors[i].g;
-            xdrFile >> cornerColors[i].b;
-            xdrFile >> cornerColors[i].a;
-        }
+        readFloats(xdrFile, &cornerColors[0].r, 4 * 4);
     }
 
+BezierPatchDescriptor V3dBezierPatchWithCornerColors::descriptor(const TessellationView& view) const {
+    BezierPatchDescriptor descriptor{ controlPoints, bezierPatchTolerance(controlPoints, view) };
+    descriptor.colored = true;
+    descriptor.cornerColors = cornerColors;
+
+    return descriptor;
+}
+
 std::vector<float> V3dBezierPatchWithCornerColors::getVertexData() {
-    std::cout << "ERROR: V3dBezierPatchWithCornerColors cannot currently give vertices" << std::endl;
-    return std::vector<float>{};
+    return tessellateStandalone(descriptor(standaloneView(controlPoints))).vertices;
 }
 
 std::vector<unsigned int> V3dBezierPatchWithCornerColors::getIndices() {
-    std::cout << "ERROR: V3dBezierPatchWithCornerColors cannot currently give indices" << std::endl;
-    return std::vector<unsigned int>{};
+    return tessellateStandalone(descriptor(standaloneView(controlPoints))).indices;
 }
 
 
+template<typename Reader>
 V3dBezierTriangleWithCornerColors::V3dBezierTriangleWithCornerColors(
-    xdr::ixstream& xdrFile, 
+    Reader& xdrFile, 
     V3D_BOOL doublePrecision)
     : V3dObject{ ObjectTypes::BEZIER_TRIANGLE_COLOR } { 
-        for (int i = 0; i < 10; ++i) {
-            controlPoints[i].x = readReal(xdrFile, doublePrecision);
-            controlPoints[i].y = readReal(xdrFile, doublePrecision);
-            controlPoints[i].z = readReal(xdrFile, doublePrecision);
-        }
+        readReals(xdrFile, &controlPoints[0].x, 3 * 10, doublePrecision);
 
         xdrFile >> centerIndex;
         xdrFile >> materialIndex;    
 
-        for (int i = 0; i < 3; ++i) {
-            xdrFile >> cornerColors[i].r;
-            xdrFile >> cornerColors[i].g;
-            xdrFile >> cornerColors[i].b;
-            xdrFile >> cornerColors[i].a;
-        }    
+        readFloats(xdrFile, &cornerColors[0].r, 4 * 3);
     }
 
+BezierPatchDescriptor V3dBezierTriangleWithCornerColors::descriptor(const TessellationView& view) const {
+    BezierPatchDescriptor descriptor = triangleDescriptor(controlPoints, view);
+    descriptor.colored = true;
+    std::copy(cornerColors.begin(), cornerColors.end(), descriptor.cornerColors.begin());
+
+    return descriptor;
+}
+
 std::vector<float> V3dBezierTriangleWithCornerColors::getVertexData() {
-    std::cout << "ERROR: V3dBezierTriangleWithCornerColors cannot currently give vertices" << std::endl;
-    return std::vector<float>{};
+    return tessellateStandalone(descriptor(standaloneView(controlPoints))).vertices;
 }
 
 std::vector<unsigned int> V3dBezierTriangleWithCornerColors::getIndices() {
-    std::cout << "ERROR: V3dBezierTriangleWithCornerColors cannot currently give indices" << std::endl;
-    return std::vector<unsigned int>{};
+    return tessellateStandalone(descriptor(standaloneView(controlPoints))).indices;
 }
 
 
-V3dStraightPlanarQuad::V3dStraightPlanarQuad(
-    xdr::ixstream& xdrFile, 
-    V3D_BOOL doublePrecision)
-    : V3dObject{ ObjectTypes::QUAD } {
-        for (int i = 0; i < 4; ++i) {
-            vertices[i].x = readReal(xdrFile, doublePrecision);
-            vertices[i].y = readReal(xdrFile, doublePrecision);
-            vertices[i].z = readReal(xdrFile, doublePrecision);
-        }
-
-        xdrFile >> centerIndex;
-        xdrFile >> materialIndex; 
-    }
-
-std::vector<float> V3dStraightPlanarQuad::getVertexData() {
-    std::vector<float> out{};
+static constexpr std::array<unsigned int, 6> QUAD_INDICES{ 0, 1, 2, 0, 2, 3 };
+static constexpr std::array<unsigned int, 3> TRIANGLE_INDICES{ 0, 1, 2 };
 
+// Corners of a flat polygon, all sharing the normal of the plane through the first three
+template<size_t Count>
+static void writeFlatVertices(const std::array<TRIPLE, Count>& vertices, float* out) {
     TRIPLE p1 = vertices[0];
     TRIPLE p2 = vertices[1];
     TRIPLE p3 = vertices[2];
@@ -212,142 +161,222 @@ std::vector<float> V3dStraightPlanarQuad::getVertexData() {
     TRIPLE N = glm::cross(A, B);
 
     for (auto& ver : vertices) {
-        out.push_back(ver.x);
-        out.push_back(ver.y);
-        out.push_back(ver.z);
+        *out++ = ver.x;
+        *out++ = ver.y;
+        *out++ = ver.z;
 
-        out.push_back(N.x);
-        out.push_back(N.y);
-        out.push_back(N.z);
+        *out++ = N.x;
+        *out++ = N.y;
+        *out++ = N.z;
     }
+}
+
+template<size_t Count>
+static std::vector<float> flatVertexData(const std::array<TRIPLE, Count>& vertices) {
+    std::vector<float> out(6 * Count);
+    writeFlatVertices(vertices, out.data());
 
     return out;
 }
 
-std::vector<unsigned int> V3dStraightPlanarQuad::getIndices() {
-    std::vector<unsigned int> out {
-        0, 1, 2,
-        0, 2, 3
-    };
+template<size_t Count>
+static void writeIndexTable(const std::array<unsigned int, Count>& table, unsigned int* out, unsigned int base) {
+    for (unsigned int index : table) {
+        *out++ = index + base;
+    }
+}
+
+template<size_t Count>
+static void writePackedColors(const std::array<RGBA, Count>& colors, uint32_t* out) {
+    for (auto& color : colors) {
+        *out++ = packColor(color);
+    }
+}
+
+template<size_t Count>
+static std::vector<uint32_t> packColors(const std::array<RGBA, Count>& colors) {
+    std::vector<uint32_t> out(Count);
+    writePackedColors(colors, out.data());
 
     return out;
 }
 
 
-V3dStraightTriangle::V3dStraightTriangle(
-    xdr::ixstream& xdrFile, 
+template<typename Reader>
+V3dStraightPlanarQuad::V3dStraightPlanarQuad(
+    Reader& xdrFile, 
     V3D_BOOL doublePrecision)
-    : V3dObject{ ObjectTypes::TRIANGLE } { 
-        for (int i = 0; i < 3; ++i) {
-            vertices[i].x = readReal(xdrFile, doublePrecision);
-            vertices[i].y = readReal(xdrFile, doublePrecision);
-            vertices[i].z = readReal(xdrFile, doublePrecision);
-        }
+    : V3dObject{ ObjectTypes::QUAD } {
+        readReals(xdrFile, &vertices[0].x, 3 * 4, doublePrecision);
 
         xdrFile >> centerIndex;
-        xdrFile >> materialIndex;
+        xdrFile >> materialIndex; 
     }
 
-std::vector<float> V3dStraightTriangle::getVertexData() {
-    std::vector<float> out{};
+std::vector<float> V3dStraightPlanarQuad::getVertexData() {
+    return flatVertexData(vertices);
+}
 
-    TRIPLE p1 = vertices[0];
-    TRIPLE p2 = vertices[1];
-    TRIPLE p3 = vertices[2];
+std::vector<unsigned int> V3dStraightPlanarQuad::getIndices() {
+    return std::vector<unsigned int>(QUAD_INDICES.begin(), QUAD_INDICES.end());
+}
 
-    TRIPLE A = p2 - p1;
-    TRIPLE B = p3 - p1;
+size_t V3dStraightPlanarQuad::vertexCount() {
+    return 4;
+}
 
-    TRIPLE N = glm::cross(A, B);
+size_t V3dStraightPlanarQuad::indexCount() {
+    return QUAD_INDICES.size();
+}
 
-    for (auto& ver : vertices) {
-        out.push_back(ver.x);
-        out.push_back(ver.y);
-        out.push_back(ver.z);
+void V3dStraightPlanarQuad::writeVertices(float* out) {
+    writeFlatVertices(vertices, out);
+}
+
+void V3dStraightPlanarQuad::writeIndices(unsigned int* out, unsigned int base) {
+    writeIndexTable(QUAD_INDICES, out, base);
+}
 
-        out.push_back(N.x);
-        out.push_back(N.y);
-        out.push_back(N.z);
+
+template<typename Reader>
+V3dStraightTriangle::V3dStraightTriangle(
+    Reader& xdrFile, 
+    V3D_BOOL doublePrecision)
+    : V3dObject{ ObjectTypes::TRIANGLE } { 
+        readReals(xdrFile, &vertices[0].x, 3 * 3, doublePrecision);
+
+        xdrFile >> centerIndex;
+        xdrFile >> materialIndex;
     }
 
-    return out;
+std::vector<float> V3dStraightTriangle::getVertexData() {
+    return flatVertexData(vertices);
 }
 
 std::vector<unsigned int> V3dStraightTriangle::getIndices() {
-    std::vector<unsigned int> out {
-        0, 1, 2
-    };
+    return std::vector<unsigned int>(TRIANGLE_INDICES.begin(), TRIANGLE_INDICES.end());
+}
 
-    return out;
+size_t V3dStraightTriangle::vertexCount() {
+    return 3;
+}
+
+size_t V3dStraightTriangle::indexCount() {
+    return TRIANGLE_INDICES.size();
+}
+
+void V3dStraightTriangle::writeVertices(float* out) {
+    writeFlatVertices(vertices, out);
+}
+
+void V3dStraightTriangle::writeIndices(unsigned int* out, unsigned int base) {
+    writeIndexTable(TRIANGLE_INDICES, out, base);
 }
 
 
+template<typename Reader>
 V3dStraightPlanarQuadWithCornerColors::V3dStraightPlanarQuadWithCornerColors(
-    xdr::ixstream& xdrFile, 
+    Reader& xdrFile, 
     V3D_BOOL doublePrecision)
     : V3dObject{ ObjectTypes::QUAD_COLOR } { 
-        for (int i = 0; i < 4; ++i) {
-            vertices[i].x = readReal(xdrFile, doublePrecision);
-            vertices[i].y = readReal(xdrFile, doublePrecision);
-            vertices[i].z = readReal(xdrFile, doublePrecision);
-        }
+        readReals(xdrFile, &vertices[0].x, 3 * 4, doublePrecision);
 
         xdrFile >> centerIndex;
         xdrFile >> materialIndex;     
 
-        for (int i = 0; i < 4; ++i) {
-            xdrFile >> cornerColors[i].r;
-            xdrFile >> cornerColors[i].g;
-            xdrFile >> cornerColors[i].b;
-            xdrFile >> cornerColors[i].a;
-        }
+        readFloats(xdrFile, &cornerColors[0].r, 4 * 4);
     }
 
 std::vector<float> V3dStraightPlanarQuadWithCornerColors::getVertexData() {
-    std::cout << "ERROR: V3dStraightPlanarQuadWithCornerColors cannot currently give vertices" << std::endl;
-    return std::vector<float>{};
+    return flatVertexData(vertices);
 }
 
 std::vector<unsigned int> V3dStraightPlanarQuadWithCornerColors::getIndices() {
-    std::cout << "ERROR: V3dStraightPlanarQuadWithCornerColors cannot currently give indices" << std::endl;
-    return std::vector<unsigned int>{};
+    return std::vector<unsigned int>(QUAD_INDICES.begin(), QUAD_INDICES.end());
+}
+
+size_t V3dStraightPlanarQuadWithCornerColors::vertexCount() {
+    return 4;
+}
+
+size_t V3dStraightPlanarQuadWithCornerColors::indexCount() {
+    return QUAD_INDICES.size();
+}
+
+void V3dStraightPlanarQuadWithCornerColors::writeVertices(float* out) {
+    writeFlatVertices(vertices, out);
+}
+
+void V3dStraightPlanarQuadWithCornerColors::writeIndices(unsigned int* out, unsigned int base) {
+    writeIndexTable(QUAD_INDICES, out, base);
+}
+
+std::vector<uint32_t> V3dStraightPlanarQuadWithCornerColors::getColors() {
+    return packColors(cornerColors);
+}
+
+bool V3dStraightPlanarQuadWithCornerColors::hasColors() {
+    return true;
+}
+
+void V3dStraightPlanarQuadWithCornerColors::writeColors(uint32_t* out) {
+    writePackedColors(cornerColors, out);
 }
 
 
+template<typename Reader>
 V3dStraightTriangleWithCornerColors::V3dStraightTriangleWithCornerColors(
-    xdr::ixstream& xdrFile, 
+    Reader& xdrFile, 
     V3D_BOOL doublePrecision)
     : V3dObject{ ObjectTypes::TRIANGLE_COLOR } { 
-        for (int i = 0; i < 3; ++i) {
-            vertices[i].x = readReal(xdrFile, doublePrecision);
-            vertices[i].y = readReal(xdrFile, doublePrecision);
-            vertices[i].z = readReal(xdrFile, doublePrecision);
-        }
+        readReals(xdrFile, &vertices[0].x, 3 * 3, doublePrecision);
 
         xdrFile >> centerIndex;
         xdrFile >> materialIndex;     
 
-        for (int i = 0; i < 3; ++i) {
-            xdrFile >> cornerColors[i].r;
-            xdrFile >> cornerColors[i].g;
-            xdrFile >> cornerColors[i].b;
-            xdrFile >> cornerColors[i].a;
-        }
+        readFloats(xdrFile, &cornerColors[0].r, 4 * 3);
     }
 
 std::vector<float> V3dStraightTriangleWithCornerColors::getVertexData() {
-    std::cout << "ERROR: V3dStraightTriangleWithCornerColors cannot currently give vertices" << std::endl;
-    return std::vector<float>{};
+    return flatVertexData(vertices);
 }
 
 std::vector<unsigned int> V3dStraightTriangleWithCornerColors::getIndices() {
-    std::cout << "ERROR: V3dStraightTriangleWithCornerColors cannot currently give indices" << std::endl;
-    return std::vector<unsigned int>{};
+    return std::vector<unsigned int>(TRIANGLE_INDICES.begin(), TRIANGLE_INDICES.end());
+}
+
+size_t V3dStraightTriangleWithCornerColors::vertexCount() {
+    return 3;
+}
+
+size_t V3dStraightTriangleWithCornerColors::indexCount() {
+    return TRIANGLE_INDICES.size();
+}
+
+void V3dStraightTriangleWithCornerColors::writeVertices(float* out) {
+    writeFlatVertices(vertices, out);
+}
+
+void V3dStraightTriangleWithCornerColors::writeIndices(unsigned int* out, unsigned int base) {
+    writeIndexTable(TRIANGLE_INDICES, out, base);
 }
 
+std::vector<uint32_t> V3dStraightTriangleWithCornerColors::getColors() {
+    return packColors(cornerColors);
+}
+
+bool V3dStraightTriangleWithCornerColors::hasColors() {
+    return true;
+}
 
+void V3dStraightTriangleWithCornerColors::writeColors(uint32_t* out) {
+    writePackedColors(cornerColors, out);
+}
+
+
+template<typename Reader>
 V3dTriangleGroup::V3dTriangleGroup(
-    xdr::ixstream& xdrFile, 
+    Reader& xdrFile, 
     V3D_BOOL doublePrecision)
     : V3dObject{ ObjectTypes::TRIANGLES } { 
         nI = 0;
@@ -356,19 +385,15 @@ V3dTriangleGroup::V3dTriangleGroup(
         nP = 0;
         xdrFile >> nP;
         vertexPositions.resize(nP);
-        for (UINT i = 0; i < nP; ++i) {
-            vertexPositions[i].x = readReal(xdrFile, doublePrecision);
-            vertexPositions[i].y = readReal(xdrFile, doublePrecision);
-            vertexPositions[i].z = readReal(xdrFile, doublePrecision);
+        if (nP > 0) {
+            readReals(xdrFile, &vertexPositions[0].x, 3 * size_t(nP), doublePrecision);
         }
 
         nN = 0;
         xdrFile >> nN;
         vertexNormalArray.resize(nN);
-        for (UINT i = 0; i < nN; ++i) {
-            vertexNormalArray[i].x = readReal(xdrFile, doublePrecision);
-            vertexNormalArray[i].y = readReal(xdrFile, doublePrecision);
-            vertexNormalArray[i].z = readReal(xdrFile, doublePrecision);
+        if (nN > 0) {
+            readReals(xdrFile, &vertexNormalArray[0].x, 3 * size_t(nN), doublePrecision);
         }
 
         xdrFile >> explicitNI;
@@ -376,12 +401,7 @@ V3dTriangleGroup::V3dTriangleGroup(
         xdrFile >> nC;
         if (nC > 0) {
             vertexColorArray.resize(nC);
-            for (UINT i = 0; i < nC; ++i) {
-                xdrFile >> vertexColorArray[i].r;
-                xdrFile >> vertexColorArray[i].g;
-                xdrFile >> vertexColorArray[i].b;
-                xdrFile >> vertexColorArray[i].a;
-            }
+            readFloats(xdrFile, &vertexColorArray[0].r, 4 * size_t(nC));
 
             xdrFile >> explicitCI;
         }
@@ -390,23 +410,26 @@ V3dTriangleGroup::V3dTriangleGroup(
         normalIndices.resize(nI);
         colorIndices.resize(nI);
 
+        // Without explicit normal or color indices the position triples are stored back to back
+        bool packedIndices = !explicitNI && !(nC > 0 && explicitCI);
+
+        if (packedIndices && nI > 0) {
+            readUInts(xdrFile, positionIndices[0].data(), 3 * size_t(nI));
+        }
+
         for (UINT i = 0; i < nI; ++i) {
-            xdrFile >> positionIndices[i][0];
-            xdrFile >> positionIndices[i][1];
-            xdrFile >> positionIndices[i][2];
+            if (!packedIndices) {
+                readUInts(xdrFile, positionIndices[i].data(), 3);
+            }
 
             if (explicitNI) {
-                xdrFile >> normalIndices[i][0];
-                xdrFile >> normalIndices[i][1];
-                xdrFile >> normalIndices[i][2];
+                readUInts(xdrFile, normalIndices[i].data(), 3);
             } else {
                 normalIndices[i] = positionIndices[i];
             }
 
             if (nC > 0 && explicitCI) {
-                xdrFile >> colorIndices[i][0];
-                xdrFile >> colorIndices[i][1];
-                xdrFile >> colorIndices[i][2];
+                readUInts(xdrFile, colorIndices[i].data(), 3);
             } else {
                 colorIndices[i] = positionIndices[i];
             }
@@ -416,75 +439,119 @@ V3dTriangleGroup::V3dTriangleGroup(
         xdrFile >> materialIndex;
     }
 
-std::vector<float> V3dTriangleGroup::getVertexData() {
-    std::vector<float> out;
-
-    std::vector<TRIPLE> vertices;
-    vertices.resize(nP);
-
-    for(size_t i = 0; i < nI; ++i) {
-        std::array<unsigned int, 3> PI = positionIndices[i];
-        uint32_t PI0 = PI[0];
-        uint32_t PI1 = PI[1];
-        uint32_t PI2 = PI[2];
-        TRIPLE P0 = vertexPositions[PI0];
-        TRIPLE P1 = vertexPositions[PI1];
-        TRIPLE P2 = vertexPositions[PI2];
-
-        vertices[PI0] = P0;
-        vertices[PI1] = P1;
-        vertices[PI2] = P2;
+const WeldedTriangles& V3dTriangleGroup::welded() {
+    if (m_Welded) {
+        return *m_Welded;
     }
 
-    for (size_t i = 0; i < vertices.size(); ++i) {
-        out.push_back(vertices[i].x);
-        out.push_back(vertices[i].y);
-        out.push_back(vertices[i].z);
+    m_Welded = weldTriangles(positionIndices, normalIndices, colorIndices, nC > 0);
 
-        out.push_back(vertexNormalArray[i].x);
-        out.push_back(vertexNormalArray[i].y);
-        out.push_back(vertexNormalArray[i].z);
+    for (auto& key : m_Welded->vertices) {
+        if (key[0] >= nP || key[1] >= nN || (nC > 0 && key[2] >= nC)) {
+            std::cout << "ERROR: V3dTriangleGroup has an index out of range, it wont be rendered" << std::endl;
+            *m_Welded = WeldedTriangles{ };
+            break;
+        }
     }
 
+    return *m_Welded;
+}
+
+std::vector<float> V3dTriangleGroup::getVertexData() {
+    std::vector<float> out(6 * vertexCount());
+    writeVertices(out.data());
+
     return out;
 }
 
 std::vector<unsigned int> V3dTriangleGroup::getIndices() {
-    std::vector<unsigned int> out;
+    return welded().indices;
+}
+
+std::vector<uint32_t> V3dTriangleGroup::getColors() {
+    if (!hasColors()) {
+        return { };
+    }
+
+    std::vector<uint32_t> out(vertexCount());
+    writeColors(out.data());
+
+    return out;
+}
+
+size_t V3dTriangleGroup::vertexCount() {
+    return welded().vertices.size();
+}
+
+size_t V3dTriangleGroup::indexCount() {
+    return welded().indices.size();
+}
+
+bool V3dTriangleGroup::hasColors() {
+    return nC > 0;
+}
 
-    out.resize(nI * 3);
+void V3dTriangleGroup::writeVertices(float* out) {
+    for (auto& key : welded().vertices) {
+        const TRIPLE& position = vertexPositions[key[0]];
+        const TRIPLE& normal = vertexNormalArray[key[1]];
 
-    for(size_t i = 0; i < nI; ++i) {
-        std::array<unsigned int, 3> PI = positionIndices[i];
+        *out++ = position.x;
+        *out++ = position.y;
+        *out++ = position.z;
 
-        uint32_t PI0 = PI[0];
-        uint32_t PI1 = PI[1];
-        uint32_t PI2 = PI[2];
+        *out++ = normal.x;
+        *out++ = normal.y;
+        *out++ = normal.z;
+    }
+}
 
-        size_t i3=3*i;
-        out[i3 + 0] = PI0;
-        out[i3 + 1] = PI1;
-        out[i3 + 2] = PI2;
+void V3dTriangleGroup::writeIndices(unsigned int* out, unsigned int base) {
+    for (unsigned int index : welded().indices) {
+        *out++ = index + base;
     }
+}
 
-    return out;
+void V3dTriangleGroup::writeColors(uint32_t* out) {
+    for (auto& key : welded().vertices) {
+        *out++ = packColor(vertexColorArray[key[2]]);
+    }
 }
 
+size_t V3dTriangleGroup::memoryUsage() const {
+    size_t bytes = sizeof(*this)
+        + vertexPositions.capacity() * sizeof(TRIPLE)
+        + vertexNormalArray.capacity() * sizeof(TRIPLE)
+        + vertexColorArray.capacity() * sizeof(RGBA)
+        + (positionIndices.capacity() + normalIndices.capacity() + colorIndices.capacity()) * sizeof(std::array<UINT, 3>);
 
+    if (m_Welded) {
+        bytes += m_Welded->vertices.capacity() * sizeof(VertexKey) + m_Welded->indices.capacity() * sizeof(unsigned int);
+    }
+
+    return bytes;
+}
+
+
+template<typename Reader>
 V3dSphere::V3dSphere(
-    xdr::ixstream& xdrFile, 
+    Reader& xdrFile, 
     V3D_BOOL doublePrecision)
     : V3dObject{ ObjectTypes::SPHERE } { 
         center.x = readReal(xdrFile, doublePrecision);
         center.y = readReal(xdrFile, doublePrecision);
         center.z = readReal(xdrFile, doublePrecision);
 
-        xdrFile >> radius;
+        radius = readReal(xdrFile, doublePrecision);
 
         xdrFile >> centerIndex;
         xdrFile >> materialIndex;
     }
 
+PrimitiveInstance V3dSphere::instance() const {
+    return makePrimitiveInstance(center, TRIPLE{ radius, radius, radius }, 0.0f, 0.0f, radius, materialIndex);
+}
+
 std::vector<float> V3dSphere::getVertexData() {
     std::cout << "ERROR: V3dSphere cannot currently give vertices" << std::endl;
     return std::vector<float>{};
@@ -496,8 +563,9 @@ std::vector<unsigned int> V3dSphere::getIndices() {
 }
 
 
+template<typename Reader>
 V3dHemiSphere::V3dHemiSphere(
-    xdr::ixstream& xdrFile, 
+    Reader& xdrFile, 
     V3D_BOOL doublePrecision)
     : V3dObject{ ObjectTypes::HALF_SPHERE } { 
         center.x = readReal(xdrFile, doublePrecision);
@@ -514,6 +582,10 @@ V3dHemiSphere::V3dHemiSphere(
 
     }
 
+PrimitiveInstance V3dHemiSphere::instance() const {
+    return makePrimitiveInstance(center, TRIPLE{ radius, radius, radius }, polarAngle, azimuthalAngle, radius, materialIndex);
+}
+
 std::vector<float> V3dHemiSphere::getVertexData() {
     std::cout << "ERROR: V3dHemiSphere cannot currently give vertices" << std::endl;
     return std::vector<float>{};
@@ -525,8 +597,9 @@ std::vector<unsigned int> V3dHemiSphere::getIndices() {
 }
 
 
+template<typename Reader>
 V3dDisk::V3dDisk(
-    xdr::ixstream& xdrFile, 
+    Reader& xdrFile, 
     V3D_BOOL doublePrecision)
     : V3dObject{ ObjectTypes::DISK } { 
         center.x = readReal(xdrFile, doublePrecision);
@@ -542,6 +615,10 @@ V3dDisk::V3dDisk(
         azimuthalAngle = readReal(xdrFile, doublePrecision);
     }
 
+PrimitiveInstance V3dDisk::instance() const {
+    return makePrimitiveInstance(center, TRIPLE{ radius, radius, radius }, polarAngle, azimuthalAngle, radius, materialIndex);
+}
+
 std::vector<float> V3dDisk::getVertexData() {
     std::cout << "ERROR: V3dDisk cannot currently give vertices" << std::endl;
     return std::vector<float>{};
@@ -553,8 +630,9 @@ std::vector<unsigned int> V3dDisk::getIndices() {
 }
 
 
+template<typename Reader>
 V3dCylinder::V3dCylinder(
-    xdr::ixstream& xdrFile, 
+    Reader& xdrFile, 
     V3D_BOOL doublePrecision)
     : V3dObject{ ObjectTypes::CYLINDER } { 
         center.x = readReal(xdrFile, doublePrecision);
@@ -572,6 +650,10 @@ V3dCylinder::V3dCylinder(
         azimuthalAngle = readReal(xdrFile, doublePrecision);
     }
 
+PrimitiveInstance V3dCylinder::instance() const {
+    return makePrimitiveInstance(center, TRIPLE{ radius, radius, height }, polarAngle, azimuthalAngle, radius, materialIndex);
+}
+
 std::vector<float> V3dCylinder::getVertexData() {
     std::cout << "ERROR: V3dCylinder cannot currently give vertices" << std::endl;
     return std::vector<float>{};
@@ -583,15 +665,12 @@ std::vector<unsigned int> V3dCylinder::getIndices() {
 }
 
 
+template<typename Reader>
 V3dTube::V3dTube(
-    xdr::ixstream& xdrFile, 
+    Reader& xdrFile, 
     V3D_BOOL doublePrecision)
     : V3dObject{ ObjectTypes::TUBE } { 
-        for (UINT i = 0; i < 4; ++i) {
-            controlPoints[i].x = readReal(xdrFile, doublePrecision);
-            controlPoints[i].y = readReal(xdrFile, doublePrecision);
-            controlPoints[i].z = readReal(xdrFile, doublePrecision);
-        }
+        readReals(xdrFile, &controlPoints[0].x, 3 * 4, doublePrecision);
 
         width = readReal(xdrFile, doublePrecision);
 
@@ -611,15 +690,12 @@ std::vector<unsigned int> V3dTube::getIndices() {
 }
 
 
+template<typename Reader>
 V3dBezierCurve::V3dBezierCurve(
-    xdr::ixstream& xdrFile, 
+    Reader& xdrFile, 
     V3D_BOOL doublePrecision)
     : V3dObject{ ObjectTypes::CURVE } { 
-        for (UINT i = 0; i < 4; ++i) {
-            controlPoints[i].x = readReal(xdrFile, doublePrecision);
-            controlPoints[i].y = readReal(xdrFile, doublePrecision);
-            controlPoints[i].z = readReal(xdrFile, doublePrecision);
-        }    
+        readReals(xdrFile, &controlPoints[0].x, 3 * 4, doublePrecision);
 
         xdrFile >> centerIndex;
         xdrFile >> materialIndex;
@@ -636,15 +712,12 @@ std::vector<unsigned int> V3dBezierCurve::getIndices() {
 }
 
 
+template<typename Reader>
 V3dLineSegment::V3dLineSegment(
-    xdr::ixstream& xdrFile, 
+    Reader& xdrFile, 
     V3D_BOOL doublePrecision)
     : V3dObject{ ObjectTypes::LINE } { 
-        for (UINT i = 0; i < 2; ++i) {
-            endpoints[i].x = readReal(xdrFile, doublePrecision);
-            endpoints[i].y = readReal(xdrFile, doublePrecision);
-            endpoints[i].z = readReal(xdrFile, doublePrecision);
-        }    
+        readReals(xdrFile, &endpoints[0].x, 3 * 2, doublePrecision);
 
         xdrFile >> centerIndex;
         xdrFile >> materialIndex;    
@@ -661,8 +734,9 @@ std::vector<unsigned int> V3dLineSegment::getIndices() {
 }
 
 
+template<typename Reader>
 V3dPixel::V3dPixel(
-    xdr::ixstream& xdrFile, 
+    Reader& xdrFile, 
     V3D_BOOL doublePrecision)
     : V3dObject{ ObjectTypes::PIXEL } { 
         position.x = readReal(xdrFile, doublePrecision);
@@ -682,3 +756,31 @@ std::vector<unsigned int> V3dPixel::getIndices() {
     std::cout << "ERROR: V3dPixel cannot currently give indices" << std::endl;
     return std::vector<unsigned int>{};
 }
+
+
+static_assert(sizeof(TRIPLE) == 3 * sizeof(float), "bulk reads expect tightly packed TRIPLEs");
+static_assert(sizeof(RGBA) == 4 * sizeof(float), "bulk reads expect tightly packed RGBAs");
+static_assert(sizeof(std::array<UINT, 3>) == 3 * sizeof(UINT), "bulk reads expect tightly packed index triples");
+
+// The parsers are shared by the stream and memory mapped loading paths
+#define INSTANTIATE_V3D_OBJECT_READERS(Reader) \
+    template V3dBezierPatch::V3dBezierPatch(Reader&, V3D_BOOL); \
+    template V3dBezierTriangle::V3dBezierTriangle(Reader&, V3D_BOOL); \
+    template V3dBezierPatchWithCornerColors::V3dBezierPatchWithCornerColors(Reader&, V3D_BOOL); \
+    template V3dBezierTriangleWithCornerColors::V3dBezierTriangleWithCornerColors(Reader&, V3D_BOOL); \
+    template V3dStraightPlanarQuad::V3dStraightPlanarQuad(Reader&, V3D_BOOL); \
+    template V3dStraightTriangle::V3dStraightTriangle(Reader&, V3D_BOOL); \
+    template V3dStraightPlanarQuadWithCornerColors::V3dStraightPlanarQuadWithCornerColors(Reader&, V3D_BOOL); \
+    template V3dStraightTriangleWithCornerColors::V3dStraightTriangleWithCornerColors(Reader&, V3D_BOOL); \
+    template V3dTriangleGroup::V3dTriangleGroup(Reader&, V3D_BOOL); \
+    template V3dSphere::V3dSphere(Reader&, V3D_BOOL); \
+    template V3dHemiSphere::V3dHemiSphere(Reader&, V3D_BOOL); \
+    template V3dDisk::V3dDisk(Reader&, V3D_BOOL); \
+    template V3dCylinder::V3dCylinder(Reader&, V3D_BOOL); \
+    template V3dTube::V3dTube(Reader&, V3D_BOOL); \
+    template V3dBezierCurve::V3dBezierCurve(Reader&, V3D_BOOL); \
+    template V3dLineSegment::V3dLineSegment(Reader&, V3D_BOOL); \
+    template V3dPixel::V3dPixel(Reader&, V3D_BOOL);
+
+INSTANTIATE_V3D_OBJECT_READERS(xdr::ixstream)
+INSTANTIATE_V3D_OBJECT_READERS(XdrReader)
@@ -4,8 +4,12 @@
 #include <vector>
 #include <memory>
 #include <array>
+#include <optional>
 
 #include "V3dObject.h"
+#include "BezierPatchTessellator.h"
+#include "V3dInstances.h"
+#include "VertexWelder.h"
 #include "xstream.h"
 
 enum ObjectTypes {
@@ -49,6 +53,10 @@ enum ObjectTypes {
     PIXEL = 4096
 };
 
+// Bezier surfaces only hand out a descriptor, meshing is deferred until the whole file is parsed so all surfaces can be
+// tessellated in parallel. Spheres, hemispheres, disks and cylinders hand out an instance and are drawn by instancing a
+// shared unit mesh instead of through vertex data.
+
 struct V3dMaterial {
     RGBA diffuse;
     RGBA emissive;
@@ -60,32 +68,40 @@ struct V3dMaterial {
 
 class V3dBezierPatch : public V3dObject {
 public:
+    template<typename Reader>
     V3dBezierPatch(
-        xdr::ixstream& xdrFile, 
+        Reader& xdrFile, 
         V3D_BOOL doublePrecision);
     ~V3dBezierPatch() override = default;
 
     std::vector<float> getVertexData() override;
     std::vector<unsigned int> getIndices() override;
+    size_t memoryUsage() const override { return sizeof(*this); }
+
+    // The tolerance follows the patch's projected size in view
+    BezierPatchDescriptor descriptor(const TessellationView& view) const;
+    // Meshes this patch on its own, outside of a batch
+    MeshBuffer tessellate(const TessellationView& view) const;
 
     std::array<TRIPLE, 16> controlPoints;
     UINT centerIndex;
     UINT materialIndex;
-
-private:
-    std::vector<float> m_Vertices{ };
-    std::vector<unsigned int> m_Indices{ };
 };
 
 class V3dBezierTriangle : public V3dObject {
 public:
+    template<typename Reader>
     V3dBezierTriangle(
-        xdr::ixstream& xdrFile, 
+        Reader& xdrFile, 
         V3D_BOOL doublePrecision);
     ~V3dBezierTriangle() override = default;
 
     std::vector<float> getVertexData() override;
     std::vector<unsigned int> getIndices() override;
+    size_t memoryUsage() const override { return sizeof(*this); }
+
+    // Meshed by the patch tessellator in its triangular mode
+    BezierPatchDescriptor descriptor(const TessellationView& view) const;
 
     std::array<TRIPLE, 10> controlPoints;
     UINT centerIndex;
@@ -94,13 +110,18 @@ public:
 
 class V3dBezierPatchWithCornerColors : public V3dObject {
 public:
+    template<typename Reader>
     V3dBezierPatchWithCornerColors(
-        xdr::ixstream& xdrFile, 
+        Reader& xdrFile, 
         V3D_BOOL doublePrecision);
     ~V3dBezierPatchWithCornerColors() override = default;
 
     std::vector<float> getVertexData() override;
     std::vector<unsigned int> getIndices() override;
+    size_t memoryUsage() const override { return sizeof(*this); }
+
+    // Carries the corner colors, which are interpolated bilinearly across the mesh
+    BezierPatchDescriptor descriptor(const TessellationView& view) const;
 
     std::array<TRIPLE, 16> controlPoints;
     UINT centerIndex;
@@ -110,13 +131,18 @@ public:
 
 class V3dBezierTriangleWithCornerColors : public V3dObject {
 public:
+    template<typename Reader>
     V3dBezierTriangleWithCornerColors(
-        xdr::ixstream& xdrFile, 
+        Reader& xdrFile, 
         V3D_BOOL doublePrecision);
     ~V3dBezierTriangleWithCornerColors() override = default;
 
     std::vector<float> getVertexData() override;
     std::vector<unsigned int> getIndices() override;
+    size_t memoryUsage() const override { return sizeof(*this); }
+
+    // Carries the three corner colors, the descriptor's fourth color slot stays unused
+    BezierPatchDescriptor descriptor(const TessellationView& view) const;
 
     std::array<TRIPLE, 10> controlPoints;
     UINT centerIndex;
@@ -126,13 +152,20 @@ public:
 
 class V3dStraightPlanarQuad : public V3dObject {
 public:
+    template<typename Reader>
     V3dStraightPlanarQuad(
-        xdr::ixstream& xdrFile, 
+        Reader& xdrFile, 
         V3D_BOOL doublePrecision);
     ~V3dStraightPlanarQuad() override = default;
 
     std::vector<float> getVertexData() override;
     std::vector<unsigned int> getIndices() override;
+    size_t memoryUsage() const override { return sizeof(*this); }
+
+    size_t vertexCount() override;
+    size_t indexCount() override;
+    void writeVertices(float* out) override;
+    void writeIndices(unsigned int* out, unsigned int base) override;
 
     std::array<TRIPLE, 4> vertices;
     UINT centerIndex;
@@ -141,13 +174,20 @@ public:
 
 class V3dStraightTriangle : public V3dObject {
 public:
+    template<typename Reader>
     V3dStraightTriangle(
-        xdr::ixstream& xdrFile, 
+        Reader& xdrFile, 
         V3D_BOOL doublePrecision);
     ~V3dStraightTriangle() override = default;
 
     std::vector<float> getVertexData() override;
     std::vector<unsigned int> getIndices() override;
+    size_t memoryUsage() const override { return sizeof(*this); }
+
+    size_t vertexCount() override;
+    size_t indexCount() override;
+    void writeVertices(float* out) override;
+    void writeIndices(unsigned int* out, unsigned int base) override;
 
     std::array<TRIPLE, 3> vertices;
     UINT centerIndex;
@@ -156,13 +196,23 @@ public:
 
 class V3dStraightPlanarQuadWithCornerColors : public V3dObject {
 public:
+    template<typename Reader>
     V3dStraightPlanarQuadWithCornerColors(
-        xdr::ixstream& xdrFile, 
+        Reader& xdrFile, 
         V3D_BOOL doublePrecision);
     ~V3dStraightPlanarQuadWithCornerColors() override = default;
 
     std::vector<float> getVertexData() override;
     std::vector<unsigned int> getIndices() override;
+    std::vector<uint32_t> getColors() override;
+    size_t memoryUsage() const override { return sizeof(*this); }
+
+    size_t vertexCount() override;
+    size_t indexCount() override;
+    void writeVertices(float* out) override;
+    void writeIndices(unsigned int* out, unsigned int base) override;
+    bool hasColors() override;
+    void writeColors(uint32_t* out) override;
 
     std::array<TRIPLE, 4> vertices;
     UINT centerIndex;
@@ -172,13 +222,23 @@ public:
 
 class V3dStraightTriangleWithCornerColors : public V3dObject {
 public:
+    template<typename Reader>
     V3dStraightTriangleWithCornerColors(
-        xdr::ixstream& xdrFile, 
+        Reader& xdrFile, 
         V3D_BOOL doublePrecision);
     ~V3dStraightTriangleWithCornerColors() override = default;
 
     std::vector<float> getVertexData() override;
     std::vector<unsigned int> getIndices() override;
+    std::vector<uint32_t> getColors() override;
+    size_t memoryUsage() const override { return sizeof(*this); }
+
+    size_t vertexCount() override;
+    size_t indexCount() override;
+    void writeVertices(float* out) override;
+    void writeIndices(unsigned int* out, unsigned int base) override;
+    bool hasColors() override;
+    void writeColors(uint32_t* out) override;
 
     std::array<TRIPLE, 3> vertices;
     UINT centerIndex;
@@ -188,13 +248,23 @@ public:
 
 class V3dTriangleGroup : public V3dObject {
 public:
+    template<typename Reader>
     V3dTriangleGroup(
-        xdr::ixstream& xdrFile, 
+        Reader& xdrFile, 
         V3D_BOOL doublePrecision);
     ~V3dTriangleGroup() override = default;
 
     std::vector<float> getVertexData() override;
     std::vector<unsigned int> getIndices() override;
+    std::vector<uint32_t> getColors() override;
+    size_t memoryUsage() const override;
+
+    size_t vertexCount() override;
+    size_t indexCount() override;
+    void writeVertices(float* out) override;
+    void writeIndices(unsigned int* out, unsigned int base) override;
+    bool hasColors() override;
+    void writeColors(uint32_t* out) override;
 
     UINT nI;
     UINT nP;
@@ -212,17 +282,28 @@ public:
 
     UINT centerIndex;
     UINT materialIndex;
+
+private:
+    // Vertices are the distinct (position, normal, color) index tuples, computed once for all three getters
+    const WeldedTriangles& welded();
+
+    std::optional<WeldedTriangles> m_Welded;
 };
 
 class V3dSphere : public V3dObject {
 public:
+    template<typename Reader>
     V3dSphere(
-        xdr::ixstream& xdrFile, 
+        Reader& xdrFile, 
         V3D_BOOL doublePrecision);
     ~V3dSphere() override = default;
 
     std::vector<float> getVertexData() override;
     std::vector<unsigned int> getIndices() override;
+    size_t memoryUsage() const override { return sizeof(*this); }
+
+    // Scaled uniformly by radius, without rotation
+    PrimitiveInstance instance() const;
 
     TRIPLE center;
     REAL radius;
@@ -232,13 +313,18 @@ public:
 
 class V3dHemiSphere : public V3dObject {
 public:
+    template<typename Reader>
     V3dHemiSphere(
-        xdr::ixstream& xdrFile, 
+        Reader& xdrFile, 
         V3D_BOOL doublePrecision);
     ~V3dHemiSphere() override = default;
 
     std::vector<float> getVertexData() override;
     std::vector<unsigned int> getIndices() override;
+    size_t memoryUsage() const override { return sizeof(*this); }
+
+    // Scaled by radius and turned so its pole follows the polar and azimuthal angles
+    PrimitiveInstance instance() const;
 
     TRIPLE center;
     REAL radius;
@@ -250,13 +336,18 @@ public:
 
 class V3dDisk : public V3dObject {
 public:
+    template<typename Reader>
     V3dDisk(
-        xdr::ixstream& xdrFile, 
+        Reader& xdrFile, 
         V3D_BOOL doublePrecision);
     ~V3dDisk() override = default;
 
     std::vector<float> getVertexData() override;
     std::vector<unsigned int> getIndices() override;
+    size_t memoryUsage() const override { return sizeof(*this); }
+
+    // Scaled by radius and turned so its normal follows the polar and azimuthal angles
+    PrimitiveInstance instance() const;
 
     TRIPLE center;
     REAL radius;
@@ -268,13 +359,18 @@ public:
 
 class V3dCylinder : public V3dObject {
 public:
+    template<typename Reader>
     V3dCylinder(
-        xdr::ixstream& xdrFile, 
+        Reader& xdrFile, 
         V3D_BOOL doublePrecision);
     ~V3dCylinder() override = default;
 
     std::vector<float> getVertexData() override;
     std::vector<unsigned int> getIndices() override;
+    size_t memoryUsage() const override { return sizeof(*this); }
+
+    // Scaled by radius across and by height along the axis given by the polar and azimuthal angles
+    PrimitiveInstance instance() const;
 
     TRIPLE center;
     REAL radius;
@@ -287,13 +383,15 @@ public:
 
 class V3dTube : public V3dObject {
 public:
+    template<typename Reader>
     V3dTube(
-        xdr::ixstream& xdrFile, 
+        Reader& xdrFile, 
         V3D_BOOL doublePrecision);
     ~V3dTube() override = default;
 
     std::vector<float> getVertexData() override;
     std::vector<unsigned int> getIndices() override;
+    size_t memoryUsage() const override { return sizeof(*this); }
 
     std::array<TRIPLE, 4> controlPoints;
     REAL width;
@@ -304,13 +402,15 @@ public:
 
 class V3dBezierCurve : public V3dObject {
 public:
+    template<typename Reader>
     V3dBezierCurve(
-        xdr::ixstream& xdrFile, 
+        Reader& xdrFile, 
         V3D_BOOL doublePrecision);
     ~V3dBezierCurve() override = default;
 
     std::vector<float> getVertexData() override;
     std::vector<unsigned int> getIndices() override;
+    size_t memoryUsage() const override { return sizeof(*this); }
 
     std::array<TRIPLE, 4> controlPoints;
     UINT centerIndex;
@@ -319,13 +419,15 @@ public:
 
 class V3dLineSegment : public V3dObject {
 public:
+    template<typename Reader>
     V3dLineSegment(
-        xdr::ixstream& xdrFile, 
+        Reader& xdrFile, 
         V3D_BOOL doublePrecision);
     ~V3dLineSegment() override = default;
 
     std::vector<float> getVertexData() override;
     std::vector<unsigned int> getIndices() override;
+    size_t memoryUsage() const override { return sizeof(*this); }
 
     std::array<TRIPLE, 2> endpoints;
     UINT centerIndex;
@@ -334,13 +436,15 @@ public:
 
 class V3dPixel : public V3dObject {
 public:
+    template<typename Reader>
     V3dPixel(
-        xdr::ixstream& xdrFile, 
+        Reader& xdrFile, 
         V3D_BOOL doublePrecision);
     ~V3dPixel() override = default;
 
     std::vector<float> getVertexData() override;
     std::vector<unsigned int> getIndices() override;
+    size_t memoryUsage() const override { return sizeof(*this); }
 
     TRIPLE position;
     UINT centerIndex;
@@ -11,4 +11,22 @@ float readReal(xdr::ixstream& xdrFile, V3D_BOOL doublePrecision) {
     }
 
     return out;
-}
\ No newline at end of file
+}
+
+void readReals(xdr::ixstream& xdrFile, float* out, size_t count, V3D_BOOL doublePrecision) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = readReal(xdrFile, doublePrecision);
+    }
+}
+
+void readFloats(xdr::ixstream& xdrFile, float* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        xdrFile >> out[i];
+    }
+}
+
+void readUInts(xdr::ixstream& xdrFile, UINT* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        xdrFile >> out[i];
+    }
+}
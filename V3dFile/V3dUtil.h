@@ -1,6 +1,43 @@
 #pragma once
 
+#include <cstddef>
+
 #include "xstream.h"
 #include "V3dTypes.h"
+#include "XdrReader.h"
 
 float readReal(xdr::ixstream& xdrFile, V3D_BOOL doublePrecision);
+
+// Reads count reals into out, narrowing doubles when the file is double precision
+void readReals(xdr::ixstream& xdrFile, float* out, size_t count, V3D_BOOL doublePrecision);
+void readFloats(xdr::ixstream& xdrFile, float* out, size_t count);
+void readUInts(xdr::ixstream& xdrFile, UINT* out, size_t count);
+
+inline float readReal(XdrReader& xdrFile, V3D_BOOL doublePrecision) {
+    float out;
+    if (doublePrecision) {
+        double val;
+        xdrFile >> val;
+        out = static_cast<float>(val);
+    } else {
+        xdrFile >> out;
+    }
+
+    return out;
+}
+
+inline void readReals(XdrReader& xdrFile, float* out, size_t count, V3D_BOOL doublePrecision) {
+    if (doublePrecision) {
+        xdrFile.readDoubles(out, count);
+    } else {
+        xdrFile.readFloats(out, count);
+    }
+}
+
+inline void readFloats(XdrReader& xdrFile, float* out, size_t count) {
+    xdrFile.readFloats(out, count);
+}
+
+inline void readUInts(XdrReader& xdrFile, UINT* out, size_t count) {
+    xdrFile.readUInts(out, count);
+}
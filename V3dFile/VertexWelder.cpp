@@ -0,0 +1,62 @@
+#include "VertexWelder.h"
+
+#include <limits>
+
+namespace {
+
+constexpr unsigned int EMPTY_SLOT = std::numeric_limits<unsigned int>::max();
+
+// Murmur3 finalizer over the three indices, the table size is a power of two so the low bits must be well mixed
+uint32_t hashKey(const VertexKey& key) {
+    uint32_t h = key[0] * 0x9E3779B1u ^ key[1] * 0x85EBCA77u ^ key[2] * 0xC2B2AE3Du;
+
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+
+    return h;
+}
+
+}
+
+WeldedTriangles weldTriangles(
+    const std::vector<std::array<UINT, 3>>& positionIndices,
+    const std::vector<std::array<UINT, 3>>& normalIndices,
+    const std::vector<std::array<UINT, 3>>& colorIndices,
+    bool withColors) {
+    WeldedTriangles out;
+
+    size_t cornerCount = 3 * positionIndices.size();
+    out.indices.reserve(cornerCount);
+
+    // At most half full, so probe sequences stay short
+    size_t capacity = 16;
+    while (capacity < 2 * cornerCount) {
+        capacity *= 2;
+    }
+
+    std::vector<unsigned int> slots(capacity, EMPTY_SLOT);
+    size_t mask = capacity - 1;
+
+    for (size_t i = 0; i < positionIndices.size(); ++i) {
+        for (size_t k = 0; k < 3; ++k) {
+            VertexKey key{ positionIndices[i][k], normalIndices[i][k], withColors ? colorIndices[i][k] : 0 };
+
+            size_t slot = hashKey(key) & mask;
+            while (slots[slot] != EMPTY_SLOT && out.vertices[slots[slot]] != key) {
+                slot = (slot + 1) & mask;
+            }
+
+            if (slots[slot] == EMPTY_SLOT) {
+                slots[slot] = static_cast<unsigned int>(out.vertices.size());
+                out.vertices.push_back(key);
+            }
+
+            out.indices.push_back(slots[slot]);
+        }
+    }
+
+    return out;
+}
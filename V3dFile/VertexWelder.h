@@ -0,0 +1,23 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "V3dTypes.h"
+
+// Position, normal and color index of one output vertex
+using VertexKey = std::array<UINT, 3>;
+
+// Result of welding a triangle list with separate position, normal and color indices
+struct WeldedTriangles {
+    std::vector<VertexKey> vertices;    // Every distinct index tuple, in order of first use
+    std::vector<unsigned int> indices;  // Three per triangle, into vertices
+};
+
+// Merges the corners of the triangles that share all three indices into one vertex.
+// Without colors the color index is ignored. Corners are looked up in a flat open-addressing table.
+WeldedTriangles weldTriangles(
+    const std::vector<std::array<UINT, 3>>& positionIndices,
+    const std::vector<std::array<UINT, 3>>& normalIndices,
+    const std::vector<std::array<UINT, 3>>& colorIndices,
+    bool withColors);
@@ -0,0 +1,188 @@
+#include "XdrDecode.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define XDR_DECODE_SSE2 1
+    #include <immintrin.h>
+    #if defined(__GNUC__) || defined(__clang__)
+        // AVX2 is compiled per function and selected at runtime
+        #define XDR_DECODE_AVX2 1
+        #define XDR_DECODE_AVX2_TARGET __attribute__((target("avx2")))
+    #elif defined(__AVX2__)
+        #define XDR_DECODE_AVX2 1
+        #define XDR_DECODE_AVX2_TARGET
+    #endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+    #define XDR_DECODE_NEON 1
+    #include <arm_neon.h>
+#endif
+
+namespace {
+
+inline uint32_t load32(const unsigned char* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+inline uint64_t load64(const unsigned char* p) {
+    return (uint64_t(load32(p)) << 32) | uint64_t(load32(p + 4));
+}
+
+// Byte swaps count 32 bit words from in to out, both may be unaligned
+void swap32Scalar(const unsigned char* in, unsigned char* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t value = load32(in + 4 * i);
+        std::memcpy(out + 4 * i, &value, sizeof(value));
+    }
+}
+
+void decodeDoublesScalar(const unsigned char* in, float* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t bits = load64(in + 8 * i);
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        out[i] = static_cast<float>(value);
+    }
+}
+
+#if XDR_DECODE_AVX2
+
+bool hasAvx2() {
+#if defined(__GNUC__) || defined(__clang__)
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return true;
+#endif
+}
+
+XDR_DECODE_AVX2_TARGET size_t swap32Avx2(const unsigned char* in, unsigned char* out, size_t count) {
+    const __m256i mask = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 4 * i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4 * i), _mm256_shuffle_epi8(v, mask));
+    }
+    return i;
+}
+
+XDR_DECODE_AVX2_TARGET size_t decodeDoublesAvx2(const unsigned char* in, float* out, size_t count) {
+    const __m256i mask = _mm256_setr_epi8(
+        7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+        7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 8 * i));
+        __m256d d = _mm256_castsi256_pd(_mm256_shuffle_epi8(v, mask));
+        _mm_storeu_ps(out + i, _mm256_cvtpd_ps(d));
+    }
+    return i;
+}
+
+#endif
+
+#if XDR_DECODE_SSE2
+
+// SSE2 has no byte shuffle, swap the bytes of each 16 bit lane and then the lanes themselves
+inline __m128i swapBytes16(__m128i v) {
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+size_t swap32Sse2(const unsigned char* in, unsigned char* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = swapBytes16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 4 * i)));
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * i), v);
+    }
+    return i;
+}
+
+size_t decodeDoublesSse2(const unsigned char* in, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v0 = swapBytes16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 8 * i)));
+        __m128i v1 = swapBytes16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 8 * i + 16)));
+        v0 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v0, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+        v1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v1, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+        __m128 lo = _mm_cvtpd_ps(_mm_castsi128_pd(v0));
+        __m128 hi = _mm_cvtpd_ps(_mm_castsi128_pd(v1));
+        _mm_storeu_ps(out + i, _mm_movelh_ps(lo, hi));
+    }
+    return i;
+}
+
+#endif
+
+#if XDR_DECODE_NEON
+
+size_t swap32Neon(const unsigned char* in, unsigned char* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_u8(out + 4 * i, vrev32q_u8(vld1q_u8(in + 4 * i)));
+    }
+    return i;
+}
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+size_t decodeDoublesNeon(const unsigned char* in, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float64x2_t d0 = vreinterpretq_f64_u8(vrev64q_u8(vld1q_u8(in + 8 * i)));
+        float64x2_t d1 = vreinterpretq_f64_u8(vrev64q_u8(vld1q_u8(in + 8 * i + 16)));
+        vst1q_f32(out + i, vcombine_f32(vcvt_f32_f64(d0), vcvt_f32_f64(d1)));
+    }
+    return i;
+}
+#endif
+
+#endif
+
+void swap32(const unsigned char* in, unsigned char* out, size_t count) {
+    size_t done = 0;
+
+#if XDR_DECODE_AVX2
+    if (hasAvx2()) {
+        done = swap32Avx2(in, out, count);
+    }
+#endif
+#if XDR_DECODE_SSE2
+    done += swap32Sse2(in + 4 * done, out + 4 * done, count - done);
+#elif XDR_DECODE_NEON
+    done += swap32Neon(in + 4 * done, out + 4 * done, count - done);
+#endif
+
+    swap32Scalar(in + 4 * done, out + 4 * done, count - done);
+}
+
+}
+
+void decodeUInts(const unsigned char* in, uint32_t* out, size_t count) {
+    swap32(in, reinterpret_cast<unsigned char*>(out), count);
+}
+
+void decodeFloats(const unsigned char* in, float* out, size_t count) {
+    swap32(in, reinterpret_cast<unsigned char*>(out), count);
+}
+
+void decodeDoubles(const unsigned char* in, float* out, size_t count) {
+    size_t done = 0;
+
+#if XDR_DECODE_AVX2
+    if (hasAvx2()) {
+        done = decodeDoublesAvx2(in, out, count);
+    }
+#endif
+#if XDR_DECODE_SSE2
+    done += decodeDoublesSse2(in + 8 * done, out + done, count - done);
+#elif XDR_DECODE_NEON && (defined(__aarch64__) || defined(_M_ARM64))
+    done += decodeDoublesNeon(in + 8 * done, out + done, count - done);
+#endif
+
+    decodeDoublesScalar(in + 8 * done, out + done, count - done);
+}
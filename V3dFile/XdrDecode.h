@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Bulk conversion of big-endian XDR arrays into native values.
+// Uses AVX2, SSE2 or NEON byte shuffles where available and a scalar loop otherwise,
+// the input does not need to be aligned.
+void decodeUInts(const unsigned char* in, uint32_t* out, size_t count);
+void decodeFloats(const unsigned char* in, float* out, size_t count);
+
+// Decodes count doubles and narrows each one to float
+void decodeDoubles(const unsigned char* in, float* out, size_t count);
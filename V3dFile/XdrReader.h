@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include "XdrDecode.h"
+
+// Decodes big-endian XDR directly from a block of memory, such as a MappedFile.
+// Mirrors the operator>> interface of xdr::ixstream so the object parsers can be shared,
+// and adds bulk readers for the large contiguous arrays in a file.
+class XdrReader {
+public:
+    XdrReader(const unsigned char* data, size_t size)
+        : m_Data{ data }, m_Size{ size } { }
+
+    XdrReader& operator>>(uint32_t& value) {
+        if (reserve(sizeof(uint32_t))) {
+            value = load32(m_Data + m_Position);
+            m_Position += sizeof(uint32_t);
+        }
+        return *this;
+    }
+
+    XdrReader& operator>>(int32_t& value) {
+        uint32_t bits;
+        if (*this >> bits) {
+            value = static_cast<int32_t>(bits);
+        }
+        return *this;
+    }
+
+    XdrReader& operator>>(float& value) {
+        uint32_t bits;
+        if (*this >> bits) {
+            std::memcpy(&value, &bits, sizeof(float));
+        }
+        return *this;
+    }
+
+    XdrReader& operator>>(double& value) {
+        if (reserve(sizeof(uint64_t))) {
+            uint64_t bits = load64(m_Data + m_Position);
+            std::memcpy(&value, &bits, sizeof(double));
+            m_Position += sizeof(uint64_t);
+        }
+        return *this;
+    }
+
+    // Bulk readers, return false and leave the reader failed if the data runs out
+    bool readUInts(uint32_t* out, size_t count) {
+        if (!reserve(count * sizeof(uint32_t))) {
+            return false;
+        }
+
+        decodeUInts(m_Data + m_Position, out, count);
+        m_Position += count * sizeof(uint32_t);
+        return true;
+    }
+
+    bool readFloats(float* out, size_t count) {
+        if (!reserve(count * sizeof(uint32_t))) {
+            return false;
+        }
+
+        decodeFloats(m_Data + m_Position, out, count);
+        m_Position += count * sizeof(uint32_t);
+        return true;
+    }
+
+    // Reads count doubles, narrowing each one to float
+    bool readDoubles(float* out, size_t count) {
+        if (!reserve(count * sizeof(uint64_t))) {
+            return false;
+        }
+
+        decodeDoubles(m_Data + m_Position, out, count);
+        m_Position += count * sizeof(uint64_t);
+        return true;
+    }
+
+    explicit operator bool() const { return !m_Failed; }
+
+    // Only here to match xdr::ixstream, the memory is owned by the caller
+    void close() { }
+
+    size_t remaining() const { return m_Size - m_Position; }
+
+private:
+    bool reserve(size_t bytes) {
+        if (m_Failed || remaining() < bytes) {
+            m_Failed = true;
+            m_Position = m_Size;
+            return false;
+        }
+        return true;
+    }
+
+    // Compilers turn these into a single load and byte swap
+    static uint32_t load32(const unsigned char* p) {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+    }
+
+    static uint64_t load64(const unsigned char* p) {
+        return (uint64_t(load32(p)) << 32) | uint64_t(load32(p + 4));
+    }
+
+    const unsigned char* m_Data;
+    size_t m_Size;
+    size_t m_Position{ 0 };
+    bool m_Failed{ false };
+};
@@ -4,12 +4,26 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "Utility/Arcball.h"
+#include "Utility/ThreadPool.h"
+#include "V3dFile/MeshSimplifier.h"
 #include "xstream.h"
 
+namespace {
+
+// The viewer only draws the buffers, so the parsed objects are dropped and the mesh is ordered for the GPU
+V3dLoadOptions viewerLoadOptions() {
+    V3dLoadOptions options;
+    options.keepObjects = false;
+    options.optimizeMeshes = true;
+    return options;
+}
+
+}
+
 V3dModel::V3dModel(const std::string& filePath, const glm::vec2& minBound, const glm::vec2& maxBound) 
     : minBound(minBound), maxBound(maxBound) {
         
-    file = std::make_unique<V3dFile>(filePath);
+    file = std::make_unique<V3dFile>(filePath, viewerLoadOptions());
 
     initProjection();
 }
@@ -18,7 +32,7 @@ V3dModel::V3dModel(const std::string& filePath, const glm::vec2& minBound, const
 V3dModel::V3dModel(xdr::memixstream& xdrFile, const glm::vec2& minBound, const glm::vec2& maxBound) 
     : minBound(minBound), maxBound(maxBound) {
 
-    file = std::make_unique<V3dFile>(xdrFile);
+    file = std::make_unique<V3dFile>(xdrFile, viewerLoadOptions());
 
     initProjection();
 }
@@ -51,6 +65,9 @@ void V3dModel::setProjection(const glm::vec2& displayDimensions) {
         projectionMatrix = glm::frustumRH_ZO(viewParam.minValues.x, viewParam.maxValues.x, viewParam.minValues.y, viewParam.maxValues.y, -viewParam.maxValues.z, -viewParam.minValues.z);
     }
 
+    // Vulkan's framebuffer Y axis points down, flipping here lets the rendered rows be copied out top to bottom
+    projectionMatrix = glm::scale(glm::mat4{ 1.0f }, glm::vec3{ 1.0f, -1.0f, 1.0f }) * projectionMatrix;
+
     updateViewMatrix();
 }
 
@@ -113,6 +130,127 @@ void V3dModel::updateViewMatrix() {
     m_HasChanged = true;
 }
 
+TessellationView V3dModel::tessellationView(const glm::vec2& targetSize) const {
+    return tessellationViewForBounds(viewParam.minValues, viewParam.maxValues, targetSize.x, targetSize.y, file->headerInfo.orthographic);
+}
+
+float V3dModel::pixelSize(const glm::vec2& targetSize) const {
+    return tessellationView(targetSize).pixelSize;
+}
+
+bool V3dModel::pick(const glm::vec2& normalizedPosition, BvhHit& hit) {
+    if (!m_Bvh) {
+        m_Bvh = std::make_unique<SceneBvh>(file->mesh->vertices, file->mesh->indices, file->instances, ThreadPool::shared());
+    }
+
+    // The projection already flips y to point down like the page, depth runs from 0 at the near plane to 1 at the far one
+    glm::mat4 inverse = glm::inverse(projectionMatrix * viewMatrix);
+    glm::vec2 clip = 2.0f * normalizedPosition - 1.0f;
+
+    glm::vec4 nearPoint = inverse * glm::vec4{ clip, 0.0f, 1.0f };
+    glm::vec4 farPoint = inverse * glm::vec4{ clip, 1.0f, 1.0f };
+
+    glm::vec3 origin = glm::vec3{ nearPoint } / nearPoint.w;
+    glm::vec3 direction = glm::vec3{ farPoint } / farPoint.w - origin;
+
+    return m_Bvh->intersectRay(origin, direction, 1.0f, hit);
+}
+
+bool V3dModel::updateTessellation(const glm::vec2& targetSize, std::function<void()> onReady) {
+    if (!file->hasAdaptiveGeometry()) {
+        return false;
+    }
+
+    bool remeshed = false;
+
+    if (m_RemeshResult.valid()) {
+        if (m_RemeshResult.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            // The current mesh stays in use until the new one is done
+            return false;
+        }
+
+        RemeshResult result = m_RemeshResult.get();
+
+        file->mesh = std::make_shared<const MeshBuffer>(std::move(result.triangles));
+        file->lineVertices = std::move(result.lines.vertices);
+        file->lineIndices = std::move(result.lines.indices);
+        file->tessellationView = result.view;
+
+        m_Bvh.reset();
+        ++m_MeshGeneration;
+        m_InteractiveLod = 0;
+        remeshed = true;
+    }
+
+    TessellationView view = tessellationView(targetSize);
+
+    float ratio = view.pixelSize / file->tessellationView.pixelSize;
+
+    if (!std::isfinite(ratio) || ratio <= 0.0f || (ratio < REMESH_THRESHOLD && ratio > 1.0f / REMESH_THRESHOLD)) {
+        return remeshed;
+    }
+
+    auto promise = std::make_shared<std::promise<RemeshResult>>();
+    m_RemeshResult = promise->get_future();
+
+    const V3dFile* source = file.get();
+
+    m_RemeshTask = std::async(std::launch::async, [source, view, promise, onReady = std::move(onReady)]() {
+        RemeshResult result{ view, { }, { } };
+        source->buildMesh(view, result.triangles, result.lines);
+
+        promise->set_value(std::move(result));
+
+        if (onReady) {
+            onReady();
+        }
+    });
+
+    return remeshed;
+}
+
+bool V3dModel::updateLods(std::function<void()> onReady, std::vector<std::vector<unsigned int>>& lods) {
+    if (m_LodResult.valid()) {
+        if (m_LodResult.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return false;
+        }
+
+        std::vector<std::vector<unsigned int>> levels = m_LodResult.get();
+
+        if (m_LodGeneration == m_MeshGeneration) {
+            m_InteractiveLod = static_cast<uint32_t>(levels.size());
+            lods = std::move(levels);
+
+            return !lods.empty();
+        }
+
+        // Built for a mesh that was re-meshed since, start over
+    }
+
+    if (m_LodGeneration == m_MeshGeneration) {
+        return false;
+    }
+
+    m_LodGeneration = m_MeshGeneration;
+
+    if (file->mesh->indices.size() / 3 <= INTERACTIVE_TRIANGLE_BUDGET) {
+        return false;
+    }
+
+    auto promise = std::make_shared<std::promise<std::vector<std::vector<unsigned int>>>>();
+    m_LodResult = promise->get_future();
+
+    m_LodTask = std::async(std::launch::async, [mesh = file->mesh, promise, onReady = std::move(onReady)]() {
+        promise->set_value(buildLodChain(mesh->vertices, mesh->indices, INTERACTIVE_TRIANGLE_BUDGET));
+
+        if (onReady) {
+            onReady();
+        }
+    });
+
+    return false;
+}
+
 void V3dModel::dragModeShift(const glm::vec2& normalizedMousePosition, const glm::vec2& lastNormalizedMousePosition, const glm::vec2& displayDimensions) {
     float zoomInv = 1 / zoom;
     shift.x += (normalizedMousePosition.x - lastNormalizedMousePosition.x) * zoomInv * (displayDimensions.x / 2.0f);
@@ -1,6 +1,12 @@
 #pragma once
 
+#include <future>
+#include <limits>
+#include <functional>
+
 #include "V3dFile/V3dFile.h"
+#include "V3dFile/SceneBvh.h"
+#include "Rendering/GeometryHandle.h"
 
 struct V3dModel {
     friend class V3dModelManager;
@@ -19,6 +25,26 @@ struct V3dModel {
     void setDimensions(float width, float height, float X, float Y);
     void updateViewMatrix();
 
+    // Call after setProjection. Starts re-meshing the Bezier patches and tubes in the background once the size of a pixel
+    // has drifted too far from the one the current mesh was built for, onReady is called from the worker when done.
+    // Returns true when a finished mesh was swapped into file, the geometry then has to be uploaded again.
+    bool updateTessellation(const glm::vec2& targetSize, std::function<void()> onReady);
+
+    // Starts simplifying a mesh too large to drag smoothly in the background, after load and after every re-mesh, onReady
+    // is called from the worker when done. Returns true when a finished chain of levels for the current mesh was moved
+    // into lods, they then have to be uploaded.
+    bool updateLods(std::function<void()> onReady, std::vector<std::vector<unsigned int>>& lods);
+
+    // Level of detail to draw while the model is dragged, 0 for the full mesh
+    uint32_t interactiveLod() const { return m_InteractiveLod; }
+
+    // Size of a pixel in model units at the front of the model, call after setProjection
+    float pixelSize(const glm::vec2& targetSize) const;
+
+    // Nearest primitive under a point of the model's rectangle, given in [0, 1] from its top left corner. The hierarchy
+    // over the current mesh is built on first use and after every re-mesh, call after setProjection.
+    bool pick(const glm::vec2& normalizedPosition, BvhHit& hit);
+
     void dragModeShift  (const glm::vec2& normalizedMousePosition, const glm::vec2& lastNormalizedMousePosition, const glm::vec2& pageViewSize);
     void dragModeZoom   (const glm::vec2& normalizedMousePosition, const glm::vec2& lastNormalizedMousePosition, const glm::vec2& pageViewSize);
     void dragModePan    (const glm::vec2& normalizedMousePosition, const glm::vec2& lastNormalizedMousePosition, const glm::vec2& pageViewSize);
@@ -48,6 +74,39 @@ struct V3dModel {
 
     std::unique_ptr<V3dFile> file{ };
 
+    // GPU copy of the file's triangles, instances, lines and points, uploaded on first render and freed with the model
+    GeometryHandle geometry{ };
+
 private:
+    TessellationView tessellationView(const glm::vec2& targetSize) const;
+
     bool m_HasChanged{ true };
+
+    // Hierarchy pick() queries, built on demand over the current mesh
+    std::unique_ptr<SceneBvh> m_Bvh{ };
+
+    // Factor the pixel size may change by, in either direction, before the patches are re-meshed
+    static constexpr float REMESH_THRESHOLD = 2.0f;
+
+    struct RemeshResult {
+        TessellationView view;
+        MeshBuffer triangles;
+        MeshBuffer lines;
+    };
+
+    // Declared after file, the worker reads from it until m_RemeshTask is destroyed
+    std::future<RemeshResult> m_RemeshResult{ };
+    std::future<void> m_RemeshTask{ };
+
+    // Meshes with more triangles are simplified down to about this many for dragging
+    static constexpr size_t INTERACTIVE_TRIANGLE_BUDGET = 1 << 18;
+
+    // Counts the meshes swapped into file, simplified levels are only used with the mesh they were built from
+    uint64_t m_MeshGeneration{ 0 };
+    uint64_t m_LodGeneration{ std::numeric_limits<uint64_t>::max() };
+    uint32_t m_InteractiveLod{ 0 };
+
+    // The worker keeps the mesh it simplifies alive, file may swap in a re-meshed one in the meantime
+    std::future<std::vector<std::vector<unsigned int>>> m_LodResult{ };
+    std::future<void> m_LodTask{ };
 };
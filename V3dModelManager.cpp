@@ -14,6 +14,9 @@
 #include "Utility/ApplicationEventFilter.h"
 #include "Utility/ProtectedFunctionCaller.h"
 
+// Meshes with at least this many vertices are uploaded quantized, smaller ones are not worth the loss in precision
+constexpr size_t COMPACT_VERTEX_THRESHOLD = 1 << 16;
+
 bool fileExists(const std::string& path) {
     std::ifstream f{ path.c_str() };
     return f.good();
@@ -34,7 +37,7 @@ V3dModelManager::V3dModelManager(const Okular::Document* document)
     std::string shaderPath = "";
 
     for (const auto& path : shaderSearchPaths) {
-        if (fileExists(path + "vertex.spv") && fileExists(path + "fragment.spv")) {
+        if (fileExists(path + "vertex.spv") && fileExists(path + "colorVertex.spv") && fileExists(path + "compactVertex.spv") && fileExists(path + "compactColorVertex.spv") && fileExists(path + "instanceVertex.spv") && fileExists(path + "pointVertex.spv") && fileExists(path + "fragment.spv")) {
             shaderPath = path;
             break;
         }
@@ -65,6 +68,9 @@ void V3dModelManager::AddModel(V3dModel model, size_t pageNumber) {
 
     m_ModelImages.resize(pageNumber + 1);
     m_ModelImages[pageNumber].push_back(QImage{ });
+
+    m_PendingFrames.resize(pageNumber + 1);
+    m_PendingFrames[pageNumber].push_back(std::nullopt);
 }
 
 QImage V3dModelManager::RenderModel(size_t pageNumber, size_t modelIndex, int width, int height) {
@@ -75,10 +81,9 @@ QImage V3dModelManager::RenderModel(size_t pageNumber, size_t modelIndex, int wi
         return m_ModelImages[pageNumber][modelIndex];
     }
 
-    std::vector<float> vertices = m_Models[pageNumber][modelIndex].file->vertices;
-    std::vector<unsigned int> indices = m_Models[pageNumber][modelIndex].file->indices;
-    
-    if (vertices.empty() || indices.empty()) {
+    V3dModel& v3dModel = m_Models[pageNumber][modelIndex];
+
+    if (!v3dModel.file->hasGeometry()) {
         QImage image{ width, height, QImage::Format_ARGB32 };
 
         image.fill(Qt::black);
@@ -86,8 +91,6 @@ QImage V3dModelManager::RenderModel(size_t pageNumber, size_t modelIndex, int wi
         return image;
     }
 
-    VkSubresourceLayout imageSubresourceLayout;
-
     // Model
     glm::mat4 model = glm::mat4{ 1.0f };
 
@@ -99,35 +102,63 @@ QImage V3dModelManager::RenderModel(size_t pageNumber, size_t modelIndex, int wi
 
     m_Models[pageNumber][modelIndex].setProjection(canvasSize);
 
-	glm::mat4 mvp = m_Models[pageNumber][modelIndex].projectionMatrix * m_Models[pageNumber][modelIndex].viewMatrix * model;
-
-    unsigned char* imageData = m_HeadlessRenderer->render(width, height, &imageSubresourceLayout, vertices, indices, mvp);
+    std::weak_ptr<bool> lifetime = m_Lifetime;
 
-    unsigned char* imgDataTmp = imageData;
+    std::function<void()> onReady = [this, lifetime, pageNumber, modelIndex]() {
+        // Runs on a worker thread, the refresh has to happen on the GUI thread
+        QMetaObject::invokeMethod(qApp, [this, lifetime, pageNumber, modelIndex]() {
+            if (lifetime.expired()) {
+                return;
+            }
 
-    size_t finalImageSize = width * height * 4;
+            m_Models[pageNumber][modelIndex].m_HasChanged = true;
+            refreshPixmap(pageNumber);
+        }, Qt::QueuedConnection);
+    };
 
-    std::vector<unsigned char> vectorData;
-    vectorData.reserve(finalImageSize);
+    bool remeshed = v3dModel.updateTessellation({ width, height }, onReady);
 
-    for (int32_t y = 0; y < height; y++) {
-        unsigned int *row = (unsigned int*)imgDataTmp;
-        size_t rowBytes = width * 4;
-    
-        vectorData.resize(vectorData.size() + rowBytes);
-        std::memcpy(vectorData.data() + vectorData.size() - rowBytes, (unsigned char*)row, rowBytes);
+    if (!v3dModel.geometry.valid() || remeshed) {
+        const MeshBuffer& mesh = *v3dModel.file->mesh;
+        v3dModel.geometry = m_HeadlessRenderer->uploadGeometry(mesh.vertices, mesh.indices, mesh.colors, v3dModel.file->instances,
+            v3dModel.file->lineVertices, v3dModel.file->lineIndices, v3dModel.file->pointVertices,
+            mesh.vertexCount() >= COMPACT_VERTEX_THRESHOLD ? VertexFormat::Compact : VertexFormat::Float);
+    }
 
-        imgDataTmp += imageSubresourceLayout.rowPitch;
+    std::vector<std::vector<unsigned int>> lods;
+    if (v3dModel.updateLods(onReady, lods)) {
+        m_HeadlessRenderer->uploadLods(v3dModel.geometry, lods);
     }
 
-    delete imageData;
+	glm::mat4 mvp = m_Models[pageNumber][modelIndex].projectionMatrix * m_Models[pageNumber][modelIndex].viewMatrix * model;
+    float pixelSize = v3dModel.pixelSize({ width, height });
+
+    QImage& image = m_ModelImages[pageNumber][modelIndex];
+    std::optional<HeadlessRenderer::FrameTicket>& pendingFrame = m_PendingFrames[pageNumber][modelIndex];
 
-    QImage image{ vectorData.data(), width, height, QImage::Format_ARGB32 };
+    if (image.width() != width || image.height() != height) {
+        image = QImage{ width, height, QImage::Format_ARGB32 };
+        pendingFrame.reset();
+    }
 
-    image = image.mirrored(false, true);
+    // The renderer writes straight into the image, the Y flip is part of the projection matrix
+    if (m_Dragging && &v3dModel == m_ActiveModel) {
+        // While dragging, the previous frame is read back while this one renders, at the cost of one frame of latency.
+        // Large meshes are drawn simplified until the mouse is released.
+        HeadlessRenderer::FrameTicket ticket = m_HeadlessRenderer->submitFrame(width, height, v3dModel.geometry, mvp, pixelSize, v3dModel.interactiveLod());
+
+        if (pendingFrame.has_value() && m_HeadlessRenderer->readFrame(*pendingFrame, image.bits(), image.bytesPerLine())) {
+            pendingFrame = ticket;
+        } else {
+            m_HeadlessRenderer->readFrame(ticket, image.bits(), image.bytesPerLine());
+            pendingFrame.reset();
+        }
+    } else {
+        pendingFrame.reset();
+        m_HeadlessRenderer->render(width, height, v3dModel.geometry, mvp, pixelSize, image.bits(), image.bytesPerLine());
+    }
 
     m_Models[pageNumber][modelIndex].m_HasChanged = false;
-    m_ModelImages[pageNumber][modelIndex] = image;
 
     return image;
 }
@@ -255,15 +286,27 @@ bool V3dModelManager::mouseButtonPressEvent(QMouseEvent* event) {
 
     glm::vec2 normalizedMousePositionOnPage = GetNormalizedPositionRelativeToPage(m_MousePosition, pageMouseIsOver);
 
-    V3dModel* modelMouseIsOver = nullptr;
+    std::vector<V3dModel*> modelsUnderMouse;
     for (auto& model : m_Models[pageMouseIsOver]) {
         bool horizontallyOnModel = normalizedMousePositionOnPage.x > model.minBound.x && normalizedMousePositionOnPage.x < model.maxBound.x;
         bool verticallyOnModel = normalizedMousePositionOnPage.y > model.minBound.y && normalizedMousePositionOnPage.y < model.maxBound.y;
 
-        if (!(horizontallyOnModel && verticallyOnModel)) continue; // Making the assumption no two models overlap
+        if (horizontallyOnModel && verticallyOnModel) {
+            modelsUnderMouse.push_back(&model);
+        }
+    }
 
-        modelMouseIsOver = &model;
-        break;
+    V3dModel* modelMouseIsOver = modelsUnderMouse.empty() ? nullptr : modelsUnderMouse.front();
+
+    // Where models overlap the press goes to the first one with a primitive under the mouse, the first rectangle otherwise
+    if (modelsUnderMouse.size() > 1) {
+        for (V3dModel* model : modelsUnderMouse) {
+            BvhHit hit;
+            if (model->pick((normalizedMousePositionOnPage - model->minBound) / (model->maxBound - model->minBound), hit)) {
+                modelMouseIsOver = model;
+                break;
+            }
+        }
     }
 
     if (modelMouseIsOver != nullptr) {
@@ -287,8 +330,15 @@ bool V3dModelManager::mouseButtonReleaseEvent(QMouseEvent* event) {
         return false;
     }
 
+    bool wasDragging = m_Dragging;
     m_Dragging = false;
 
+    if (wasDragging && m_ActiveModel != nullptr) {
+        // The last frame shown while dragging lags one frame behind and may be simplified, render the final view now
+        m_ActiveModel->m_HasChanged = true;
+        refreshPixmap(m_ActiveModelPage);
+    }
+
     return false;
 }
 
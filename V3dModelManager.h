@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 
 #include <QtGui/QMouseEvent>
 #include <QAbstractScrollArea>
@@ -98,10 +99,14 @@ private:
     void requestPixmapRefresh(size_t pageNumber);
     void refreshPixmap(size_t pageNumber);
 
+    // Declared before the models so that it outlives the geometry handles they own
+    std::unique_ptr<HeadlessRenderer> m_HeadlessRenderer;
+
     std::vector<std::vector<V3dModel>> m_Models;
     std::vector<std::vector<QImage>> m_ModelImages;
 
-    std::unique_ptr<HeadlessRenderer> m_HeadlessRenderer;
+    // Frame submitted for each model whose pixels have not been read back yet
+    std::vector<std::vector<std::optional<HeadlessRenderer::FrameTicket>>> m_PendingFrames;
 
     bool m_Dragging{ false };
 
@@ -125,4 +130,8 @@ private:
 
     V3dModel* m_ActiveModel{ nullptr };
     int m_ActiveModelPage{ -1};
+
+    // Expires with the manager, background work checks it before calling back into the manager.
+    // Declared last so it expires before the models wait for their workers.
+    std::shared_ptr<bool> m_Lifetime{ std::make_shared<bool>(true) };
 };
@@ -1,3 +1,11 @@
 #!/bin/bash
-glslc -fshader-stage=vertex   vertex.glsl    -o vertex.spv   
-glslc -fshader-stage=fragment fragment.glsl  -o fragment.spv 
+# The .spv files are build outputs and not committed, run this before installing the shaders
+set -e
+cd "$(dirname "$0")"
+glslc -fshader-stage=vertex   vertex.glsl         -o vertex.spv   
+glslc -fshader-stage=vertex   vertex.glsl         -o colorVertex.spv -DVERTEX_COLOR
+glslc -fshader-stage=vertex   vertex.glsl         -o compactVertex.spv -DCOMPACT_VERTICES
+glslc -fshader-stage=vertex   vertex.glsl         -o compactColorVertex.spv -DCOMPACT_VERTICES -DVERTEX_COLOR
+glslc -fshader-stage=vertex   instanceVertex.glsl -o instanceVertex.spv
+glslc -fshader-stage=vertex   pointVertex.glsl    -o pointVertex.spv
+glslc -fshader-stage=fragment fragment.glsl       -o fragment.spv 
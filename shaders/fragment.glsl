@@ -2,12 +2,13 @@
 
 layout (location = 0) in vec3 Normal;
 layout (location = 1) in vec3 FragPos;
+layout (location = 2) in vec4 Color;
 
 layout (location = 0) out vec4 outFragColor;
 
 void main() {
     vec3 lightColor = vec3(1.0, 1.0, 1.0);
-	vec3 objectColor = vec3(0.35, 0.67, 0.82);
+	vec3 objectColor = Color.rgb;
 	vec3 lightPos = vec3(50.0, 50.0, 50.0);
 	vec3 viewPos = vec3(0.0, 0.0, -10.0);
 	float specularStrength = 0.5;
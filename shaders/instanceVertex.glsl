@@ -0,0 +1,31 @@
+#version 450
+
+layout (location = 0) in vec3 inPos;
+layout (location = 1) in vec3 inNormal;
+
+// Per instance, rows of the 3x4 transform of the unit mesh
+layout (location = 2) in vec4 inTransform0;
+layout (location = 3) in vec4 inTransform1;
+layout (location = 4) in vec4 inTransform2;
+
+layout (location = 0) out vec3 Normal;
+layout (location = 1) out vec3 FragPos;
+layout (location = 2) out vec4 Color;
+
+layout(push_constant) uniform PushConsts {
+	mat4 mvp;
+} pushConsts;
+
+void main() {
+	mat4x3 transform = transpose(mat3x4(inTransform0, inTransform1, inTransform2));
+	mat3 linear = mat3(transform);
+
+	// The columns are orthogonal, a rotation times a scale, so dividing by their squared lengths gives the inverse transpose
+	vec3 normal = normalize(linear * (inNormal / vec3(dot(linear[0], linear[0]), dot(linear[1], linear[1]), dot(linear[2], linear[2]))));
+	vec3 position = transform * vec4(inPos, 1.0);
+
+	FragPos = position;
+	Color = vec4(0.35, 0.67, 0.82, 1.0);
+	Normal = normal * 0.5 + 0.5;
+	gl_Position = pushConsts.mvp * vec4(position, 1.0);
+}
@@ -0,0 +1,24 @@
+#version 450
+
+layout (location = 0) in vec3 inPos;
+layout (location = 1) in vec3 inNormal;
+
+layout (location = 0) out vec3 Normal;
+layout (location = 1) out vec3 FragPos;
+layout (location = 2) out vec4 Color;
+
+layout(push_constant) uniform PushConsts {
+	mat4 mvp;
+} pushConsts;
+
+// Size in pixels, clamped to the device's range by the renderer
+layout (constant_id = 0) const float pointSize = 1.0;
+
+void main() {
+	FragPos = inPos;
+	Color = vec4(0.35, 0.67, 0.82, 1.0);
+	Normal = inNormal * 0.5 + 0.5;
+
+	gl_PointSize = pointSize;
+	gl_Position = pushConsts.mvp * vec4(inPos, 1.0);
+}
@@ -1,20 +1,54 @@
 #version 450
 
+// Compiled with COMPACT_VERTICES defined for meshes uploaded as CompactVertex
+#ifdef COMPACT_VERTICES
+layout (location = 0) in vec4 inQuantizedPos;
+layout (location = 1) in vec2 inOctahedralNormal;
+#else
 layout (location = 0) in vec3 inPos;
 layout (location = 1) in vec3 inNormal;
+#endif
+
+// Compiled with VERTEX_COLOR defined for meshes that carry a color stream in binding 1
+#ifdef VERTEX_COLOR
+layout (location = 2) in vec4 inColor;
+#endif
 
 layout (location = 0) out vec3 Normal;
 layout (location = 1) out vec3 FragPos;
+layout (location = 2) out vec4 Color;
 
 layout(push_constant) uniform PushConsts {
 	mat4 mvp;
+	// Bounds of the quantized positions, only set for compact meshes
+	vec4 positionOffset;
+	vec4 positionScale;
 } pushConsts;
 
+#ifdef COMPACT_VERTICES
+vec3 decodeOctahedral(vec2 e) {
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+	return normalize(n);
+}
+#endif
+
 void main() {
+#ifdef COMPACT_VERTICES
+	vec3 inPos = pushConsts.positionOffset.xyz + inQuantizedPos.xyz * pushConsts.positionScale.xyz;
+	vec3 inNormal = decodeOctahedral(inOctahedralNormal);
+#endif
+
 	mat4 model = mat4(1.0);
 	FragPos = vec3(model * vec4(inPos.xyz, 1.0));
 
 	//Normal = vec3(pushConsts.mvp * vec4(inNormal, 1.0));
 	Normal = inNormal * 0.5 + 0.5;
+#ifdef VERTEX_COLOR
+	Color = inColor;
+#else
+	Color = vec4(0.35, 0.67, 0.82, 1.0);
+#endif
 	gl_Position = pushConsts.mvp * vec4(inPos.xyz, 1.0);
 }